@@ -0,0 +1,25 @@
+#############################################################
+#                                                           #
+#                 Qt CPU LIMIT - Core                       #
+#                                                           #
+#  Sampling and limiting logic shared by the application    #
+#  and the simulator, it only depends on Qt Core.           #
+#                                                           #
+#############################################################
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/QCpuTypes.h \
+    $$PWD/QCpuPlatform.h \
+    $$PWD/QCpuLimiter.h \
+    $$PWD/QCpuProcessTable.h \
+    $$PWD/QCpuScheduler.h \
+    $$PWD/QCpuStringPool.h
+
+SOURCES += \
+    $$PWD/QCpuPlatform.cpp \
+    $$PWD/QCpuLimiter.cpp \
+    $$PWD/QCpuProcessTable.cpp \
+    $$PWD/QCpuScheduler.cpp \
+    $$PWD/QCpuStringPool.cpp
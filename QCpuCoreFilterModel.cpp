@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuCoreFilterModel.h"
+
+/**
+ * @brief QCpuCoreFilterModel::QCpuCoreFilterModel
+ */
+QCpuCoreFilterModel::QCpuCoreFilterModel(QObject* parentPtr)
+    : QSortFilterProxyModel(parentPtr)
+{
+    //the CPU of a process changes with the updates of the model
+    setDynamicSortFilter(true);
+    setFilterRole(QCpuModel::Processor);
+}
+
+/**
+ * @brief QCpuCoreFilterModel::core
+ */
+int QCpuCoreFilterModel::core() const
+{
+    return m_core;
+}
+
+/**
+ * @brief QCpuCoreFilterModel::setCore
+ */
+void QCpuCoreFilterModel::setCore(int core)
+{
+    //nothing changed ?
+    if (m_core == core)
+    {
+        return;
+    }
+
+    //filter the rows again
+    m_core = core;
+    invalidateFilter();
+
+    //emit the signal
+    emit coreChanged();
+}
+
+/**
+ * @brief QCpuCoreFilterModel::filterAcceptsRow
+ */
+bool QCpuCoreFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+{
+    //no CPU selected: show every process
+    if (m_core < 0)
+    {
+        return true;
+    }
+
+    //show the processes that last ran on the selected CPU
+    const QModelIndex sourceIndex = sourceModel()->index(sourceRow, 0, sourceParent);
+    return sourceModel()->data(sourceIndex, filterRole()).toInt() == m_core;
+}
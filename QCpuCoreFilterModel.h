@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUCOREFILTERMODEL_H
+#define QCPUCOREFILTERMODEL_H
+
+#include <QSortFilterProxyModel>
+#include "QCpuModel.h"
+
+/**
+ * @brief QCpuCoreFilterModel class
+ *
+ * Shows the processes that last ran on one CPU, or all of them when no CPU is selected.
+ */
+class QCpuCoreFilterModel final : public QSortFilterProxyModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int core READ core WRITE setCore NOTIFY coreChanged)
+
+public:
+
+    explicit QCpuCoreFilterModel(QObject* parentPtr = nullptr);
+
+    int core() const;
+    void setCore(int core);
+
+signals:
+
+    void coreChanged();
+
+protected:
+
+    bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+
+private:
+
+    int m_core { -1 };
+};
+
+#endif // QCPUCOREFILTERMODEL_H
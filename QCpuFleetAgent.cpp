@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuFleetAgent.h"
+
+/**
+ * @brief QCpuFleetAgent::QCpuFleetAgent
+ */
+QCpuFleetAgent::QCpuFleetAgent(QCpuSource* cpuSourcePtr, const QCpuFleetAddress& address, const QString& hostName, QObject* parentPtr)
+    : QObject(parentPtr)
+    , m_cpuSourcePtr(cpuSourcePtr)
+    , m_stringPoolPtr(cpuSourcePtr->stringPool())
+    , m_address(address)
+    , m_hostName(hostName)
+{
+    //report the frame sizes?
+    m_profilingEnabled = qEnvironmentVariableIntValue("QTCPULIMIT_PROFILE") != 0;
+
+    //subscribe to the source like the model does
+    connect(m_cpuSourcePtr,
+            &QCpuSource::updateProcessList,
+            this,
+            &QCpuFleetAgent::updateProcessList,
+            Qt::QueuedConnection);
+
+    connect(m_cpuSourcePtr,
+            &QCpuSource::updateProcessMetadata,
+            this,
+            &QCpuFleetAgent::updateProcessMetadata,
+            Qt::QueuedConnection);
+
+    connect(m_cpuSourcePtr,
+            &QCpuSource::updateCpuLoadList,
+            this,
+            &QCpuFleetAgent::updateCpuLoadList,
+            Qt::QueuedConnection);
+
+    //create the socket
+    if (m_address.local)
+    {
+        QLocalSocket* localSocketPtr = new QLocalSocket(this);
+        connect(localSocketPtr, &QLocalSocket::connected, this, &QCpuFleetAgent::connected);
+        connect(localSocketPtr, &QLocalSocket::disconnected, this, &QCpuFleetAgent::disconnected);
+        connect(localSocketPtr, &QLocalSocket::errorOccurred, this, [this, localSocketPtr]()
+        {
+            //not connected yet: try again later
+            if (!m_connected)
+            {
+                localSocketPtr->abort();
+                m_timerReconnectPtr->start();
+            }
+        });
+        m_socketPtr = localSocketPtr;
+    }
+    else
+    {
+        QTcpSocket* tcpSocketPtr = new QTcpSocket(this);
+        tcpSocketPtr->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(tcpSocketPtr, &QTcpSocket::connected, this, &QCpuFleetAgent::connected);
+        connect(tcpSocketPtr, &QTcpSocket::disconnected, this, &QCpuFleetAgent::disconnected);
+        connect(tcpSocketPtr, &QTcpSocket::errorOccurred, this, [this, tcpSocketPtr]()
+        {
+            //not connected yet: try again later
+            if (!m_connected)
+            {
+                tcpSocketPtr->abort();
+                m_timerReconnectPtr->start();
+            }
+        });
+        m_socketPtr = tcpSocketPtr;
+    }
+
+    connect(m_socketPtr, &QIODevice::readyRead, this, &QCpuFleetAgent::readFrames);
+
+    //create the m_timerReconnectPtr timer
+    m_timerReconnectPtr = new QTimer(this);
+    m_timerReconnectPtr->setInterval(c_fleetReconnectIntervalInMs);
+    m_timerReconnectPtr->setSingleShot(true);
+    connect(m_timerReconnectPtr, &QTimer::timeout, this, &QCpuFleetAgent::connectToAggregator);
+
+    //connect now
+    connectToAggregator();
+}
+
+/**
+ * @brief QCpuFleetAgent::connectToAggregator
+ */
+void QCpuFleetAgent::connectToAggregator() noexcept
+{
+    if (m_address.local)
+    {
+        static_cast<QLocalSocket*>(m_socketPtr)->connectToServer(m_address.path);
+    }
+    else
+    {
+        static_cast<QTcpSocket*>(m_socketPtr)->connectToHost(m_address.host, m_address.port);
+    }
+}
+
+/**
+ * @brief QCpuFleetAgent::connected
+ */
+void QCpuFleetAgent::connected() noexcept
+{
+    qDebug() << "QCpuFleetAgent::connected: connected to the aggregator - host:" << m_hostName;
+
+    //the aggregator knows nothing about this host: the next frame carries every process
+    m_connected = true;
+    m_receiveBuffer.clear();
+    m_encoder.reset();
+
+    //introduce the host
+    QCpuFleetWriter writer;
+    writer.writeByte(c_fleetProtocolVersion);
+    writer.writeString(m_hostName);
+    send(writer.frame(QCpuFleetFrameType::Hello));
+}
+
+/**
+ * @brief QCpuFleetAgent::disconnected
+ */
+void QCpuFleetAgent::disconnected() noexcept
+{
+    qDebug() << "QCpuFleetAgent::disconnected: disconnected from the aggregator - host:" << m_hostName;
+
+    //try again later
+    m_connected = false;
+    m_timerReconnectPtr->start();
+}
+
+/**
+ * @brief QCpuFleetAgent::reconnect
+ */
+void QCpuFleetAgent::reconnect() noexcept
+{
+    //drop the connection and its pending data
+    m_connected = false;
+    m_receiveBuffer.clear();
+    if (m_address.local)
+    {
+        static_cast<QLocalSocket*>(m_socketPtr)->abort();
+    }
+    else
+    {
+        static_cast<QTcpSocket*>(m_socketPtr)->abort();
+    }
+
+    //try again later
+    m_timerReconnectPtr->start();
+}
+
+/**
+ * @brief QCpuFleetAgent::readFrames
+ */
+void QCpuFleetAgent::readFrames() noexcept
+{
+    m_receiveBuffer.append(m_socketPtr->readAll());
+
+    //process the complete frames
+    QCpuFleetFrameType type;
+    QByteArray payload;
+    bool error = false;
+    while (QCpuFleetReader::takeFrame(m_receiveBuffer, type, payload, error))
+    {
+        QCpuFleetReader reader(payload);
+        switch (type)
+        {
+            case QCpuFleetFrameType::MetadataRequest:
+                processPidRequest(reader, "requestProcessMetadata");
+                break;
+
+            case QCpuFleetFrameType::StatisticsRequest:
+                processPidRequest(reader, "requestProcessStatistics");
+                break;
+
+            case QCpuFleetFrameType::Command:
+                processCommand(reader);
+                break;
+
+            default:
+                qDebug() << "QCpuFleetAgent::readFrames: unexpected frame - type:" << static_cast<int>(type);
+                break;
+        }
+    }
+
+    //a broken stream can't be resynchronized: start again
+    if (error)
+    {
+        qDebug() << "QCpuFleetAgent::readFrames: invalid frame, reconnecting - host:" << m_hostName;
+        reconnect();
+    }
+}
+
+/**
+ * @brief QCpuFleetAgent::processPidRequest
+ */
+void QCpuFleetAgent::processPidRequest(QCpuFleetReader& reader, const char* method) noexcept
+{
+    //the pids, as deltas
+    PidList pidList;
+    const quint64 count = reader.readVarint();
+    pid_t pid = 0;
+    for (quint64 index = 0; index < count && reader.ok(); ++index)
+    {
+        pid += static_cast<pid_t>(reader.readVarint());
+        pidList.push_back(pid);
+    }
+
+    if (!reader.ok())
+    {
+        qDebug() << "QCpuFleetAgent::processPidRequest: invalid frame - method:" << method;
+        return;
+    }
+
+    //the metadata comes back through updateProcessMetadata, the statistics with the next samples
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              method,
+                              Qt::QueuedConnection,
+                              Q_ARG(PidList, pidList));
+}
+
+/**
+ * @brief QCpuFleetAgent::processCommand
+ */
+void QCpuFleetAgent::processCommand(QCpuFleetReader& reader) noexcept
+{
+    //[command][pid][value]
+    const QCpuFleetCommand command = static_cast<QCpuFleetCommand>(reader.readByte());
+    const pid_t pid = static_cast<pid_t>(reader.readVarint());
+    const quint64 value = reader.readVarint();
+    if (!reader.ok())
+    {
+        qDebug() << "QCpuFleetAgent::processCommand: invalid frame";
+        return;
+    }
+
+    //forward the command to the source, like the model does
+    switch (command)
+    {
+        case QCpuFleetCommand::SetCpuLimit:
+            QMetaObject::invokeMethod(m_cpuSourcePtr, "setProcessLimit", Qt::QueuedConnection,
+                                      Q_ARG(pid_t, pid), Q_ARG(int, static_cast<int>(value)));
+            break;
+
+        case QCpuFleetCommand::RemoveCpuLimit:
+            QMetaObject::invokeMethod(m_cpuSourcePtr, "removeProcessLimit", Qt::QueuedConnection,
+                                      Q_ARG(pid_t, pid));
+            break;
+
+        case QCpuFleetCommand::SetIoLimit:
+            QMetaObject::invokeMethod(m_cpuSourcePtr, "setProcessIoLimit", Qt::QueuedConnection,
+                                      Q_ARG(pid_t, pid), Q_ARG(qint64, static_cast<qint64>(value)));
+            break;
+
+        case QCpuFleetCommand::RemoveIoLimit:
+            QMetaObject::invokeMethod(m_cpuSourcePtr, "removeProcessIoLimit", Qt::QueuedConnection,
+                                      Q_ARG(pid_t, pid));
+            break;
+
+        case QCpuFleetCommand::SetSoftThrottling:
+            QMetaObject::invokeMethod(m_cpuSourcePtr, "setSoftThrottling", Qt::QueuedConnection,
+                                      Q_ARG(bool, value != 0));
+            break;
+
+        case QCpuFleetCommand::SetSampleSource:
+            QMetaObject::invokeMethod(m_cpuSourcePtr, "setSampleSource", Qt::QueuedConnection,
+                                      Q_ARG(int, static_cast<int>(value)));
+            break;
+
+        case QCpuFleetCommand::SetAutoProtection:
+            QMetaObject::invokeMethod(m_cpuSourcePtr, "setAutoProtection", Qt::QueuedConnection,
+                                      Q_ARG(bool, value != 0));
+            break;
+
+        case QCpuFleetCommand::SetExtendedStatistics:
+            QMetaObject::invokeMethod(m_cpuSourcePtr, "setExtendedStatistics", Qt::QueuedConnection,
+                                      Q_ARG(bool, value != 0));
+            break;
+
+        case QCpuFleetCommand::SetDescendantLimit:
+            QMetaObject::invokeMethod(m_cpuSourcePtr, "setDescendantLimit", Qt::QueuedConnection,
+                                      Q_ARG(int, static_cast<int>(value)));
+            break;
+
+        default:
+            qDebug() << "QCpuFleetAgent::processCommand: unknown command - command:" << static_cast<int>(command);
+            break;
+    }
+}
+
+/**
+ * @brief QCpuFleetAgent::updateProcessList
+ */
+void QCpuFleetAgent::updateProcessList(const QCpuProcessList& processList) noexcept
+{
+    //nobody to send to: the first frame after the connection carries every process anyway
+    if (!m_connected)
+    {
+        return;
+    }
+
+    //send the changes since the previous frame
+    const QByteArray frame = m_encoder.encode(processList, m_cpuLoadList);
+    send(frame);
+
+    if (m_profilingEnabled)
+    {
+        qDebug() << "QCpuFleetAgent::updateProcessList: processes:" << processList.size() << "frame (bytes):" << frame.size();
+    }
+}
+
+/**
+ * @brief QCpuFleetAgent::updateProcessMetadata
+ */
+void QCpuFleetAgent::updateProcessMetadata(const QCpuProcessMetadataList& metadataList) noexcept
+{
+    //the aggregator has its own string pool: send the strings
+    QCpuFleetWriter writer;
+    writer.writeVarint(static_cast<quint64>(metadataList.size()));
+    std::for_each(metadataList.cbegin(), metadataList.cend(), [this, &writer](const QCpuProcessMetadata & metadata)
+    {
+        writer.writeVarint(static_cast<quint64>(metadata.pid));
+        writer.writeVarint(metadata.startTimestampInMs);
+        writer.writeString(m_stringPoolPtr->string(metadata.nameId));
+        writer.writeString(m_stringPoolPtr->string(metadata.userId));
+        writer.writeString(metadata.cwd);
+        writer.writeString(metadata.cgroup);
+        writer.writeString(metadata.commandLine.left(c_fleetMaxCommandLineLength));
+    });
+
+    send(writer.frame(QCpuFleetFrameType::Metadata));
+}
+
+/**
+ * @brief QCpuFleetAgent::updateCpuLoadList
+ */
+void QCpuFleetAgent::updateCpuLoadList(const QCpuLoadList& cpuLoadList) noexcept
+{
+    //sent with the next samples frame
+    m_cpuLoadList = cpuLoadList;
+}
+
+/**
+ * @brief QCpuFleetAgent::send
+ */
+void QCpuFleetAgent::send(const QByteArray& frame) noexcept
+{
+    if (!m_connected)
+    {
+        return;
+    }
+
+    //the aggregator doesn't keep up: drop the backlog, the new connection starts with a full frame
+    if (m_socketPtr->bytesToWrite() > c_fleetMaxPendingBytes)
+    {
+        qDebug() << "QCpuFleetAgent::send: the aggregator is too slow, reconnecting - host:" << m_hostName;
+        reconnect();
+        return;
+    }
+
+    m_socketPtr->write(frame);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUFLEETAGENT_H
+#define QCPUFLEETAGENT_H
+
+#include <QObject>
+#include <QDebug>
+#include <QTimer>
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QMetaObject>
+#include "QCpuSource.h"
+#include "QCpuFleetProtocol.h"
+
+/**
+ * @brief QCpuFleetAgent class
+ *
+ * Subscribes to a source (the local monitor) like the model does and streams its
+ * process lists to an aggregator as delta-encoded samples frames. The commands of
+ * the aggregator are forwarded to the source. The connection is retried until the
+ * aggregator is reachable; every new connection starts with a full frame.
+ */
+class QCpuFleetAgent final : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    QCpuFleetAgent(QCpuSource* cpuSourcePtr, const QCpuFleetAddress& address, const QString& hostName, QObject* parentPtr = nullptr);
+
+private:
+
+    void connectToAggregator() noexcept;
+    void connected() noexcept;
+    void disconnected() noexcept;
+    void reconnect() noexcept;
+    void readFrames() noexcept;
+    void processPidRequest(QCpuFleetReader& reader, const char* method) noexcept;
+    void processCommand(QCpuFleetReader& reader) noexcept;
+    void updateProcessList(const QCpuProcessList& processList) noexcept;
+    void updateProcessMetadata(const QCpuProcessMetadataList& metadataList) noexcept;
+    void updateCpuLoadList(const QCpuLoadList& cpuLoadList) noexcept;
+    void send(const QByteArray& frame) noexcept;
+
+    QCpuSource* m_cpuSourcePtr { nullptr };
+    std::shared_ptr<const QCpuStringPool> m_stringPoolPtr;
+    const QCpuFleetAddress m_address;
+    const QString m_hostName;
+    QIODevice* m_socketPtr { nullptr };         // QTcpSocket or QLocalSocket
+    QTimer* m_timerReconnectPtr { nullptr };
+    QByteArray m_receiveBuffer;
+    QCpuFleetEncoder m_encoder;
+    QCpuLoadList m_cpuLoadList;
+    bool m_connected { false };
+    bool m_profilingEnabled { false };
+};
+
+#endif // QCPUFLEETAGENT_H
@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuFleetAggregator.h"
+
+/**
+ * @brief QCpuFleetAggregator::QCpuFleetAggregator
+ */
+QCpuFleetAggregator::QCpuFleetAggregator(QObject* parentPtr)
+    : QCpuSource(parentPtr)
+{
+    //create the m_timerRefreshPtr timer, the merged list is sent at the refresh cadence of the GUI
+    m_timerRefreshPtr = new QTimer(this);
+    m_timerRefreshPtr->setInterval(c_timerRefreshProcessListIntervalInMs);
+    connect(m_timerRefreshPtr, &QTimer::timeout, this, &QCpuFleetAggregator::timeoutRefresh);
+    m_timerRefreshPtr->start();
+}
+
+/**
+ * @brief QCpuFleetAggregator::listen
+ */
+bool QCpuFleetAggregator::listen(const QCpuFleetAddress& address)
+{
+    //local socket
+    if (address.local)
+    {
+        //a previous aggregator may have left its socket file behind
+        QLocalServer::removeServer(address.path);
+
+        m_localServerPtr = new QLocalServer(this);
+        connect(m_localServerPtr, &QLocalServer::newConnection, this, [this]()
+        {
+            while (m_localServerPtr->hasPendingConnections())
+            {
+                acceptHost(m_localServerPtr->nextPendingConnection());
+            }
+        });
+
+        if (!m_localServerPtr->listen(address.path))
+        {
+            qDebug() << "QCpuFleetAggregator::listen: cannot listen - path:" << address.path << "error:" << m_localServerPtr->errorString();
+            return false;
+        }
+
+        return true;
+    }
+
+    //TCP
+    m_tcpServerPtr = new QTcpServer(this);
+    connect(m_tcpServerPtr, &QTcpServer::newConnection, this, [this]()
+    {
+        while (m_tcpServerPtr->hasPendingConnections())
+        {
+            QTcpSocket* socketPtr = m_tcpServerPtr->nextPendingConnection();
+            socketPtr->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            acceptHost(socketPtr);
+        }
+    });
+
+    const QHostAddress hostAddress = address.host == "*" ? QHostAddress(QHostAddress::Any) : QHostAddress(address.host);
+    if (!m_tcpServerPtr->listen(hostAddress, address.port))
+    {
+        qDebug() << "QCpuFleetAggregator::listen: cannot listen - host:" << address.host << "port:" << address.port << "error:" << m_tcpServerPtr->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief QCpuFleetAggregator::stringPool
+ */
+std::shared_ptr<const QCpuStringPool> QCpuFleetAggregator::stringPool() const
+{
+    return m_stringPoolPtr;
+}
+
+/**
+ * @brief QCpuFleetAggregator::setProcessLimit
+ */
+void QCpuFleetAggregator::setProcessLimit(pid_t pid, int cpuLimit)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuFleetAggregator::setProcessLimit",
+               "This method must be called from the owner thread");
+
+    //check the limit, the agent checks it again
+    if (cpuLimit < 0)
+    {
+        qDebug() << "QCpuFleetAggregator::setProcessLimit: invalid CPU limit - pid:" << pid << "cpuLimit:" << cpuLimit;
+        return;
+    }
+
+    sendCommand(pid, QCpuFleetCommand::SetCpuLimit, static_cast<quint64>(cpuLimit));
+}
+
+/**
+ * @brief QCpuFleetAggregator::removeProcessLimit
+ */
+void QCpuFleetAggregator::removeProcessLimit(pid_t pid)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuFleetAggregator::removeProcessLimit",
+               "This method must be called from the owner thread");
+
+    sendCommand(pid, QCpuFleetCommand::RemoveCpuLimit, 0);
+}
+
+/**
+ * @brief QCpuFleetAggregator::setProcessIoLimit
+ */
+void QCpuFleetAggregator::setProcessIoLimit(pid_t pid, qint64 ioLimitInBytesPerSecond)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuFleetAggregator::setProcessIoLimit",
+               "This method must be called from the owner thread");
+
+    //check the limit, the agent checks it again
+    if (ioLimitInBytesPerSecond <= 0)
+    {
+        qDebug() << "QCpuFleetAggregator::setProcessIoLimit: invalid I/O limit - pid:" << pid << "ioLimitInBytesPerSecond:" << ioLimitInBytesPerSecond;
+        return;
+    }
+
+    sendCommand(pid, QCpuFleetCommand::SetIoLimit, static_cast<quint64>(ioLimitInBytesPerSecond));
+}
+
+/**
+ * @brief QCpuFleetAggregator::removeProcessIoLimit
+ */
+void QCpuFleetAggregator::removeProcessIoLimit(pid_t pid)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuFleetAggregator::removeProcessIoLimit",
+               "This method must be called from the owner thread");
+
+    sendCommand(pid, QCpuFleetCommand::RemoveIoLimit, 0);
+}
+
+/**
+ * @brief QCpuFleetAggregator::setSoftThrottling
+ */
+void QCpuFleetAggregator::setSoftThrottling(bool enabled)
+{
+    broadcastCommand(QCpuFleetCommand::SetSoftThrottling, enabled ? 1 : 0);
+}
+
+/**
+ * @brief QCpuFleetAggregator::setSampleSource
+ */
+void QCpuFleetAggregator::setSampleSource(int sampleSource)
+{
+    broadcastCommand(QCpuFleetCommand::SetSampleSource, static_cast<quint64>(std::max(sampleSource, 0)));
+}
+
+/**
+ * @brief QCpuFleetAggregator::setAutoProtection
+ */
+void QCpuFleetAggregator::setAutoProtection(bool enabled)
+{
+    broadcastCommand(QCpuFleetCommand::SetAutoProtection, enabled ? 1 : 0);
+}
+
+/**
+ * @brief QCpuFleetAggregator::setExtendedStatistics
+ */
+void QCpuFleetAggregator::setExtendedStatistics(bool enabled)
+{
+    broadcastCommand(QCpuFleetCommand::SetExtendedStatistics, enabled ? 1 : 0);
+}
+
+/**
+ * @brief QCpuFleetAggregator::setDescendantLimit
+ */
+void QCpuFleetAggregator::setDescendantLimit(int descendantLimit)
+{
+    broadcastCommand(QCpuFleetCommand::SetDescendantLimit, static_cast<quint64>(std::max(descendantLimit, 0)));
+}
+
+/**
+ * @brief QCpuFleetAggregator::setSubscription
+ */
+void QCpuFleetAggregator::setSubscription(int subscription)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuFleetAggregator::setSubscription",
+               "This method must be called from the owner thread");
+
+    //check if the subscription is valid
+    if (subscription < static_cast<int>(QCpuSubscription::Visible) ||
+            subscription > static_cast<int>(QCpuSubscription::Hidden))
+    {
+        qDebug() << "QCpuFleetAggregator::setSubscription: invalid subscription - subscription:" << subscription;
+        return;
+    }
+
+    //the agents keep streaming, only the merged list is decimated
+    const QCpuSubscription previousSubscription = m_subscription;
+    m_subscription = static_cast<QCpuSubscription>(subscription);
+
+    //the GUI is shown again: refresh it now
+    if (previousSubscription != m_subscription && m_subscription == QCpuSubscription::Visible)
+    {
+        timeoutRefresh();
+    }
+}
+
+/**
+ * @brief QCpuFleetAggregator::setRefreshInterval
+ */
+void QCpuFleetAggregator::setRefreshInterval(int refreshIntervalInMs)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuFleetAggregator::setRefreshInterval",
+               "This method must be called from the owner thread");
+
+    //check if the interval is valid
+    if (refreshIntervalInMs < c_minRefreshProcessListIntervalInMs ||
+            refreshIntervalInMs > c_maxRefreshProcessListIntervalInMs)
+    {
+        qDebug() << "QCpuFleetAggregator::setRefreshInterval: invalid refresh interval - refreshIntervalInMs:" << refreshIntervalInMs;
+        return;
+    }
+
+    //the agents keep their own cadence, the merged list follows the GUI
+    m_timerRefreshPtr->start(refreshIntervalInMs);
+}
+
+/**
+ * @brief QCpuFleetAggregator::requestProcessMetadata
+ */
+void QCpuFleetAggregator::requestProcessMetadata(const PidList pidList)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuFleetAggregator::requestProcessMetadata",
+               "This method must be called from the owner thread");
+
+    //the answers come back as metadata frames
+    sendPidRequest(QCpuFleetFrameType::MetadataRequest, pidList, false);
+}
+
+/**
+ * @brief QCpuFleetAggregator::requestProcessStatistics
+ */
+void QCpuFleetAggregator::requestProcessStatistics(const PidList pidList)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuFleetAggregator::requestProcessStatistics",
+               "This method must be called from the owner thread");
+
+    //every host replaces its set: the hosts without a shown row stop reading theirs
+    sendPidRequest(QCpuFleetFrameType::StatisticsRequest, pidList, true);
+}
+
+/**
+ * @brief QCpuFleetAggregator::sendPidRequest
+ */
+void QCpuFleetAggregator::sendPidRequest(QCpuFleetFrameType type, const PidList& pidList, bool everyHost) noexcept
+{
+    //group the pids by host, sorted so that they can be sent as deltas
+    QMap<int, PidList> hostPidMap;
+    if (everyHost)
+    {
+        for (auto hostIt = m_hostIndexMap.cbegin(); hostIt != m_hostIndexMap.cend(); ++hostIt)
+        {
+            hostPidMap.insert(hostIt.key(), PidList());
+        }
+    }
+
+    std::for_each(pidList.constBegin(), pidList.constEnd(), [&hostPidMap](pid_t pid)
+    {
+        hostPidMap[pid >> c_fleetHostPidBits].push_back(pid & c_fleetHostPidMask);
+    });
+
+    //one frame per host
+    for (auto hostIt = hostPidMap.begin(); hostIt != hostPidMap.end(); ++hostIt)
+    {
+        QIODevice* socketPtr = m_hostIndexMap.value(hostIt.key(), nullptr);
+        if (!socketPtr)
+        {
+            continue;
+        }
+
+        PidList& hostPidList = hostIt.value();
+        std::sort(hostPidList.begin(), hostPidList.end());
+
+        QCpuFleetWriter writer;
+        writer.writeVarint(static_cast<quint64>(hostPidList.size()));
+        pid_t previousPid = 0;
+        std::for_each(hostPidList.cbegin(), hostPidList.cend(), [&writer, &previousPid](pid_t pid)
+        {
+            writer.writeVarint(static_cast<quint64>(pid - previousPid));
+            previousPid = pid;
+        });
+
+        socketPtr->write(writer.frame(type));
+    }
+}
+
+/**
+ * @brief QCpuFleetAggregator::acceptHost
+ */
+void QCpuFleetAggregator::acceptHost(QIODevice* socketPtr) noexcept
+{
+    //find a free host index, the most recently freed ones are reused last
+    int hostIndex = -1;
+    for (int attempt = 0; attempt < c_fleetMaxHosts; ++attempt)
+    {
+        const int candidate = (m_nextHostIndex - 1 + attempt) % c_fleetMaxHosts + 1;
+        if (!m_hostIndexMap.contains(candidate))
+        {
+            hostIndex = candidate;
+            break;
+        }
+    }
+
+    if (hostIndex < 0)
+    {
+        qDebug() << "QCpuFleetAggregator::acceptHost: too many hosts - max:" << c_fleetMaxHosts;
+        socketPtr->close();
+        socketPtr->deleteLater();
+        return;
+    }
+
+    m_nextHostIndex = hostIndex % c_fleetMaxHosts + 1;
+
+    //register the host, it is shown once its hello frame is received
+    QCpuFleetHost host;
+    host.index = hostIndex;
+    host.socketPtr = socketPtr;
+    m_hostMap.insert(socketPtr, host);
+    m_hostIndexMap.insert(hostIndex, socketPtr);
+
+    connect(socketPtr, &QIODevice::readyRead, this, [this, socketPtr]()
+    {
+        readFrames(socketPtr);
+    });
+
+    //the local and TCP sockets have no common disconnected signal
+    if (QTcpSocket* tcpSocketPtr = qobject_cast<QTcpSocket*>(socketPtr))
+    {
+        connect(tcpSocketPtr, &QTcpSocket::disconnected, this, [this, socketPtr]()
+        {
+            removeHost(socketPtr);
+        });
+    }
+    else if (QLocalSocket* localSocketPtr = qobject_cast<QLocalSocket*>(socketPtr))
+    {
+        connect(localSocketPtr, &QLocalSocket::disconnected, this, [this, socketPtr]()
+        {
+            removeHost(socketPtr);
+        });
+    }
+}
+
+/**
+ * @brief QCpuFleetAggregator::removeHost
+ */
+void QCpuFleetAggregator::removeHost(QIODevice* socketPtr) noexcept
+{
+    auto hostIt = m_hostMap.find(socketPtr);
+    if (hostIt == m_hostMap.end())
+    {
+        return;
+    }
+
+    qDebug() << "QCpuFleetAggregator::removeHost: host disconnected - host:" << hostIt->name;
+
+    //its processes leave the merged list at the next refresh
+    m_hostIndexMap.remove(hostIt->index);
+    m_hostMap.erase(hostIt);
+    socketPtr->deleteLater();
+}
+
+/**
+ * @brief QCpuFleetAggregator::readFrames
+ */
+void QCpuFleetAggregator::readFrames(QIODevice* socketPtr) noexcept
+{
+    auto hostIt = m_hostMap.find(socketPtr);
+    if (hostIt == m_hostMap.end())
+    {
+        return;
+    }
+
+    QCpuFleetHost& host = hostIt.value();
+    host.receiveBuffer.append(socketPtr->readAll());
+
+    //process the complete frames
+    QCpuFleetFrameType type;
+    QByteArray payload;
+    bool error = false;
+    while (!error && QCpuFleetReader::takeFrame(host.receiveBuffer, type, payload, error))
+    {
+        QCpuFleetReader reader(payload);
+        switch (type)
+        {
+            case QCpuFleetFrameType::Hello:
+                error = !processHello(host, reader);
+                break;
+
+            case QCpuFleetFrameType::Samples:
+                //the frames are deltas: one bad frame breaks the stream
+                error = host.name.isEmpty() || !QCpuFleetDecoder::decode(reader, host.processMap, host.cpuLoadList);
+                break;
+
+            case QCpuFleetFrameType::Metadata:
+                processMetadata(host, reader);
+                break;
+
+            default:
+                qDebug() << "QCpuFleetAggregator::readFrames: unexpected frame - type:" << static_cast<int>(type);
+                break;
+        }
+    }
+
+    //drop the host, the agent reconnects and starts again with a full frame
+    if (error)
+    {
+        qDebug() << "QCpuFleetAggregator::readFrames: invalid frame, dropping the host - host:" << host.name;
+        socketPtr->close();
+        removeHost(socketPtr);
+    }
+}
+
+/**
+ * @brief QCpuFleetAggregator::processHello
+ */
+bool QCpuFleetAggregator::processHello(QCpuFleetHost& host, QCpuFleetReader& reader) noexcept
+{
+    //check the version
+    const quint8 version = reader.readByte();
+    const QString name = reader.readString();
+    if (!reader.ok() || version != c_fleetProtocolVersion)
+    {
+        qDebug() << "QCpuFleetAggregator::processHello: unsupported agent - version:" << version;
+        return false;
+    }
+
+    qDebug() << "QCpuFleetAggregator::processHello: host connected - host:" << name << "index:" << host.index;
+    host.name = name.isEmpty() ? QString("host%1").arg(host.index) : name;
+
+    //the new host follows the settings chosen in the GUI
+    for (auto settingIt = m_settingMap.cbegin(); settingIt != m_settingMap.cend(); ++settingIt)
+    {
+        QCpuFleetWriter writer;
+        writer.writeByte(static_cast<quint8>(settingIt.key()));
+        writer.writeVarint(0);
+        writer.writeVarint(settingIt.value());
+        host.socketPtr->write(writer.frame(QCpuFleetFrameType::Command));
+    }
+
+    return true;
+}
+
+/**
+ * @brief QCpuFleetAggregator::processMetadata
+ */
+void QCpuFleetAggregator::processMetadata(QCpuFleetHost& host, QCpuFleetReader& reader) noexcept
+{
+    //the strings are interned in the pool of the aggregator, the user is shown as user@host
+    QCpuProcessMetadataList metadataList;
+    const quint64 count = reader.readVarint();
+    for (quint64 index = 0; index < count && reader.ok(); ++index)
+    {
+        QCpuProcessMetadata metadata;
+        metadata.pid                = (host.index << c_fleetHostPidBits) | (static_cast<pid_t>(reader.readVarint()) & c_fleetHostPidMask);
+        metadata.startTimestampInMs = reader.readVarint();
+        metadata.nameId             = m_stringPoolPtr->intern(reader.readString());
+        const QString user          = reader.readString();
+        metadata.userId             = m_stringPoolPtr->intern(QString("%1@%2").arg(user, host.name));
+        metadata.cwd                = reader.readString();
+        metadata.cgroup             = reader.readString();
+        metadata.commandLine        = reader.readString();
+        metadataList.push_back(metadata);
+    }
+
+    if (!reader.ok())
+    {
+        qDebug() << "QCpuFleetAggregator::processMetadata: invalid frame - host:" << host.name;
+        return;
+    }
+
+    //emit the signal
+    emit updateProcessMetadata(metadataList);
+}
+
+/**
+ * @brief QCpuFleetAggregator::sendCommand
+ */
+void QCpuFleetAggregator::sendCommand(pid_t pid, QCpuFleetCommand command, quint64 value) noexcept
+{
+    //find the host of the process
+    QCpuFleetHost* hostPtr = host(pid);
+    if (!hostPtr)
+    {
+        qDebug() << "QCpuFleetAggregator::sendCommand: unknown host - pid:" << pid;
+        return;
+    }
+
+    //[command][host pid][value]
+    QCpuFleetWriter writer;
+    writer.writeByte(static_cast<quint8>(command));
+    writer.writeVarint(static_cast<quint64>(pid & c_fleetHostPidMask));
+    writer.writeVarint(value);
+    hostPtr->socketPtr->write(writer.frame(QCpuFleetFrameType::Command));
+}
+
+/**
+ * @brief QCpuFleetAggregator::broadcastCommand
+ */
+void QCpuFleetAggregator::broadcastCommand(QCpuFleetCommand command, quint64 value) noexcept
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuFleetAggregator::broadcastCommand",
+               "This method must be called from the owner thread");
+
+    //remember the setting for the hosts that connect later
+    m_settingMap.insert(static_cast<int>(command), value);
+
+    //send it to every host
+    QCpuFleetWriter writer;
+    writer.writeByte(static_cast<quint8>(command));
+    writer.writeVarint(0);
+    writer.writeVarint(value);
+    const QByteArray frame = writer.frame(QCpuFleetFrameType::Command);
+    for (auto hostIt = m_hostMap.begin(); hostIt != m_hostMap.end(); ++hostIt)
+    {
+        if (!hostIt->name.isEmpty())
+        {
+            hostIt->socketPtr->write(frame);
+        }
+    }
+}
+
+/**
+ * @brief QCpuFleetAggregator::host
+ */
+QCpuFleetHost* QCpuFleetAggregator::host(pid_t pid) noexcept
+{
+    QIODevice* socketPtr = m_hostIndexMap.value(pid >> c_fleetHostPidBits, nullptr);
+    if (!socketPtr)
+    {
+        return nullptr;
+    }
+
+    auto hostIt = m_hostMap.find(socketPtr);
+    return hostIt != m_hostMap.end() ? &hostIt.value() : nullptr;
+}
+
+/**
+ * @brief QCpuFleetAggregator::timeoutRefresh
+ */
+void QCpuFleetAggregator::timeoutRefresh() noexcept
+{
+    //send the merged list according to the subscription of the GUI
+    ++m_refreshCount;
+    const bool sendProcessList = m_subscription == QCpuSubscription::Visible ||
+                                 (m_subscription == QCpuSubscription::Hidden && m_refreshCount % c_hiddenRefreshDecimation == 0);
+    if (!sendProcessList)
+    {
+        return;
+    }
+
+    //the hosts in index order and the processes in pid order: the merged list is sorted by pid like a snapshot
+    QList<int> hostIndexList = m_hostIndexMap.keys();
+    std::sort(hostIndexList.begin(), hostIndexList.end());
+
+    QCpuProcessList processList;
+    QCpuLoadList cpuLoadList;
+    std::for_each(hostIndexList.cbegin(), hostIndexList.cend(), [this, &processList, &cpuLoadList](int hostIndex)
+    {
+        const QCpuFleetHost& host = m_hostMap[m_hostIndexMap[hostIndex]];
+        if (host.name.isEmpty())
+        {
+            return;
+        }
+
+        //the CPUs of the host follow the CPUs of the previous hosts
+        const int cpuOffset = cpuLoadList.size();
+        cpuLoadList.append(host.cpuLoadList);
+
+        for (auto processIt = host.processMap.cbegin(); processIt != host.processMap.cend(); ++processIt)
+        {
+            QCpuProcess process = processIt.value();
+            process.pid       = (hostIndex << c_fleetHostPidBits) | process.pid;
+            process.processor = process.processor >= 0 ? cpuOffset + process.processor : -1;
+            processList.push_back(process);
+        }
+    });
+
+    //emit the signals
+    emit updateProcessList(processList);
+    emit updateCpuLoadList(cpuLoadList);
+}
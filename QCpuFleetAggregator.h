@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUFLEETAGGREGATOR_H
+#define QCPUFLEETAGGREGATOR_H
+
+#include <QDebug>
+#include <QHash>
+#include <QMap>
+#include <QThread>
+#include <QTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include "QCpuSource.h"
+#include "QCpuFleetProtocol.h"
+
+/**
+ * @brief QCpuFleetHost struct, one connected agent
+ */
+struct QCpuFleetHost
+{
+    int index                          = 0;  // shifted into the pids shown by the model
+    QString name;                            // from the hello frame, empty until then
+    QIODevice* socketPtr               = nullptr;
+    QByteArray receiveBuffer;
+    QMap<pid_t, QCpuProcess> processMap;     // host pid -> process, as decoded from the samples frames
+    QCpuLoadList cpuLoadList;
+};
+
+/**
+ * @brief QCpuFleetAggregator class
+ *
+ * Accepts agents over TCP or a local socket and merges their processes into one
+ * source for the model: the process of pid p on host h is shown as
+ * (h << c_fleetHostPidBits) | p, its CPU is shifted by the CPU count of the
+ * hosts before it so that the per-CPU strip shows all the hosts side by side.
+ * Limits and settings set from the GUI are sent back to the agents.
+ */
+class QCpuFleetAggregator final : public QCpuSource
+{
+    Q_OBJECT
+
+public:
+
+    explicit QCpuFleetAggregator(QObject* parentPtr = nullptr);
+
+    bool listen(const QCpuFleetAddress& address);
+    std::shared_ptr<const QCpuStringPool> stringPool() const override;
+
+public slots:
+
+    void setProcessLimit(pid_t pid, int cpuLimit) override;
+    void removeProcessLimit(pid_t pid) override;
+    void setProcessIoLimit(pid_t pid, qint64 ioLimitInBytesPerSecond) override;
+    void removeProcessIoLimit(pid_t pid) override;
+    void setSoftThrottling(bool enabled) override;
+    void setSampleSource(int sampleSource) override;
+    void setAutoProtection(bool enabled) override;
+    void setSubscription(int subscription) override;
+    void setRefreshInterval(int refreshIntervalInMs) override;
+    void setExtendedStatistics(bool enabled) override;
+    void setDescendantLimit(int descendantLimit) override;
+    void requestProcessMetadata(const PidList pidList) override;
+    void requestProcessStatistics(const PidList pidList) override;
+
+private:
+
+    void acceptHost(QIODevice* socketPtr) noexcept;
+    void removeHost(QIODevice* socketPtr) noexcept;
+    void readFrames(QIODevice* socketPtr) noexcept;
+    bool processHello(QCpuFleetHost& host, QCpuFleetReader& reader) noexcept;
+    void processMetadata(QCpuFleetHost& host, QCpuFleetReader& reader) noexcept;
+    void sendPidRequest(QCpuFleetFrameType type, const PidList& pidList, bool everyHost) noexcept;
+    void sendCommand(pid_t pid, QCpuFleetCommand command, quint64 value) noexcept;
+    void broadcastCommand(QCpuFleetCommand command, quint64 value) noexcept;
+    QCpuFleetHost* host(pid_t pid) noexcept;
+    void timeoutRefresh() noexcept;
+
+    QTcpServer* m_tcpServerPtr { nullptr };
+    QLocalServer* m_localServerPtr { nullptr };
+    QHash<QIODevice*, QCpuFleetHost> m_hostMap;     // socket -> host
+    QHash<int, QIODevice*> m_hostIndexMap;          // host index -> socket
+    int m_nextHostIndex { 1 };                      // 0 would mix the hosts with the plain pids, indexes are reused last
+    std::shared_ptr<QCpuStringPool> m_stringPoolPtr { std::make_shared<QCpuStringPool>() };
+    QHash<int, quint64> m_settingMap;               // last broadcast settings, replayed to the new hosts
+    QCpuSubscription m_subscription { QCpuSubscription::Visible };
+    quint64 m_refreshCount { 0 };
+    QTimer* m_timerRefreshPtr { nullptr };
+};
+
+#endif // QCPUFLEETAGGREGATOR_H
@@ -0,0 +1,529 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuFleetProtocol.h"
+#include <QtEndian>
+
+/**
+ * @brief the fields of a samples record, a record only carries the fields that changed
+ */
+constexpr quint8 c_fleetFieldCpuUsage        = 0x01;   // varint, 1/10000 of a CPU
+constexpr quint8 c_fleetFieldCpuLimit        = 0x02;   // varint, 0 for none or 1 + 1/10000 of a CPU, then the auto flag byte
+constexpr quint8 c_fleetFieldIoRate          = 0x04;   // varint, KiB/s
+constexpr quint8 c_fleetFieldIoLimit         = 0x08;   // varint, 0 for none or 1 + bytes/s
+constexpr quint8 c_fleetFieldProcessor       = 0x10;   // varint, 1 + CPU number, 0 if unknown
+constexpr quint8 c_fleetFieldStatCounters    = 0x20;   // state byte, threads, RSS in KiB, minor and major faults
+constexpr quint8 c_fleetFieldContextSwitches = 0x40;   // voluntary and involuntary context switches
+constexpr quint8 c_fleetFieldUsageSeeded     = 0x80;   // byte, 1 once the usage comes from a real sample
+
+/**
+ * @brief quantizeUsage, the CPU usage and limits as sent
+ */
+static quint64 quantizeUsage(double usageInPercent) noexcept
+{
+    return static_cast<quint64>(std::llround(std::max(usageInPercent, 0.0) * c_fleetUsageScale));
+}
+
+/**
+ * @brief quantizeLimit, 0 for no limit
+ */
+static quint64 quantizeLimit(const std::optional<double>& limitInPercent) noexcept
+{
+    return limitInPercent.has_value() ? quantizeUsage(limitInPercent.value()) + 1 : 0;
+}
+
+/**
+ * @brief quantizeIoRate, the I/O rate as sent
+ */
+static quint64 quantizeIoRate(double ioRateInBytesPerSecond) noexcept
+{
+    return static_cast<quint64>(std::llround(std::max(ioRateInBytesPerSecond, 0.0) / 1024.0));
+}
+
+/**
+ * @brief changedFields, the fields of a record that differ once quantized
+ */
+static quint8 changedFields(const QCpuProcess& previous, const QCpuProcess& current) noexcept
+{
+    quint8 fields = 0;
+
+    if (quantizeUsage(previous.cpuUsageInPercent) != quantizeUsage(current.cpuUsageInPercent))
+    {
+        fields |= c_fleetFieldCpuUsage;
+    }
+
+    if (quantizeLimit(previous.cpuLimitInPercent) != quantizeLimit(current.cpuLimitInPercent) ||
+            previous.autoLimited != current.autoLimited)
+    {
+        fields |= c_fleetFieldCpuLimit;
+    }
+
+    if (quantizeIoRate(previous.ioRateInBytesPerSecond) != quantizeIoRate(current.ioRateInBytesPerSecond))
+    {
+        fields |= c_fleetFieldIoRate;
+    }
+
+    if (previous.ioLimitInBytesPerSecond != current.ioLimitInBytesPerSecond)
+    {
+        fields |= c_fleetFieldIoLimit;
+    }
+
+    if (previous.processor != current.processor)
+    {
+        fields |= c_fleetFieldProcessor;
+    }
+
+    if (!(previous.statCounters == current.statCounters))
+    {
+        fields |= c_fleetFieldStatCounters;
+    }
+
+    if (previous.voluntaryContextSwitches != current.voluntaryContextSwitches ||
+            previous.involuntaryContextSwitches != current.involuntaryContextSwitches)
+    {
+        fields |= c_fleetFieldContextSwitches;
+    }
+
+    if (previous.usageSeeded != current.usageSeeded)
+    {
+        fields |= c_fleetFieldUsageSeeded;
+    }
+
+    return fields;
+}
+
+/**
+ * @brief QCpuFleetAddress::parse
+ */
+bool QCpuFleetAddress::parse(const QString& address, QCpuFleetAddress& result)
+{
+    result = QCpuFleetAddress();
+
+    //local socket
+    if (address.startsWith("unix:") || address.startsWith('/'))
+    {
+        result.local = true;
+        result.path = address.startsWith("unix:") ? address.mid(5) : address;
+        return !result.path.isEmpty();
+    }
+
+    //TCP: "port" or "host:port"
+    const int separator = address.lastIndexOf(':');
+    if (separator >= 0)
+    {
+        result.host = address.left(separator);
+    }
+
+    bool ok = false;
+    const uint port = address.mid(separator + 1).toUInt(&ok);
+    if (!ok || port == 0 || port > 65535 || (separator >= 0 && result.host.isEmpty()))
+    {
+        return false;
+    }
+
+    result.port = static_cast<quint16>(port);
+    return true;
+}
+
+/**
+ * @brief QCpuFleetWriter::writeByte
+ */
+void QCpuFleetWriter::writeByte(quint8 value)
+{
+    m_payload.append(static_cast<char>(value));
+}
+
+/**
+ * @brief QCpuFleetWriter::writeVarint
+ */
+void QCpuFleetWriter::writeVarint(quint64 value)
+{
+    //7 bits per byte, the high bit tells that more bytes follow
+    while (value >= 0x80)
+    {
+        m_payload.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    m_payload.append(static_cast<char>(value));
+}
+
+/**
+ * @brief QCpuFleetWriter::writeString
+ */
+void QCpuFleetWriter::writeString(const QString& string)
+{
+    const QByteArray utf8 = string.toUtf8();
+    writeVarint(static_cast<quint64>(utf8.size()));
+    m_payload.append(utf8);
+}
+
+/**
+ * @brief QCpuFleetWriter::frame
+ */
+QByteArray QCpuFleetWriter::frame(QCpuFleetFrameType type) const
+{
+    //[length: 4 bytes, big endian][type: 1 byte][payload], the length counts the type and the payload
+    QByteArray frame(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(m_payload.size() + 1), frame.data());
+    frame.append(static_cast<char>(type));
+    frame.append(m_payload);
+    return frame;
+}
+
+/**
+ * @brief QCpuFleetWriter::size
+ */
+int QCpuFleetWriter::size() const
+{
+    return m_payload.size();
+}
+
+/**
+ * @brief QCpuFleetReader::QCpuFleetReader, the payload must outlive the reader
+ */
+QCpuFleetReader::QCpuFleetReader(const QByteArray& payload)
+    : m_dataPtr(payload.constData())
+    , m_endPtr(payload.constData() + payload.size())
+{
+}
+
+/**
+ * @brief QCpuFleetReader::readByte
+ */
+quint8 QCpuFleetReader::readByte() noexcept
+{
+    if (m_dataPtr >= m_endPtr)
+    {
+        m_ok = false;
+        return 0;
+    }
+
+    return static_cast<quint8>(*m_dataPtr++);
+}
+
+/**
+ * @brief QCpuFleetReader::readVarint
+ */
+quint64 QCpuFleetReader::readVarint() noexcept
+{
+    quint64 value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        const quint8 byte = readByte();
+        if (!m_ok)
+        {
+            return 0;
+        }
+
+        value |= static_cast<quint64>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return value;
+        }
+    }
+
+    //more than 10 bytes: not a varint
+    m_ok = false;
+    return 0;
+}
+
+/**
+ * @brief QCpuFleetReader::readString
+ */
+QString QCpuFleetReader::readString()
+{
+    const quint64 size = readVarint();
+    if (!m_ok || size > static_cast<quint64>(m_endPtr - m_dataPtr))
+    {
+        m_ok = false;
+        return QString();
+    }
+
+    const QString string = QString::fromUtf8(m_dataPtr, static_cast<int>(size));
+    m_dataPtr += size;
+    return string;
+}
+
+/**
+ * @brief QCpuFleetReader::ok
+ */
+bool QCpuFleetReader::ok() const noexcept
+{
+    return m_ok;
+}
+
+/**
+ * @brief QCpuFleetReader::atEnd
+ */
+bool QCpuFleetReader::atEnd() const noexcept
+{
+    return m_dataPtr >= m_endPtr;
+}
+
+/**
+ * @brief QCpuFleetReader::takeFrame, removes the first complete frame of the buffer
+ */
+bool QCpuFleetReader::takeFrame(QByteArray& buffer, QCpuFleetFrameType& type, QByteArray& payload, bool& error)
+{
+    error = false;
+
+    //the frame header is not complete yet
+    if (buffer.size() < 4)
+    {
+        return false;
+    }
+
+    //check the length
+    const quint32 length = qFromBigEndian<quint32>(buffer.constData());
+    if (length == 0 || length > static_cast<quint32>(c_fleetMaxFrameSize))
+    {
+        error = true;
+        return false;
+    }
+
+    //the frame is not complete yet
+    if (static_cast<quint32>(buffer.size()) < 4 + length)
+    {
+        return false;
+    }
+
+    type = static_cast<QCpuFleetFrameType>(buffer.at(4));
+    payload = buffer.mid(5, static_cast<int>(length) - 1);
+    buffer.remove(0, 4 + static_cast<int>(length));
+    return true;
+}
+
+/**
+ * @brief QCpuFleetEncoder::encode
+ */
+QByteArray QCpuFleetEncoder::encode(const QCpuProcessList& processList, const QCpuLoadList& cpuLoadList)
+{
+    QCpuFleetWriter writer;
+
+    //(1) the load of each CPU, in percent
+    writer.writeVarint(static_cast<quint64>(cpuLoadList.size()));
+    std::for_each(cpuLoadList.cbegin(), cpuLoadList.cend(), [&writer](double cpuLoad)
+    {
+        writer.writeByte(static_cast<quint8>(qBound(0, qRound(cpuLoad * 100), 100)));
+    });
+
+    //both lists are sorted by pid: merge them to find the removed and the changed processes
+    static const QCpuProcess newProcess;
+    PidList removedList;
+    QList<QPair<int, quint8>> changedList;  // index in processList, changed fields
+    int previousIndex = 0;
+    for (int index = 0; index < processList.size(); ++index)
+    {
+        const QCpuProcess& process = processList[index];
+        while (previousIndex < m_previousList.size() && m_previousList[previousIndex].pid < process.pid)
+        {
+            removedList.push_back(m_previousList[previousIndex++].pid);
+        }
+
+        //a new process is compared with the defaults the decoder starts from
+        const bool known = previousIndex < m_previousList.size() && m_previousList[previousIndex].pid == process.pid;
+        const quint8 fields = changedFields(known ? m_previousList[previousIndex] : newProcess, process);
+        if (known)
+        {
+            ++previousIndex;
+        }
+
+        if (fields != 0 || !known)
+        {
+            changedList.push_back({index, fields});
+        }
+    }
+
+    while (previousIndex < m_previousList.size())
+    {
+        removedList.push_back(m_previousList[previousIndex++].pid);
+    }
+
+    //(2) the removed pids, as deltas
+    writer.writeVarint(static_cast<quint64>(removedList.size()));
+    pid_t previousPid = 0;
+    std::for_each(removedList.cbegin(), removedList.cend(), [&writer, &previousPid](pid_t pid)
+    {
+        writer.writeVarint(static_cast<quint64>(pid - previousPid));
+        previousPid = pid;
+    });
+
+    //(3) the new and changed processes: pid delta, field mask, changed fields
+    writer.writeVarint(static_cast<quint64>(changedList.size()));
+    previousPid = 0;
+    std::for_each(changedList.cbegin(), changedList.cend(), [&writer, &previousPid, &processList](const QPair<int, quint8>& changed)
+    {
+        const QCpuProcess& process = processList[changed.first];
+        const quint8 fields = changed.second;
+        writer.writeVarint(static_cast<quint64>(process.pid - previousPid));
+        writer.writeByte(fields);
+        previousPid = process.pid;
+
+        if (fields & c_fleetFieldCpuUsage)
+        {
+            writer.writeVarint(quantizeUsage(process.cpuUsageInPercent));
+        }
+
+        if (fields & c_fleetFieldCpuLimit)
+        {
+            writer.writeVarint(quantizeLimit(process.cpuLimitInPercent));
+            writer.writeByte(process.autoLimited ? 1 : 0);
+        }
+
+        if (fields & c_fleetFieldIoRate)
+        {
+            writer.writeVarint(quantizeIoRate(process.ioRateInBytesPerSecond));
+        }
+
+        if (fields & c_fleetFieldIoLimit)
+        {
+            writer.writeVarint(process.ioLimitInBytesPerSecond.has_value() ? process.ioLimitInBytesPerSecond.value() + 1 : 0);
+        }
+
+        if (fields & c_fleetFieldProcessor)
+        {
+            writer.writeVarint(static_cast<quint64>(process.processor + 1));
+        }
+
+        if (fields & c_fleetFieldStatCounters)
+        {
+            writer.writeByte(static_cast<quint8>(process.statCounters.state));
+            writer.writeVarint(static_cast<quint64>(std::max(process.statCounters.threadCount, 0)));
+            writer.writeVarint(process.statCounters.rssInBytes / 1024);
+            writer.writeVarint(process.statCounters.minorFaults);
+            writer.writeVarint(process.statCounters.majorFaults);
+        }
+
+        if (fields & c_fleetFieldContextSwitches)
+        {
+            writer.writeVarint(process.voluntaryContextSwitches);
+            writer.writeVarint(process.involuntaryContextSwitches);
+        }
+
+        if (fields & c_fleetFieldUsageSeeded)
+        {
+            writer.writeByte(process.usageSeeded ? 1 : 0);
+        }
+    });
+
+    //the next frame is relative to this one
+    m_previousList = processList;
+    return writer.frame(QCpuFleetFrameType::Samples);
+}
+
+/**
+ * @brief QCpuFleetEncoder::reset, the next frame carries every process
+ */
+void QCpuFleetEncoder::reset()
+{
+    m_previousList.clear();
+}
+
+/**
+ * @brief QCpuFleetDecoder::decode, applies a samples frame to the processes of a host
+ */
+bool QCpuFleetDecoder::decode(QCpuFleetReader& reader, QMap<pid_t, QCpuProcess>& processMap, QCpuLoadList& cpuLoadList)
+{
+    //(1) the load of each CPU
+    const quint64 cpuCount = reader.readVarint();
+    if (!reader.ok() || cpuCount > 4096)
+    {
+        return false;
+    }
+
+    cpuLoadList.clear();
+    for (quint64 cpu = 0; cpu < cpuCount && reader.ok(); ++cpu)
+    {
+        cpuLoadList.push_back(reader.readByte() / 100.0);
+    }
+
+    //(2) the removed pids
+    //a pid above the host pid mask would overlap the host index in the pids shown by the model: reject the frame
+    const quint64 removedCount = reader.readVarint();
+    quint64 pid = 0;
+    for (quint64 removed = 0; removed < removedCount && reader.ok(); ++removed)
+    {
+        pid += reader.readVarint();
+        if (pid > static_cast<quint64>(c_fleetHostPidMask))
+        {
+            return false;
+        }
+
+        processMap.remove(static_cast<pid_t>(pid));
+    }
+
+    //(3) the new and changed processes
+    const quint64 changedCount = reader.readVarint();
+    pid = 0;
+    for (quint64 changed = 0; changed < changedCount && reader.ok(); ++changed)
+    {
+        pid += reader.readVarint();
+        const quint8 fields = reader.readByte();
+        if (!reader.ok())
+        {
+            break;
+        }
+
+        if (pid == 0 || pid > static_cast<quint64>(c_fleetHostPidMask))
+        {
+            return false;
+        }
+
+        QCpuProcess& process = processMap[static_cast<pid_t>(pid)];
+        process.pid = static_cast<pid_t>(pid);
+
+        if (fields & c_fleetFieldCpuUsage)
+        {
+            process.cpuUsageInPercent = reader.readVarint() / c_fleetUsageScale;
+        }
+
+        if (fields & c_fleetFieldCpuLimit)
+        {
+            const quint64 cpuLimit = reader.readVarint();
+            process.cpuLimitInPercent = cpuLimit == 0 ? std::optional<double>() : std::optional<double>((cpuLimit - 1) / c_fleetUsageScale);
+            process.autoLimited = reader.readByte() != 0;
+        }
+
+        if (fields & c_fleetFieldIoRate)
+        {
+            process.ioRateInBytesPerSecond = reader.readVarint() * 1024.0;
+        }
+
+        if (fields & c_fleetFieldIoLimit)
+        {
+            const quint64 ioLimit = reader.readVarint();
+            process.ioLimitInBytesPerSecond = ioLimit == 0 ? std::optional<quint64>() : std::optional<quint64>(ioLimit - 1);
+        }
+
+        if (fields & c_fleetFieldProcessor)
+        {
+            process.processor = static_cast<int>(reader.readVarint()) - 1;
+        }
+
+        if (fields & c_fleetFieldStatCounters)
+        {
+            process.statCounters.state       = static_cast<char>(reader.readByte());
+            process.statCounters.threadCount = static_cast<int>(reader.readVarint());
+            process.statCounters.rssInBytes  = reader.readVarint() * 1024;
+            process.statCounters.minorFaults = reader.readVarint();
+            process.statCounters.majorFaults = reader.readVarint();
+        }
+
+        if (fields & c_fleetFieldContextSwitches)
+        {
+            process.voluntaryContextSwitches   = reader.readVarint();
+            process.involuntaryContextSwitches = reader.readVarint();
+        }
+
+        if (fields & c_fleetFieldUsageSeeded)
+        {
+            process.usageSeeded = reader.readByte() != 0;
+        }
+    }
+
+    return reader.ok() && reader.atEnd();
+}
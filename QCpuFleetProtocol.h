@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUFLEETPROTOCOL_H
+#define QCPUFLEETPROTOCOL_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <algorithm>
+#include <cmath>
+#include "QCpuTypes.h"
+
+/**
+ * @brief c_fleetProtocolVersion constant, sent in the hello frame
+ */
+constexpr quint8 c_fleetProtocolVersion = 2;
+
+/**
+ * @brief c_fleetDefaultPort constant
+ */
+constexpr quint16 c_fleetDefaultPort = 7070;
+
+/**
+ * @brief c_fleetMaxFrameSize constant, a larger frame is a protocol error
+ */
+constexpr int c_fleetMaxFrameSize = 16 * 1024 * 1024;
+
+/**
+ * @brief c_fleetMaxPendingBytes constant, an agent that can't send faster than this resynchronizes
+ */
+constexpr qint64 c_fleetMaxPendingBytes = 4 * 1024 * 1024;
+
+/**
+ * @brief c_fleetReconnectIntervalInMs constant
+ */
+constexpr int c_fleetReconnectIntervalInMs = std::chrono::milliseconds(2s).count();
+
+/**
+ * @brief the aggregator shows the process pid of host h as (h << c_fleetHostPidBits) | pid, pid_max is at most 2^22
+ */
+constexpr int c_fleetHostPidBits = 22;
+constexpr int c_fleetMaxHosts    = 511;
+
+/**
+ * @brief c_fleetHostPidMask constant, the host pid part of a pid shown by the model
+ */
+constexpr pid_t c_fleetHostPidMask = (1 << c_fleetHostPidBits) - 1;
+
+/**
+ * @brief c_fleetUsageScale constant, the CPU usage and limits are sent in 1/10000 of a CPU
+ */
+constexpr double c_fleetUsageScale = 10000.0;
+
+/**
+ * @brief c_fleetMaxCommandLineLength constant, longer command lines are truncated on the wire
+ */
+constexpr int c_fleetMaxCommandLineLength = 512;
+
+/**
+ * @brief QCpuFleetFrameType enum
+ */
+enum class QCpuFleetFrameType : quint8
+{
+    Hello = 1,          // agent -> aggregator: version, host name
+    Samples,            // agent -> aggregator: CPU loads and the processes changed since the last frame
+    MetadataRequest,    // aggregator -> agent: pids shown by the view
+    Metadata,           // agent -> aggregator: names, users and command lines
+    Command,            // aggregator -> agent: limits and settings
+    StatisticsRequest,  // aggregator -> agent: pids whose extended statistics are shown by the view
+};
+
+/**
+ * @brief QCpuFleetCommand enum
+ */
+enum class QCpuFleetCommand : quint8
+{
+    SetCpuLimit = 1,
+    RemoveCpuLimit,
+    SetIoLimit,
+    RemoveIoLimit,
+    SetSoftThrottling,
+    SetSampleSource,
+    SetAutoProtection,
+    SetExtendedStatistics,
+    SetDescendantLimit,
+};
+
+/**
+ * @brief QCpuFleetAddress struct, "unix:<path>" or "<path>" for a local socket, "[host:]port" for TCP
+ */
+struct QCpuFleetAddress
+{
+    bool local                         = false;
+    QString path;                              // local socket name or path
+    QString host                       = "127.0.0.1"; // TCP host name or address, "*" for any (aggregator only)
+    quint16 port                       = c_fleetDefaultPort;
+
+    static bool parse(const QString& address, QCpuFleetAddress& result);
+};
+
+/**
+ * @brief QCpuFleetWriter class, appends LEB128 varints and strings to a payload
+ */
+class QCpuFleetWriter final
+{
+public:
+
+    void writeByte(quint8 value);
+    void writeVarint(quint64 value);
+    void writeString(const QString& string);
+
+    QByteArray frame(QCpuFleetFrameType type) const;
+    int size() const;
+
+private:
+
+    QByteArray m_payload;
+};
+
+/**
+ * @brief QCpuFleetReader class, reads a payload written by QCpuFleetWriter
+ *
+ * A truncated or malformed payload sets the error flag instead of reading past the end.
+ */
+class QCpuFleetReader final
+{
+public:
+
+    explicit QCpuFleetReader(const QByteArray& payload);
+
+    quint8 readByte() noexcept;
+    quint64 readVarint() noexcept;
+    QString readString();
+
+    bool ok() const noexcept;
+    bool atEnd() const noexcept;
+
+    static bool takeFrame(QByteArray& buffer, QCpuFleetFrameType& type, QByteArray& payload, bool& error);
+
+private:
+
+    const char* m_dataPtr { nullptr };
+    const char* m_endPtr  { nullptr };
+    bool m_ok { true };
+};
+
+/**
+ * @brief QCpuFleetEncoder class, the agent side of the samples frames
+ *
+ * Only the processes that changed since the previous frame are sent, with their
+ * changed fields only: pids as deltas of the previous pid (the snapshots are sorted),
+ * values quantized to what the GUI shows. A steady system costs a few bytes per frame.
+ */
+class QCpuFleetEncoder final
+{
+public:
+
+    QByteArray encode(const QCpuProcessList& processList, const QCpuLoadList& cpuLoadList);
+    void reset();
+
+private:
+
+    QCpuProcessList m_previousList;     // sorted by pid, as last sent
+};
+
+/**
+ * @brief QCpuFleetDecoder class, the aggregator side of the samples frames
+ */
+class QCpuFleetDecoder final
+{
+public:
+
+    static bool decode(QCpuFleetReader& reader, QMap<pid_t, QCpuProcess>& processMap, QCpuLoadList& cpuLoadList);
+};
+
+#endif // QCPUFLEETPROTOCOL_H
@@ -0,0 +1,1237 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuLimiter.h"
+
+/**
+ * @brief QCpuLimiter::QCpuLimiter
+ */
+QCpuLimiter::QCpuLimiter(QCpuProcessTable& processTable,
+                         QCpuClock& clock,
+                         QCpuTimeSource& timeSource,
+                         QCpuSignalSink& signalSink)
+    : m_processTable(processTable)
+    , m_clock(clock)
+    , m_timeSource(timeSource)
+    , m_signalSink(signalSink)
+{
+}
+
+/**
+ * @brief QCpuLimiter::setSoftThrottling
+ */
+void QCpuLimiter::setSoftThrottling(bool enabled) noexcept
+{
+    //the limited processes pick it up at their next evaluation
+    m_softThrottlingEnabled = enabled;
+}
+
+/**
+ * @brief QCpuLimiter::setSystemContended
+ */
+void QCpuLimiter::setSystemContended(bool contended) noexcept
+{
+    m_systemContended = contended;
+}
+
+/**
+ * @brief QCpuLimiter::setSampleSource
+ */
+void QCpuLimiter::setSampleSource(QCpuSampleSource sampleSource) noexcept
+{
+    //each process takes a new baseline at its next sample
+    m_sampleSource = sampleSource;
+}
+
+/**
+ * @brief QCpuLimiter::setStatCounters
+ */
+void QCpuLimiter::setStatCounters(bool enabled) noexcept
+{
+    //the stat sampler parses the counters anyway: keep them while they are shown
+    m_statCountersEnabled = enabled;
+}
+
+/**
+ * @brief QCpuLimiter::scanSystemLoad
+ */
+void QCpuLimiter::scanSystemLoad() noexcept
+{
+    //read the ticks of the CPUs, the previous state stays when they are unreadable
+    m_systemStat = QCpuSystemStat();
+    if (!m_timeSource.readSystemStat(m_systemStat))
+    {
+        return;
+    }
+
+    //calculate the busy fraction of each CPU since the previous scan
+    for (size_t cpu = 0; cpu < m_systemStat.cpuTotalTicks.size(); ++cpu)
+    {
+        while (static_cast<size_t>(m_cpuLoadList.size()) <= cpu)
+        {
+            m_cpuLoadList.push_back(0.0);
+        }
+
+        const quint64 totalTicks = m_systemStat.cpuTotalTicks[cpu];
+        const quint64 previousTotalTicks = cpu < m_previousSystemStat.cpuTotalTicks.size() ? m_previousSystemStat.cpuTotalTicks[cpu] : 0;
+        const quint64 previousIdleTicks = cpu < m_previousSystemStat.cpuIdleTicks.size() ? m_previousSystemStat.cpuIdleTicks[cpu] : 0;
+        if (previousTotalTicks != 0 && totalTicks > previousTotalTicks)
+        {
+            const quint64 cpuElapsedIdleTicks = m_systemStat.cpuIdleTicks[cpu] - previousIdleTicks;
+            m_cpuLoadList[cpu] = std::clamp(1.0 - static_cast<double>(cpuElapsedIdleTicks) / (totalTicks - previousTotalTicks), 0.0, 1.0);
+        }
+    }
+
+    //calculate the busy fraction of all CPUs since the previous scan
+    const quint64 elapsedTicks = m_systemStat.totalTicks - m_previousSystemStat.totalTicks;
+    const quint64 elapsedIdleTicks = m_systemStat.idleTicks - m_previousSystemStat.idleTicks;
+    const bool firstScan = m_previousSystemStat.totalTicks == 0;
+    std::swap(m_previousSystemStat, m_systemStat);
+
+    if (firstScan || elapsedTicks == 0)
+    {
+        return;
+    }
+
+    const double busyFraction = 1.0 - static_cast<double>(elapsedIdleTicks) / elapsedTicks;
+
+    //the system is contended when the CPUs are (almost) saturated or threads are waiting for a CPU
+    //procs_running counts the reading thread as well
+    m_systemContended = busyFraction >= c_systemContentionThreshold ||
+                        m_previousSystemStat.runningProcesses - 1 > m_previousSystemStat.cpuCount;
+}
+
+/**
+ * @brief QCpuLimiter::systemContended
+ */
+bool QCpuLimiter::systemContended() const noexcept
+{
+    return m_systemContended;
+}
+
+/**
+ * @brief QCpuLimiter::cpuLoadList
+ */
+const QCpuLoadList& QCpuLimiter::cpuLoadList() const noexcept
+{
+    return m_cpuLoadList;
+}
+
+/**
+ * @brief QCpuLimiter::scanRunningProcesses
+ */
+void QCpuLimiter::scanRunningProcesses(PidList& removedList, PidList& changedList) noexcept
+{
+    //drain the queued forks and execs, the processes they report are listed below anyway
+    handleProcessEvents(std::numeric_limits<int>::max());
+
+    //get all running processes, an unreadable list would remove every process
+    PidList runningProcesses;
+    if (!m_timeSource.listProcesses(runningProcesses))
+    {
+        return;
+    }
+
+    //remove all processes that are not running anymore, and the old process of a reused pid
+    //walk backwards: removing a row moves the last row into its place
+    const QSet<pid_t> runningSet(runningProcesses.constBegin(), runningProcesses.constEnd());
+    for (int index = m_processTable.size() - 1; index >= 0; --index)
+    {
+        const pid_t pid = m_processTable.hot(index).pid;
+        if (!runningSet.contains(pid))
+        {
+            removedList.push_back(pid);
+        }
+        else if (!reusedProcess(index))
+        {
+            continue;
+        }
+        else
+        {
+            //the new process is discovered below, without the limits of the old one
+            changedList.push_back(pid);
+        }
+
+        m_execPidSet.remove(pid);
+        unindexProcess(index);
+        m_processTable.removeAt(index);
+        removeProcess(pid);
+    }
+
+    //the processes that exec'd keep their row and their limits, only their metadata changed
+    std::copy(m_execPidSet.cbegin(), m_execPidSet.cend(), std::back_inserter(changedList));
+    m_execPidSet.clear();
+
+    //add new processes
+    std::for_each(runningProcesses.constBegin(), runningProcesses.constEnd(), [this](pid_t pid)
+    {
+        //check if the process is already in the list
+        if (!m_processTable.contains(pid))
+        {
+            discoverProcess(pid);
+        }
+    });
+
+    //update the limits of the trees that gained or lost members
+    updateLimitTrees();
+}
+
+/**
+ * @brief QCpuLimiter::setDescendantLimit
+ */
+void QCpuLimiter::setDescendantLimit(QCpuDescendantLimit descendantLimit) noexcept
+{
+    //nothing changed?
+    if (m_descendantLimit == descendantLimit)
+    {
+        return;
+    }
+
+    const QCpuDescendantLimit previousDescendantLimit = m_descendantLimit;
+    m_descendantLimit = descendantLimit;
+
+    //disabled: the roots keep the whole budget, the descendants are released
+    if (descendantLimit == QCpuDescendantLimit::None)
+    {
+        const QList<int> treeIdList = m_limitTreeMap.keys();
+        std::for_each(treeIdList.cbegin(), treeIdList.cend(), [this](int treeId)
+        {
+            const QCpuLimitTree tree = m_limitTreeMap.value(treeId);
+            dissolveLimitTree(treeId);
+
+            const int rootIndex = m_processTable.indexOf(tree.rootPid);
+            if (rootIndex >= 0 && m_processTable.hot(rootIndex).cpuLimitInPercent.has_value())
+            {
+                m_processTable.hot(rootIndex).cpuLimitInPercent = tree.budgetInPercent;
+            }
+        });
+
+        return;
+    }
+
+    //enabled: every limit set by the user becomes the root of a tree, created first so that the nearest root wins
+    if (previousDescendantLimit == QCpuDescendantLimit::None)
+    {
+        std::vector<int> treeIdList;
+        for (int index = 0; index < m_processTable.size(); ++index)
+        {
+            const QCpuProcessHotState& process = m_processTable.hot(index);
+            const QCpuProcessColdState& control = m_processTable.cold(index);
+            if (process.cpuLimitInPercent.has_value() && !control.autoLimited && control.limitTreeId == 0)
+            {
+                treeIdList.push_back(createLimitTree(index, process.cpuLimitInPercent.value()));
+            }
+        }
+
+        std::for_each(treeIdList.cbegin(), treeIdList.cend(), [this](int treeId)
+        {
+            joinDescendants(treeId, m_limitTreeMap.value(treeId).rootPid);
+        });
+    }
+    else
+    {
+        //inherit <-> share: every tree gets new limits
+        const QList<int> treeIdList = m_limitTreeMap.keys();
+        m_dirtyTreeSet.unite(QSet<int>(treeIdList.cbegin(), treeIdList.cend()));
+    }
+
+    updateLimitTrees();
+}
+
+/**
+ * @brief QCpuLimiter::scanProcessEvents
+ */
+bool QCpuLimiter::scanProcessEvents() noexcept
+{
+    //the full rescan finds a new process within a second: too late for a fork bomb under a limit
+    //the forks are read at the control cadence instead, a bounded number per tick
+    return handleProcessEvents(c_maxProcessEventsPerScan);
+}
+
+/**
+ * @brief QCpuLimiter::handleProcessEvents
+ */
+bool QCpuLimiter::handleProcessEvents(int maxEventCount) noexcept
+{
+    //no events or some were lost: the new tree processes wait for the next rescan
+    m_processEventList.clear();
+    m_timeSource.readProcessEvents(m_processEventList, maxEventCount);
+
+    //only the children of the tree processes are added now, the other processes wait for the rescan
+    bool discovered = false;
+    std::for_each(m_processEventList.cbegin(), m_processEventList.cend(), [this, &discovered](const QCpuProcessEvent & event)
+    {
+        //an exec is reported by the next rescan, even if the name did not change
+        if (event.type == QCpuProcessEventType::Exec)
+        {
+            if (m_processTable.contains(event.pid))
+            {
+                m_execPidSet.insert(event.pid);
+            }
+
+            return;
+        }
+
+        if (m_limitTreeMap.isEmpty() || m_processTable.contains(event.pid))
+        {
+            return;
+        }
+
+        const int parentIndex = m_processTable.indexOf(event.ppid);
+        if (parentIndex < 0 || m_processTable.cold(parentIndex).limitTreeId == 0)
+        {
+            return;
+        }
+
+        //the child joins the tree of its parent on discovery
+        if (discoverProcess(event.pid))
+        {
+            discovered = true;
+        }
+    });
+
+    //update the limits of the trees that gained members
+    if (discovered)
+    {
+        updateLimitTrees();
+    }
+
+    return discovered;
+}
+
+/**
+ * @brief QCpuLimiter::discoverProcess
+ */
+bool QCpuLimiter::discoverProcess(pid_t pid) noexcept
+{
+    //read the identity of the process, the rest of the metadata is loaded on demand
+    QCpuStatSample statSample;
+    if (!m_timeSource.readStat(pid, statSample))
+    {
+        return false;
+    }
+
+    //take the baseline in the selected source so that the first sample can seed the usage
+    quint64 cpuTimeInNs = statSample.cpuTimeInNs;
+    QCpuSampleSource sampleSource = QCpuSampleSource::StatTicks;
+    quint64 schedStatCpuTimeInNs = 0;
+    if (m_sampleSource == QCpuSampleSource::SchedStat && m_timeSource.readSchedStatCpuTime(pid, schedStatCpuTimeInNs))
+    {
+        cpuTimeInNs  = schedStatCpuTimeInNs;
+        sampleSource = QCpuSampleSource::SchedStat;
+    }
+
+    //timestamp the baseline right after its read: a scan of thousands of processes takes milliseconds
+    const quint64 nowInNs = m_clock.monotonicInNs();
+
+    //create the process
+    QCpuProcessHotState hotState;
+    hotState.pid                       = pid;
+    hotState.cpuTimeInNs               = cpuTimeInNs;
+    hotState.sampleSource              = sampleSource;
+    hotState.lastMeasuredTimestampInNs = nowInNs;
+    hotState.processor                 = statSample.processor;
+
+    QCpuProcessColdState coldState;
+    coldState.ppid             = statSample.ppid;
+    coldState.startTimeInTicks = statSample.startTimeInTicks;
+    coldState.nameHash         = statSample.nameHash;
+    if (m_statCountersEnabled)
+    {
+        coldState.statCounters = statSample.counters;
+    }
+
+    //add the process to the table and take its first sample
+    const int index = m_processTable.append(hotState, coldState);
+    addProcess(index);
+
+    //a descendant of a limited process is limited from its discovery
+    indexProcess(index);
+
+    return true;
+}
+
+/**
+ * @brief QCpuLimiter::addProcess
+ */
+void QCpuLimiter::addProcess(int index) noexcept
+{
+    //the first sample seeds the usage: give it a window long enough to be meaningful, then sample at the fast rate
+    QCpuProcessHotState& process = m_processTable.hot(index);
+    scheduleSample(process, process.lastMeasuredTimestampInNs + c_usageSeedIntervalInNs);
+}
+
+/**
+ * @brief QCpuLimiter::reusedProcess
+ */
+bool QCpuLimiter::reusedProcess(int index) noexcept
+{
+    //the process may exit between the list and the read: the next rescan removes it
+    const pid_t pid = m_processTable.hot(index).pid;
+    QCpuStatSample statSample;
+    if (!m_timeSource.readStat(pid, statSample))
+    {
+        return false;
+    }
+
+    //another start time: the pid was reused since the previous rescan
+    QCpuProcessColdState& control = m_processTable.cold(index);
+    if (statSample.startTimeInTicks != control.startTimeInTicks)
+    {
+        return true;
+    }
+
+    //another name: the process exec'd, the connector may not be available to report it
+    if (statSample.nameHash != control.nameHash)
+    {
+        control.nameHash = statSample.nameHash;
+        m_execPidSet.insert(pid);
+    }
+
+    return false;
+}
+
+/**
+ * @brief QCpuLimiter::removeProcess
+ */
+void QCpuLimiter::removeProcess(pid_t pid) noexcept
+{
+    //the queued events become stale, the samples are dropped with the row
+    m_scheduler.removeProcess(pid);
+}
+
+/**
+ * @brief QCpuLimiter::releaseProcess
+ */
+void QCpuLimiter::releaseProcess(int index) noexcept
+{
+    //resume the process and give back its original priority
+    m_signalSink.continueProcess(m_processTable.hot(index).pid);
+    restoreProcess(index);
+}
+
+/**
+ * @brief QCpuLimiter::releaseLimitedProcesses
+ */
+void QCpuLimiter::releaseLimitedProcesses() noexcept
+{
+    //only the processes we stopped or demoted: a process stopped by someone else stays stopped
+    for (int index = 0; index < m_processTable.size(); ++index)
+    {
+        const QCpuProcessHotState& process = m_processTable.hot(index);
+        if (process.pid == m_currentProcessId)
+        {
+            continue;
+        }
+
+        if (process.cpuLimitInPercent.has_value() || process.ioLimitInBytesPerSecond.has_value() ||
+                m_processTable.cold(index).demoted)
+        {
+            releaseProcess(index);
+        }
+    }
+}
+
+/**
+ * @brief QCpuLimiter::nextSampleDeadlineInNs
+ */
+std::optional<quint64> QCpuLimiter::nextSampleDeadlineInNs() const noexcept
+{
+    if (m_sampleQueue.empty())
+    {
+        return std::nullopt;
+    }
+
+    return m_sampleQueue.top().deadlineInNs;
+}
+
+/**
+ * @brief QCpuLimiter::nextControlDeadlineInMs
+ */
+std::optional<quint64> QCpuLimiter::nextControlDeadlineInMs() noexcept
+{
+    return m_scheduler.nextDeadline();
+}
+
+/**
+ * @brief QCpuLimiter::sampleDueProcesses
+ */
+void QCpuLimiter::sampleDueProcesses() noexcept
+{
+    //get the current monotonic timestamp
+    const quint64 nowInNs = m_clock.monotonicInNs();
+
+    //sample the due processes only
+    while (!m_sampleQueue.empty() && m_sampleQueue.top().deadlineInNs <= nowInNs)
+    {
+        const QCpuSampleEvent event = m_sampleQueue.top();
+        m_sampleQueue.pop();
+
+        //the process is gone or has been rescheduled
+        const int index = m_processTable.indexOf(event.pid);
+        if (index < 0 || m_processTable.hot(index).nextSampleTimestampInNs != event.deadlineInNs)
+        {
+            continue;
+        }
+
+        //scan the cpu time
+        QCpuProcessHotState& process = m_processTable.hot(index);
+        scanProcessCpuTime(nowInNs, index);
+
+        //scan the I/O, only for the I/O limited processes
+        if (process.ioLimitInBytesPerSecond.has_value())
+        {
+            scanProcessIo(nowInNs, process);
+        }
+
+        //schedule the next sample
+        scheduleSample(process, nowInNs + process.sampleIntervalInNs);
+    }
+}
+
+/**
+ * @brief QCpuLimiter::controlDueProcesses
+ */
+void QCpuLimiter::controlDueProcesses() noexcept
+{
+    //get the current timestamp
+    const quint64 now = m_clock.monotonicInMs();
+
+    //process the due events
+    QCpuSchedulerEvent event;
+    while (m_scheduler.takeDueEvent(now, event))
+    {
+        //find the process
+        const int index = m_processTable.indexOf(event.pid);
+
+        //the process is gone
+        if (index < 0)
+        {
+            m_scheduler.removeProcess(event.pid);
+            continue;
+        }
+
+        switch (event.action)
+        {
+            case QCpuSchedulerAction::Evaluate:
+                evaluateLimit(now, index);
+                break;
+
+            case QCpuSchedulerAction::Continue:
+                //resume the process
+                m_signalSink.continueProcess(event.pid);
+
+                //evaluate again at the next phase of the process
+                m_scheduler.schedule(event.pid,
+                                     m_scheduler.nextPhaseDeadline(event.pid, now),
+                                     QCpuSchedulerAction::Evaluate);
+                break;
+        }
+    }
+}
+
+/**
+ * @brief QCpuLimiter::scanProcessCpuTime
+ */
+void QCpuLimiter::scanProcessCpuTime(quint64 nowInNs, int index) noexcept
+{
+    QCpuProcessHotState& process = m_processTable.hot(index);
+
+    //calculate the elapsed time since the last measurement
+    const quint64 elapsed = nowInNs - process.lastMeasuredTimestampInNs;
+
+    if (elapsed == 0)
+    {
+        return;
+    }
+
+    //read the CPU time from the selected source
+    //schedstat is missing when the kernel is built without CONFIG_SCHED_INFO: fall back to stat
+    quint64 cpuTimeInNs = 0;
+    QCpuSampleSource sampleSource = m_sampleSource;
+
+    if (sampleSource == QCpuSampleSource::SchedStat && !m_timeSource.readSchedStatCpuTime(process.pid, cpuTimeInNs))
+    {
+        sampleSource = QCpuSampleSource::StatTicks;
+    }
+
+    if (sampleSource == QCpuSampleSource::StatTicks)
+    {
+        QCpuStatSample statSample;
+        if (!m_timeSource.readStat(process.pid, statSample))
+        {
+            return;
+        }
+
+        cpuTimeInNs = statSample.cpuTimeInNs;
+        process.processor = statSample.processor;
+
+        //the refresh of the extended statistics doesn't read the file again
+        if (m_statCountersEnabled)
+        {
+            m_processTable.cold(index).statCounters = statSample.counters;
+        }
+    }
+
+    //update the CPU time
+    process.previousCpuTimeInNs = process.cpuTimeInNs;
+    process.cpuTimeInNs = cpuTimeInNs;
+    process.lastMeasuredTimestampInNs = nowInNs;
+
+    //the first read of a source is only a baseline, the two sources can't be mixed
+    if (process.sampleSource != sampleSource)
+    {
+        process.sampleSource = sampleSource;
+        return;
+    }
+
+    //calculate the sample
+    const quint64 deltaInNs = process.cpuTimeInNs > process.previousCpuTimeInNs ? process.cpuTimeInNs - process.previousCpuTimeInNs : 0;
+    const double sample = 1.0 * deltaInNs / elapsed;
+
+    //calculate CPU usage
+    //schedstat is exact to the nanosecond, it doesn't need as much smoothing as the tick counters
+    //the smoothing is defined per fast sampling interval: a longer interval weighs as several samples
+    //the first sample of a process is taken as is, smoothing it in from zero would take seconds to converge
+    if (!process.usageSeeded)
+    {
+        process.cpuUsageInPercent = sample;
+        process.usageSeeded = true;
+    }
+    else
+    {
+        const double alpha = sampleSource == QCpuSampleSource::SchedStat ? c_cpuUsageSmoothingSchedStat : c_cpuUsageSmoothingStatTicks;
+        const double weight = 1.0 - std::pow(1.0 - alpha, 1.0 * elapsed / c_minSampleIntervalInNs);
+        process.cpuUsageInPercent = (1.0 - weight) * process.cpuUsageInPercent + (weight * sample);
+    }
+
+    //adapt the sampling interval: back off while the process is idle, snap back on any activity
+    if (sample >= c_sampleActivityThreshold || process.cpuLimitInPercent.has_value() || process.ioLimitInBytesPerSecond.has_value())
+    {
+        process.sampleIntervalInNs = c_minSampleIntervalInNs;
+    }
+    else
+    {
+        process.sampleIntervalInNs = std::min(process.sampleIntervalInNs * 2, c_maxSampleIntervalInNs);
+    }
+}
+
+/**
+ * @brief QCpuLimiter::scanProcessIo
+ */
+void QCpuLimiter::scanProcessIo(quint64 nowInNs, QCpuProcessHotState& process) noexcept
+{
+    //read the I/O counters
+    quint64 ioBytes = 0;
+    if (!m_timeSource.readIoBytes(process.pid, ioBytes))
+    {
+        return;
+    }
+
+    //the first read is only a baseline
+    const quint64 elapsed = nowInNs - process.ioTimestampInNs;
+    const quint64 previousIoBytes = process.ioBytes;
+    const bool baseline = process.ioTimestampInNs == 0 || ioBytes < previousIoBytes;
+
+    process.ioBytes = ioBytes;
+    process.ioTimestampInNs = nowInNs;
+
+    if (baseline || elapsed == 0)
+    {
+        return;
+    }
+
+    //calculate the I/O rate, smoothed like the CPU usage
+    const double sample = 1e9 * (ioBytes - previousIoBytes) / elapsed;
+    const double weight = 1.0 - std::pow(1.0 - c_ioRateSmoothing, 1.0 * elapsed / c_minSampleIntervalInNs);
+    process.ioRateInBytesPerSecond = (1.0 - weight) * process.ioRateInBytesPerSecond + (weight * sample);
+}
+
+/**
+ * @brief QCpuLimiter::evaluateLimit
+ */
+void QCpuLimiter::evaluateLimit(quint64 now, int index) noexcept
+{
+    QCpuProcessHotState& process = m_processTable.hot(index);
+    QCpuProcessColdState& control = m_processTable.cold(index);
+
+    //check if the process has a limit
+    if (!process.cpuLimitInPercent.has_value() && !process.ioLimitInBytesPerSecond.has_value())
+    {
+        return;
+    }
+
+    //do we exceed the cpu limit?
+    const bool cpuExceeded = process.cpuLimitInPercent.has_value() &&
+                             process.cpuLimitInPercent.value() > c_minEnforcedCpuLimitInPercent &&
+                             process.cpuUsageInPercent > process.cpuLimitInPercent.value();
+
+    //do we exceed the I/O limit?
+    const bool ioExceeded = process.ioLimitInBytesPerSecond.has_value() &&
+                            process.ioRateInBytesPerSecond > process.ioLimitInBytesPerSecond.value();
+
+    if (!cpuExceeded && !ioExceeded)
+    {
+        //back under the limit: give back the original priority once the usage stayed clearly below it
+        //a process hovering at its limit would otherwise flip its policy at every evaluation
+        const bool cpuCalm = !process.cpuLimitInPercent.has_value() ||
+                             process.cpuUsageInPercent < process.cpuLimitInPercent.value() * c_restoreUsageRatio;
+        const bool ioCalm = !process.ioLimitInBytesPerSecond.has_value() ||
+                            process.ioRateInBytesPerSecond < process.ioLimitInBytesPerSecond.value() * c_restoreUsageRatio;
+
+        control.calmEvaluationCount = cpuCalm && ioCalm ? control.calmEvaluationCount + 1 : 0;
+        if (!control.demoted || control.calmEvaluationCount >= c_restoreEvaluationCount)
+        {
+            restoreProcess(index);
+        }
+        else
+        {
+            control.throttleState = QCpuThrottleState::Soft;
+        }
+
+        //evaluate again at the next phase of the process
+        m_scheduler.schedule(process.pid,
+                             m_scheduler.nextPhaseDeadline(process.pid, now),
+                             QCpuSchedulerAction::Evaluate);
+        return;
+    }
+
+    //the process is over its limit again
+    control.calmEvaluationCount = 0;
+
+    //demote the process first, it only competes for otherwise idle CPU time
+    if (m_softThrottlingEnabled && cpuExceeded)
+    {
+        demoteProcess(index);
+
+        //nobody is hurt while the system has idle CPUs: don't stop the process
+        //a lower CPU priority doesn't slow the I/O down: an I/O excess is always duty-cycled
+        if (!m_systemContended && !ioExceeded)
+        {
+            control.throttleState = QCpuThrottleState::Soft;
+            m_scheduler.schedule(process.pid,
+                                 m_scheduler.nextPhaseDeadline(process.pid, now),
+                                 QCpuSchedulerAction::Evaluate);
+            return;
+        }
+    }
+
+    //the system is contended or the I/O limit is exceeded: duty-cycle the process
+    control.throttleState = QCpuThrottleState::Hard;
+
+    //count the sleep cycles, the largest excess wins
+    int sleepCountInCycle = 1;
+    if (cpuExceeded)
+    {
+        const int cpuSleepCount = (process.cpuUsageInPercent - process.cpuLimitInPercent.value()) / process.cpuLimitInPercent.value();
+        sleepCountInCycle = std::max(sleepCountInCycle, cpuSleepCount);
+    }
+
+    if (ioExceeded)
+    {
+        const double ioLimit = static_cast<double>(process.ioLimitInBytesPerSecond.value());
+        const int ioSleepCount = (process.ioRateInBytesPerSecond - ioLimit) / ioLimit;
+        sleepCountInCycle = std::max(sleepCountInCycle, ioSleepCount);
+    }
+
+    //stop the process
+    m_signalSink.stopProcess(process.pid);
+
+    //resume the process after the sleep cycles, keeping it on its phase
+    const quint64 continueDeadline = m_scheduler.nextPhaseDeadline(process.pid, now) +
+                                     static_cast<quint64>(sleepCountInCycle - 1) * c_timerCpuLimitIntervalInMs;
+    m_scheduler.schedule(process.pid, continueDeadline, QCpuSchedulerAction::Continue);
+}
+
+/**
+ * @brief QCpuLimiter::applyCpuLimit
+ */
+void QCpuLimiter::applyCpuLimit(int index, double cpuLimitInPercent) noexcept
+{
+    //set the cpu limit
+    m_processTable.hot(index).cpuLimitInPercent = cpuLimitInPercent;
+
+    //start the evaluations of the process
+    startLimiting(index);
+}
+
+/**
+ * @brief QCpuLimiter::clearCpuLimit
+ */
+void QCpuLimiter::clearCpuLimit(int index) noexcept
+{
+    QCpuProcessHotState& process = m_processTable.hot(index);
+
+    //resume the process
+    m_signalSink.continueProcess(process.pid);
+
+    //give back the original priority
+    restoreProcess(index);
+
+    //remove the cpu limit
+    process.cpuLimitInPercent.reset();
+    m_processTable.cold(index).autoLimited = false;
+
+    //drop the pending events of the process, unless the I/O is still limited
+    if (process.ioLimitInBytesPerSecond.has_value())
+    {
+        startLimiting(index);
+        return;
+    }
+
+    m_scheduler.removeProcess(process.pid);
+}
+
+/**
+ * @brief QCpuLimiter::applyIoLimit
+ */
+void QCpuLimiter::applyIoLimit(int index, quint64 ioLimitInBytesPerSecond) noexcept
+{
+    QCpuProcessHotState& process = m_processTable.hot(index);
+
+    //set the I/O limit, the counters are read from the next sample on
+    if (!process.ioLimitInBytesPerSecond.has_value())
+    {
+        process.ioTimestampInNs = 0;
+        process.ioRateInBytesPerSecond = 0;
+    }
+
+    process.ioLimitInBytesPerSecond = ioLimitInBytesPerSecond;
+
+    //start the evaluations of the process
+    startLimiting(index);
+}
+
+/**
+ * @brief QCpuLimiter::clearIoLimit
+ */
+void QCpuLimiter::clearIoLimit(int index) noexcept
+{
+    QCpuProcessHotState& process = m_processTable.hot(index);
+
+    //resume the process
+    m_signalSink.continueProcess(process.pid);
+
+    //remove the I/O limit, the counters are no longer read
+    process.ioLimitInBytesPerSecond.reset();
+    process.ioTimestampInNs = 0;
+    process.ioRateInBytesPerSecond = 0;
+
+    //drop the pending events of the process, unless the CPU is still limited
+    if (process.cpuLimitInPercent.has_value())
+    {
+        startLimiting(index);
+        return;
+    }
+
+    restoreProcess(index);
+    m_scheduler.removeProcess(process.pid);
+}
+
+/**
+ * @brief QCpuLimiter::applyTreeLimit
+ */
+void QCpuLimiter::applyTreeLimit(int index, double cpuLimitInPercent) noexcept
+{
+    QCpuProcessColdState& control = m_processTable.cold(index);
+
+    //no descendant policy: the limit is the process's own
+    if (m_descendantLimit == QCpuDescendantLimit::None)
+    {
+        control.autoLimited = false;
+        applyCpuLimit(index, cpuLimitInPercent);
+        return;
+    }
+
+    //a root gets a new budget, any other process leaves its tree and roots a new one
+    int treeId = control.limitTreeId;
+    if (control.limitTreeRoot)
+    {
+        m_limitTreeMap[treeId].budgetInPercent = cpuLimitInPercent;
+        m_dirtyTreeSet.insert(treeId);
+    }
+    else
+    {
+        leaveLimitTree(index);
+        treeId = createLimitTree(index, cpuLimitInPercent);
+    }
+
+    //the descendants already running join the tree, the new ones join it when discovered
+    joinDescendants(treeId, m_processTable.hot(index).pid);
+    updateLimitTrees();
+}
+
+/**
+ * @brief QCpuLimiter::clearTreeLimit
+ */
+void QCpuLimiter::clearTreeLimit(int index) noexcept
+{
+    //a root releases its whole tree, a member only leaves it
+    const QCpuProcessColdState& control = m_processTable.cold(index);
+    const bool root = control.limitTreeRoot;
+    if (root)
+    {
+        dissolveLimitTree(control.limitTreeId);
+    }
+    else
+    {
+        leaveLimitTree(index);
+    }
+
+    clearCpuLimit(index);
+
+    //the subtree of a released root falls back to the tree of its nearest limited ancestor
+    if (root)
+    {
+        const int treeId = ancestorLimitTree(index);
+        if (treeId != 0)
+        {
+            joinLimitTree(treeId, index);
+            joinDescendants(treeId, m_processTable.hot(index).pid);
+        }
+    }
+
+    updateLimitTrees();
+}
+
+/**
+ * @brief QCpuLimiter::indexProcess
+ */
+void QCpuLimiter::indexProcess(int index) noexcept
+{
+    const pid_t pid  = m_processTable.hot(index).pid;
+    const pid_t ppid = m_processTable.cold(index).ppid;
+
+    //index the process under its parent
+    m_childIndex.insert(ppid, pid);
+
+    //no descendant policy or ourselves: nothing to inherit
+    if (m_descendantLimit == QCpuDescendantLimit::None || pid == m_currentProcessId)
+    {
+        return;
+    }
+
+    //the parent belongs to a tree: join it
+    const int parentIndex = m_processTable.indexOf(ppid);
+    if (parentIndex < 0 || m_processTable.cold(parentIndex).limitTreeId == 0)
+    {
+        return;
+    }
+
+    const int treeId = m_processTable.cold(parentIndex).limitTreeId;
+    joinLimitTree(treeId, index);
+
+    //its children may have been discovered first when the pids wrapped around
+    joinDescendants(treeId, pid);
+}
+
+/**
+ * @brief QCpuLimiter::unindexProcess
+ */
+void QCpuLimiter::unindexProcess(int index) noexcept
+{
+    const pid_t pid = m_processTable.hot(index).pid;
+
+    //the children are reparented by the kernel, they keep their tree
+    m_childIndex.remove(m_processTable.cold(index).ppid, pid);
+    m_childIndex.remove(pid);
+
+    //the tree outlives its root: its members keep the budget
+    leaveLimitTree(index);
+}
+
+/**
+ * @brief QCpuLimiter::createLimitTree
+ */
+int QCpuLimiter::createLimitTree(int index, double cpuLimitInPercent) noexcept
+{
+    const int treeId = m_nextLimitTreeId++;
+
+    QCpuLimitTree tree;
+    tree.rootPid         = m_processTable.hot(index).pid;
+    tree.budgetInPercent = cpuLimitInPercent;
+    m_limitTreeMap.insert(treeId, tree);
+
+    QCpuProcessColdState& control = m_processTable.cold(index);
+    control.limitTreeId   = treeId;
+    control.limitTreeRoot = true;
+    control.autoLimited   = false;
+
+    m_dirtyTreeSet.insert(treeId);
+    return treeId;
+}
+
+/**
+ * @brief QCpuLimiter::ancestorLimitTree
+ */
+int QCpuLimiter::ancestorLimitTree(int index) const noexcept
+{
+    //walk up the known parents, bounded: a reused pid can make the chain loop
+    pid_t ppid = m_processTable.cold(index).ppid;
+    for (int depth = 0; depth < m_processTable.size(); ++depth)
+    {
+        const int parentIndex = m_processTable.indexOf(ppid);
+        if (parentIndex < 0)
+        {
+            return 0;
+        }
+
+        const int treeId = m_processTable.cold(parentIndex).limitTreeId;
+        if (treeId != 0)
+        {
+            return treeId;
+        }
+
+        ppid = m_processTable.cold(parentIndex).ppid;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief QCpuLimiter::joinLimitTree
+ */
+void QCpuLimiter::joinLimitTree(int treeId, int index) noexcept
+{
+    QCpuProcessColdState& control = m_processTable.cold(index);
+    if (control.limitTreeId == treeId)
+    {
+        return;
+    }
+
+    //the nearest root wins: leave the tree of a farther ancestor
+    leaveLimitTree(index);
+
+    m_limitTreeMap[treeId].memberSet.insert(m_processTable.hot(index).pid);
+    control.limitTreeId = treeId;
+    control.autoLimited = false;
+    m_dirtyTreeSet.insert(treeId);
+}
+
+/**
+ * @brief QCpuLimiter::leaveLimitTree
+ */
+void QCpuLimiter::leaveLimitTree(int index) noexcept
+{
+    QCpuProcessColdState& control = m_processTable.cold(index);
+    if (control.limitTreeId == 0)
+    {
+        return;
+    }
+
+    //the share of the other members changes
+    auto treeIt = m_limitTreeMap.find(control.limitTreeId);
+    if (treeIt != m_limitTreeMap.end())
+    {
+        treeIt->memberSet.remove(m_processTable.hot(index).pid);
+        m_dirtyTreeSet.insert(control.limitTreeId);
+    }
+
+    control.limitTreeId   = 0;
+    control.limitTreeRoot = false;
+}
+
+/**
+ * @brief QCpuLimiter::joinDescendants
+ */
+void QCpuLimiter::joinDescendants(int treeId, pid_t pid) noexcept
+{
+    //walk the known subtree once, the later descendants join on discovery
+    std::vector<pid_t> pendingList { pid };
+    while (!pendingList.empty())
+    {
+        const pid_t parentPid = pendingList.back();
+        pendingList.pop_back();
+
+        for (auto childIt = m_childIndex.constFind(parentPid); childIt != m_childIndex.constEnd() && childIt.key() == parentPid; ++childIt)
+        {
+            const pid_t childPid = childIt.value();
+            const int childIndex = m_processTable.indexOf(childPid);
+            if (childIndex < 0 || childPid == m_currentProcessId)
+            {
+                continue;
+            }
+
+            //another root keeps its subtree, the members of this tree are already covered (and a reused pid can't loop)
+            const QCpuProcessColdState& control = m_processTable.cold(childIndex);
+            if (control.limitTreeRoot || control.limitTreeId == treeId)
+            {
+                continue;
+            }
+
+            joinLimitTree(treeId, childIndex);
+            pendingList.push_back(childPid);
+        }
+    }
+}
+
+/**
+ * @brief QCpuLimiter::dissolveLimitTree
+ */
+void QCpuLimiter::dissolveLimitTree(int treeId) noexcept
+{
+    auto treeIt = m_limitTreeMap.find(treeId);
+    if (treeIt == m_limitTreeMap.end())
+    {
+        return;
+    }
+
+    //the members lose the inherited limit
+    std::for_each(treeIt->memberSet.cbegin(), treeIt->memberSet.cend(), [this](pid_t pid)
+    {
+        const int index = m_processTable.indexOf(pid);
+        if (index >= 0)
+        {
+            m_processTable.cold(index).limitTreeId = 0;
+            clearCpuLimit(index);
+        }
+    });
+
+    //the root keeps its own limit, the caller decides
+    const int rootIndex = m_processTable.indexOf(treeIt->rootPid);
+    if (rootIndex >= 0 && m_processTable.cold(rootIndex).limitTreeId == treeId)
+    {
+        m_processTable.cold(rootIndex).limitTreeId   = 0;
+        m_processTable.cold(rootIndex).limitTreeRoot = false;
+    }
+
+    m_limitTreeMap.erase(treeIt);
+    m_dirtyTreeSet.remove(treeId);
+}
+
+/**
+ * @brief QCpuLimiter::updateLimitTrees
+ */
+void QCpuLimiter::updateLimitTrees() noexcept
+{
+    //only the trees that changed since the last update
+    std::for_each(m_dirtyTreeSet.cbegin(), m_dirtyTreeSet.cend(), [this](int treeId)
+    {
+        auto treeIt = m_limitTreeMap.find(treeId);
+        if (treeIt == m_limitTreeMap.end())
+        {
+            return;
+        }
+
+        //forget the trees without any running process
+        const int rootIndex = m_processTable.indexOf(treeIt->rootPid);
+        const bool rootRunning = rootIndex >= 0 && m_processTable.cold(rootIndex).limitTreeId == treeId;
+        const int processCount = treeIt->memberSet.size() + (rootRunning ? 1 : 0);
+        if (processCount == 0)
+        {
+            m_limitTreeMap.erase(treeIt);
+            return;
+        }
+
+        //the limit of each process of the tree, a share is never below the smallest enforceable one
+        //a budget of 0 stays 0 for every member, like the limit of a single process
+        const double cpuLimitInPercent = m_descendantLimit == QCpuDescendantLimit::Share ?
+                                         std::max(treeIt->budgetInPercent / processCount,
+                                                  std::min(treeIt->budgetInPercent, c_minTreeShareInPercent)) :
+                                         treeIt->budgetInPercent;
+
+        auto applyLimit = [this, cpuLimitInPercent](int index)
+        {
+            //a limited process only needs the new value, its evaluations are already scheduled
+            QCpuProcessHotState& process = m_processTable.hot(index);
+            if (process.cpuLimitInPercent.has_value())
+            {
+                process.cpuLimitInPercent = cpuLimitInPercent;
+                return;
+            }
+
+            applyCpuLimit(index, cpuLimitInPercent);
+        };
+
+        if (rootRunning)
+        {
+            applyLimit(rootIndex);
+        }
+
+        std::for_each(treeIt->memberSet.cbegin(), treeIt->memberSet.cend(), [this, &applyLimit](pid_t pid)
+        {
+            const int index = m_processTable.indexOf(pid);
+            if (index >= 0)
+            {
+                applyLimit(index);
+            }
+        });
+    });
+
+    m_dirtyTreeSet.clear();
+}
+
+/**
+ * @brief QCpuLimiter::startLimiting
+ */
+void QCpuLimiter::startLimiting(int index) noexcept
+{
+    QCpuProcessHotState& process = m_processTable.hot(index);
+
+    //resume the process
+    m_signalSink.continueProcess(process.pid);
+
+    //a limited process is always sampled at the fast rate
+    if (process.sampleIntervalInNs != c_minSampleIntervalInNs)
+    {
+        process.sampleIntervalInNs = c_minSampleIntervalInNs;
+        scheduleSample(process, m_clock.monotonicInNs() + c_minSampleIntervalInNs);
+    }
+
+    //give the process its own phase and schedule its first evaluation
+    m_scheduler.addProcess(process.pid);
+    m_scheduler.schedule(process.pid,
+                         m_scheduler.nextPhaseDeadline(process.pid, m_clock.monotonicInMs()),
+                         QCpuSchedulerAction::Evaluate);
+}
+
+/**
+ * @brief QCpuLimiter::demoteProcess
+ */
+void QCpuLimiter::demoteProcess(int index) noexcept
+{
+    QCpuProcessColdState& control = m_processTable.cold(index);
+
+    //already demoted?
+    if (control.demoted)
+    {
+        return;
+    }
+
+    control.demoted = m_signalSink.demoteProcess(m_processTable.hot(index).pid, control);
+}
+
+/**
+ * @brief QCpuLimiter::restoreProcess
+ */
+void QCpuLimiter::restoreProcess(int index) noexcept
+{
+    QCpuProcessColdState& control = m_processTable.cold(index);
+
+    //the process is no longer throttled
+    control.throttleState = QCpuThrottleState::None;
+    control.calmEvaluationCount = 0;
+
+    //nothing to restore?
+    if (!control.demoted)
+    {
+        return;
+    }
+
+    m_signalSink.restoreProcess(m_processTable.hot(index).pid, control);
+    control.originalPriorityList.clear();
+    control.demoted = false;
+}
+
+/**
+ * @brief QCpuLimiter::scheduleSample
+ */
+void QCpuLimiter::scheduleSample(QCpuProcessHotState& process, quint64 deadlineInNs) noexcept
+{
+    //the previous deadline of the process, if any, becomes stale
+    process.nextSampleTimestampInNs = deadlineInNs;
+    m_sampleQueue.push({deadlineInNs, process.pid});
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPULIMITER_H
+#define QCPULIMITER_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <vector>
+#include <QHash>
+#include <QSet>
+#include "QCpuTypes.h"
+#include "QCpuPlatform.h"
+#include "QCpuProcessTable.h"
+#include "QCpuScheduler.h"
+
+/**
+ * @brief QCpuLimiter class
+ *
+ * Sampling and limiting core: keeps the usage of the processes of the table up
+ * to date and enforces their limits. It only sees the system through a clock,
+ * a time source and a signal sink, so the same logic runs against /proc and
+ * real signals in the monitor and against a virtual clock in the simulator.
+ * The owner calls scanRunningProcesses to discover the processes, then
+ * sampleDueProcesses and controlDueProcesses when the next deadlines are reached.
+ *
+ * A limit set with applyTreeLimit also covers the descendants of the process,
+ * according to the descendant policy. The children of each known process are
+ * indexed as it is discovered, so a new process only looks up its parent to
+ * join the limit tree, and only the tree it joins is updated. The owner also
+ * calls scanProcessEvents at its control cadence: the forks reported by the
+ * time source since the last call add the children of the tree processes
+ * without waiting for the next full rescan, which remains the fallback.
+ *
+ * The rescan also reads the start time and the name of each known process:
+ * a reused pid is removed and discovered again, and the processes that
+ * exec'd are reported with it, so that the owner refreshes their metadata.
+ */
+class QCpuLimiter final
+{
+public:
+
+    QCpuLimiter(QCpuProcessTable& processTable,
+                QCpuClock& clock,
+                QCpuTimeSource& timeSource,
+                QCpuSignalSink& signalSink);
+
+    void setSoftThrottling(bool enabled) noexcept;
+    void setSystemContended(bool contended) noexcept;
+    void setSampleSource(QCpuSampleSource sampleSource) noexcept;
+    void setStatCounters(bool enabled) noexcept;
+    void setDescendantLimit(QCpuDescendantLimit descendantLimit) noexcept;
+
+    void scanSystemLoad() noexcept;
+    bool systemContended() const noexcept;
+    const QCpuLoadList& cpuLoadList() const noexcept;
+
+    void scanRunningProcesses(PidList& removedList, PidList& changedList) noexcept;
+    bool scanProcessEvents() noexcept;
+    void addProcess(int index) noexcept;
+    void removeProcess(pid_t pid) noexcept;
+    void releaseProcess(int index) noexcept;
+    void releaseLimitedProcesses() noexcept;
+
+    void applyCpuLimit(int index, double cpuLimitInPercent) noexcept;
+    void clearCpuLimit(int index) noexcept;
+    void applyIoLimit(int index, quint64 ioLimitInBytesPerSecond) noexcept;
+    void clearIoLimit(int index) noexcept;
+    void applyTreeLimit(int index, double cpuLimitInPercent) noexcept;
+    void clearTreeLimit(int index) noexcept;
+
+    void sampleDueProcesses() noexcept;
+    void controlDueProcesses() noexcept;
+    std::optional<quint64> nextSampleDeadlineInNs() const noexcept;
+    std::optional<quint64> nextControlDeadlineInMs() noexcept;
+
+private:
+
+    struct QCpuSampleEvent
+    {
+        quint64 deadlineInNs = 0;
+        pid_t pid            = 0;
+
+        bool operator>(const QCpuSampleEvent& other) const
+        {
+            return deadlineInNs > other.deadlineInNs;
+        }
+    };
+
+    void scanProcessCpuTime(quint64 nowInNs, int index) noexcept;
+    void scanProcessIo(quint64 nowInNs, QCpuProcessHotState& process) noexcept;
+    struct QCpuLimitTree
+    {
+        pid_t rootPid          = 0;     // the root may have exited, the tree lives as long as its members
+        double budgetInPercent = 0;     // limit set by the user on the root
+        QSet<pid_t> memberSet;          // descendants that joined the tree, the root excluded
+    };
+
+    bool handleProcessEvents(int maxEventCount) noexcept;
+    bool discoverProcess(pid_t pid) noexcept;
+    bool reusedProcess(int index) noexcept;
+    void indexProcess(int index) noexcept;
+    void unindexProcess(int index) noexcept;
+    int createLimitTree(int index, double cpuLimitInPercent) noexcept;
+    int ancestorLimitTree(int index) const noexcept;
+    void joinLimitTree(int treeId, int index) noexcept;
+    void leaveLimitTree(int index) noexcept;
+    void joinDescendants(int treeId, pid_t pid) noexcept;
+    void dissolveLimitTree(int treeId) noexcept;
+    void updateLimitTrees() noexcept;
+    void evaluateLimit(quint64 now, int index) noexcept;
+    void startLimiting(int index) noexcept;
+    void demoteProcess(int index) noexcept;
+    void restoreProcess(int index) noexcept;
+    void scheduleSample(QCpuProcessHotState& process, quint64 deadlineInNs) noexcept;
+
+    QCpuProcessTable& m_processTable;
+    QCpuClock& m_clock;
+    QCpuTimeSource& m_timeSource;
+    QCpuSignalSink& m_signalSink;
+    std::priority_queue<QCpuSampleEvent, std::vector<QCpuSampleEvent>, std::greater<QCpuSampleEvent>> m_sampleQueue;
+    QCpuScheduler m_scheduler { c_timerCpuLimitIntervalInMs };
+    QCpuSampleSource m_sampleSource { QCpuSampleSource::SchedStat };
+    QCpuDescendantLimit m_descendantLimit { QCpuDescendantLimit::None };
+    QMultiHash<pid_t, pid_t> m_childIndex;          // ppid -> pid, filled on discovery
+    QHash<int, QCpuLimitTree> m_limitTreeMap;       // tree id -> tree
+    QSet<int> m_dirtyTreeSet;                       // trees whose members changed, updated once per operation
+    int m_nextLimitTreeId { 1 };
+    QCpuProcessEventList m_processEventList;        // reused by every read of the process events
+    QSet<pid_t> m_execPidSet;                       // known processes that exec'd since the previous rescan
+    QCpuSystemStat m_systemStat;                    // read by scanSystemLoad
+    QCpuSystemStat m_previousSystemStat;            // the previous read, 0 ticks before the first one
+    QCpuLoadList m_cpuLoadList;                     // busy fraction of each CPU since the previous scan
+    const pid_t m_currentProcessId { getpid() };    // never joins a limit tree, even below a limited shell
+    bool m_systemContended       { true };
+    bool m_softThrottlingEnabled { true };
+    bool m_statCountersEnabled   { false };
+};
+
+#endif // QCPULIMITER_H
@@ -6,20 +6,65 @@
 
 #include "QCpuModel.h"
 
+/**
+ * @brief c_bytesPerMiB constant, the I/O rates and limits are shown in MiB/s
+ */
+constexpr double c_bytesPerMiB = 1024.0 * 1024.0;
+
+/**
+ * @brief c_firstPaintChunkSize constant, rows inserted per event loop iteration by the first process list
+ */
+constexpr int c_firstPaintChunkSize = 256;
+
 /**
  * @brief QCpuModel::QCpuModel
  */
-QCpuModel::QCpuModel()
+QCpuModel::QCpuModel(QCpuSource* cpuSourcePtr)
+    : m_cpuSourcePtr(cpuSourcePtr)
 {
-    //create the monitor in its own thread
-    m_cpuMonitorPtr = QCpuMonitor::create();
+    //report the time to the first useful screen?
+    m_profilingEnabled = qEnvironmentVariableIntValue("QTCPULIMIT_PROFILE") != 0;
+    m_startupTimer.start();
+
+    //no source given: create the local monitor in its own thread
+    if (!m_cpuSourcePtr)
+    {
+        m_cpuSourcePtr = QCpuMonitor::create();
+    }
 
-    //connect the monitor to the model
-    connect(m_cpuMonitorPtr,
-            &QCpuMonitor::updateProcessList,
+    //the interned strings are resolved at display time only
+    m_stringPoolPtr = m_cpuSourcePtr->stringPool();
+
+    //connect the source to the model
+    connect(m_cpuSourcePtr,
+            &QCpuSource::updateProcessList,
             this,
             &QCpuModel::updateProcessList,
             Qt::QueuedConnection);
+
+    connect(m_cpuSourcePtr,
+            &QCpuSource::updateProcessMetadata,
+            this,
+            &QCpuModel::updateProcessMetadata,
+            Qt::QueuedConnection);
+
+    connect(m_cpuSourcePtr,
+            &QCpuSource::updateCpuLoadList,
+            this,
+            &QCpuModel::updateCpuLoadList,
+            Qt::QueuedConnection);
+
+    //batch the metadata requested by the view during the same event loop iteration
+    m_timerMetadataRequestPtr = new QTimer(this);
+    m_timerMetadataRequestPtr->setInterval(0);
+    m_timerMetadataRequestPtr->setSingleShot(true);
+    connect(m_timerMetadataRequestPtr, &QTimer::timeout, this, &QCpuModel::requestPendingMetadata);
+
+    //stream the first process list to the view, one chunk per event loop iteration
+    m_timerPendingRowsPtr = new QTimer(this);
+    m_timerPendingRowsPtr->setInterval(0);
+    m_timerPendingRowsPtr->setSingleShot(true);
+    connect(m_timerPendingRowsPtr, &QTimer::timeout, this, &QCpuModel::insertPendingRows);
 }
 
 /**
@@ -33,15 +78,31 @@ void QCpuModel::selectProcess(int index)
         return;
     }
 
-    //update the selected process
+    //update the selected process, the metadata may still be loading
+    const QCpuProcessMetadata* metadataPtr = metadata(m_processList[index].pid);
+
     m_selectedProcessPid      = m_processList[index].pid;
     m_selectedProcessCpuLimit = m_processList[index].cpuLimitInPercent.value_or(-1);
-    m_selectedProcessCommand  = m_processList[index].command;
+    m_selectedProcessIoLimit  = m_processList[index].ioLimitInBytesPerSecond.has_value() ?
+                                static_cast<int>(m_processList[index].ioLimitInBytesPerSecond.value() / c_bytesPerMiB) : -1;
+    m_selectedProcessMetadata = metadataPtr ? *metadataPtr : QCpuProcessMetadata();
+    m_selectedProcessCommand  = command(m_selectedProcessMetadata);
 
     //emit the signals
     emit selectedProcessPidChanged();
     emit selectedProcessCpuLimitChanged();
+    emit selectedProcessIoLimitChanged();
     emit selectedProcessCommandChanged();
+    emit selectedProcessMetadataChanged();
+}
+
+/**
+ * @brief QCpuModel::selectProcessByPid
+ */
+void QCpuModel::selectProcessByPid(int pid)
+{
+    //the rows of a filtered view don't match the rows of the model
+    selectProcess(m_rowMap.value(pid, -1));
 }
 
 /**
@@ -56,7 +117,7 @@ void QCpuModel::setProcessLimit(int cpuLimit)
     }
 
     //set the process limit
-    QMetaObject::invokeMethod(m_cpuMonitorPtr,
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
                               "setProcessLimit",
                               Qt::QueuedConnection,
                               Q_ARG(pid_t, m_selectedProcessPid),
@@ -75,12 +136,49 @@ void QCpuModel::removeProcessLimit()
     }
 
     //remove the process limit
-    QMetaObject::invokeMethod(m_cpuMonitorPtr,
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
                               "removeProcessLimit",
                               Qt::QueuedConnection,
                               Q_ARG(pid_t, m_selectedProcessPid));
 }
 
+/**
+ * @brief QCpuModel::setProcessIoLimit
+ */
+void QCpuModel::setProcessIoLimit(int ioLimitInMiBPerSecond)
+{
+    //any selected PID ?
+    if (m_selectedProcessPid <= 0)
+    {
+        return;
+    }
+
+    //set the process I/O limit
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "setProcessIoLimit",
+                              Qt::QueuedConnection,
+                              Q_ARG(pid_t, m_selectedProcessPid),
+                              Q_ARG(qint64, static_cast<qint64>(ioLimitInMiBPerSecond * c_bytesPerMiB)));
+}
+
+/**
+ * @brief QCpuModel::removeProcessIoLimit
+ */
+void QCpuModel::removeProcessIoLimit()
+{
+    //any selected PID ?
+    if (m_selectedProcessPid <= 0)
+    {
+        return;
+    }
+
+    //remove the process I/O limit
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "removeProcessIoLimit",
+                              Qt::QueuedConnection,
+                              Q_ARG(pid_t, m_selectedProcessPid));
+}
+
 /**
  * @brief QCpuModel::roleNames
  */
@@ -93,6 +191,23 @@ QHash<int, QByteArray> QCpuModel::roleNames() const
         {CpuUsage,  "cpuUsage"},
         {CpuLimit,  "cpuLimit"},
         {Command,   "command"},
+        {Cwd,       "cwd"},
+        {Cgroup,    "cgroup"},
+        {StartTime, "startTime"},
+        {CpuUsageValue, "cpuUsageValue"},
+        {CpuLimitValue, "cpuLimitValue"},
+        {IoRate,    "ioRate"},
+        {IoRateValue, "ioRateValue"},
+        {Processor, "processor"},
+        {State,     "state"},
+        {Threads,   "threads"},
+        {Rss,       "rss"},
+        {RssValue,  "rssValue"},
+        {MinorFaults, "minorFaults"},
+        {MajorFaults, "majorFaults"},
+        {VoluntaryContextSwitches, "voluntaryContextSwitches"},
+        {InvoluntaryContextSwitches, "involuntaryContextSwitches"},
+        {Qt::DisplayRole, "display"},
     };
 }
 
@@ -102,7 +217,9 @@ QHash<int, QByteArray> QCpuModel::roleNames() const
 int QCpuModel::rowCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent)
-    return m_processList.size();
+
+    //during a merge the rows after the merged ones are still the previous ones
+    return m_processList.size() + m_previousProcessList.size() - m_previousIndex;
 }
 
 /**
@@ -111,7 +228,7 @@ int QCpuModel::rowCount(const QModelIndex& parent) const
 int QCpuModel::columnCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent)
-    return 5;
+    return m_extendedStatistics ? ColumnCount : CommandColumn + 1;
 }
 
 /**
@@ -126,37 +243,195 @@ QVariant QCpuModel::data(const QModelIndex& index, int role) const
     }
 
     //check if the index is out of range
-    if (index.row() >= m_processList.size() || index.row() < 0)
+    if (index.row() >= rowCount() || index.row() < 0)
     {
         return QVariant();
     }
 
+    //the table view asks for the display role: map the column to its role
+    if (role == Qt::DisplayRole)
+    {
+        static const int columnRoles[ColumnCount] = { Pid, User, CpuUsage, CpuLimit, IoRate, Processor, Command,
+                                                      State, Threads, Rss, MinorFaults, MajorFaults,
+                                                      VoluntaryContextSwitches, InvoluntaryContextSwitches };
+        if (index.column() < 0 || index.column() >= columnCount())
+        {
+            return QVariant();
+        }
+
+        role = columnRoles[index.column()];
+    }
+
+    //the view reads the extended statistics of the rows it shows: only those are refreshed by the source
+    if (role >= State && role <= InvoluntaryContextSwitches)
+    {
+        m_shownStatisticsSet.insert(processAt(index.row()).pid);
+    }
+
     //return the data according to the role
     switch (role)
     {
         case Pid:
-            return m_processList[index.row()].pid;
+            return processAt(index.row()).pid;
 
         case User:
-            return m_processList[index.row()].user;
+        {
+            const QCpuProcessMetadata* metadataPtr = metadata(processAt(index.row()).pid);
+            return metadataPtr ? m_stringPoolPtr->string(metadataPtr->userId) : QString();
+        }
 
         case CpuUsage:
-            return QString::number(m_processList[index.row()].cpuUsageInPercent * 100, 'f', 2);
+            return QString::number(processAt(index.row()).cpuUsageInPercent * 100, 'f', 2);
+
+        case CpuUsageValue:
+            return processAt(index.row()).cpuUsageInPercent;
+
+        case CpuLimitValue:
+            return processAt(index.row()).cpuLimitInPercent.value_or(-1.0);
 
         case CpuLimit:
         {
-            const auto& cpuLimit = m_processList[index.row()].cpuLimitInPercent;
-            return cpuLimit.has_value() ? QString::number(cpuLimit.value() * 100, 'f', 2) : "N/A";
+            const auto& cpuLimit = processAt(index.row()).cpuLimitInPercent;
+            if (!cpuLimit.has_value())
+            {
+                return "N/A";
+            }
+
+            const QString cpuLimitText = QString::number(cpuLimit.value() * 100, 'f', 2);
+            return processAt(index.row()).autoLimited ? cpuLimitText + " (auto)" : cpuLimitText;
+        }
+
+        case IoRate:
+        {
+            //the I/O is only sampled for the I/O limited processes
+            const QCpuProcess& process = processAt(index.row());
+            if (!process.ioLimitInBytesPerSecond.has_value())
+            {
+                return "N/A";
+            }
+
+            return QString("%1 / %2").arg(process.ioRateInBytesPerSecond / c_bytesPerMiB, 0, 'f', 2)
+                                     .arg(process.ioLimitInBytesPerSecond.value() / c_bytesPerMiB, 0, 'f', 2);
         }
 
+        case IoRateValue:
+            return processAt(index.row()).ioRateInBytesPerSecond;
+
+        case Processor:
+            return processAt(index.row()).processor;
+
+        case State:
+            return QString(QChar(processAt(index.row()).statCounters.state));
+
+        case Threads:
+            return processAt(index.row()).statCounters.threadCount;
+
+        case Rss:
+            return QString::number(processAt(index.row()).statCounters.rssInBytes / c_bytesPerMiB, 'f', 1);
+
+        case RssValue:
+            return static_cast<double>(processAt(index.row()).statCounters.rssInBytes);
+
+        case MinorFaults:
+            return static_cast<double>(processAt(index.row()).statCounters.minorFaults);
+
+        case MajorFaults:
+            return static_cast<double>(processAt(index.row()).statCounters.majorFaults);
+
+        case VoluntaryContextSwitches:
+            return static_cast<double>(processAt(index.row()).voluntaryContextSwitches);
+
+        case InvoluntaryContextSwitches:
+            return static_cast<double>(processAt(index.row()).involuntaryContextSwitches);
+
         case Command:
-            return m_processList[index.row()].command;
+        {
+            const QCpuProcessMetadata* metadataPtr = metadata(processAt(index.row()).pid);
+            return metadataPtr ? command(*metadataPtr) : QString();
+        }
+
+        case Cwd:
+        {
+            const QCpuProcessMetadata* metadataPtr = metadata(processAt(index.row()).pid);
+            return metadataPtr ? metadataPtr->cwd : QString();
+        }
+
+        case Cgroup:
+        {
+            const QCpuProcessMetadata* metadataPtr = metadata(processAt(index.row()).pid);
+            return metadataPtr ? metadataPtr->cgroup : QString();
+        }
+
+        case StartTime:
+        {
+            const QCpuProcessMetadata* metadataPtr = metadata(processAt(index.row()).pid);
+            return metadataPtr ? QDateTime::fromMSecsSinceEpoch(metadataPtr->startTimestampInMs).toString("yyyy-MM-dd hh:mm:ss") : QString();
+        }
     }
 
     //return an invalid variant
     return QVariant();
 }
 
+/**
+ * @brief QCpuModel::headerData
+ */
+QVariant QCpuModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    //only the column titles are provided
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    switch (section)
+    {
+        case PidColumn:
+            return tr("PID");
+
+        case UserColumn:
+            return tr("User");
+
+        case CpuUsageColumn:
+            return tr("CPU Usage (%)");
+
+        case CpuLimitColumn:
+            return tr("CPU Limit (%)");
+
+        case IoRateColumn:
+            return tr("I/O Rate / Limit (MiB/s)");
+
+        case ProcessorColumn:
+            return tr("CPU");
+
+        case CommandColumn:
+            return tr("Command");
+
+        case StateColumn:
+            return tr("State");
+
+        case ThreadsColumn:
+            return tr("Threads");
+
+        case RssColumn:
+            return tr("RSS (MiB)");
+
+        case MinorFaultsColumn:
+            return tr("Minor Faults");
+
+        case MajorFaultsColumn:
+            return tr("Major Faults");
+
+        case VoluntaryContextSwitchesColumn:
+            return tr("Voluntary Switches");
+
+        case InvoluntaryContextSwitchesColumn:
+            return tr("Involuntary Switches");
+    }
+
+    return QVariant();
+}
+
 /**
  * @brief QCpuModel::processCount
  */
@@ -181,6 +456,14 @@ int QCpuModel::selectedProcessCpuLimit() const
     return m_selectedProcessCpuLimit;
 }
 
+/**
+ * @brief QCpuModel::selectedProcessIoLimit
+ */
+int QCpuModel::selectedProcessIoLimit() const
+{
+    return m_selectedProcessIoLimit;
+}
+
 /**
  * @brief QCpuModel::selectedProcessCommand
  */
@@ -189,91 +472,481 @@ QString QCpuModel::selectedProcessCommand() const
     return m_selectedProcessCommand;
 }
 
+/**
+ * @brief QCpuModel::selectedProcessCwd
+ */
+QString QCpuModel::selectedProcessCwd() const
+{
+    return m_selectedProcessMetadata.cwd;
+}
+
+/**
+ * @brief QCpuModel::selectedProcessCgroup
+ */
+QString QCpuModel::selectedProcessCgroup() const
+{
+    return m_selectedProcessMetadata.cgroup;
+}
+
+/**
+ * @brief QCpuModel::selectedProcessStartTime
+ */
+QString QCpuModel::selectedProcessStartTime() const
+{
+    if (m_selectedProcessMetadata.startTimestampInMs == 0)
+    {
+        return QString();
+    }
+
+    return QDateTime::fromMSecsSinceEpoch(m_selectedProcessMetadata.startTimestampInMs).toString("yyyy-MM-dd hh:mm:ss");
+}
+
+/**
+ * @brief QCpuModel::softThrottling
+ */
+bool QCpuModel::softThrottling() const
+{
+    return m_softThrottling;
+}
+
+/**
+ * @brief QCpuModel::setSoftThrottling
+ */
+void QCpuModel::setSoftThrottling(bool enabled)
+{
+    //nothing changed ?
+    if (m_softThrottling == enabled)
+    {
+        return;
+    }
+
+    //update the enforcement policy
+    m_softThrottling = enabled;
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "setSoftThrottling",
+                              Qt::QueuedConnection,
+                              Q_ARG(bool, enabled));
+
+    //emit the signal
+    emit softThrottlingChanged();
+}
+
+/**
+ * @brief QCpuModel::sampleSource
+ */
+int QCpuModel::sampleSource() const
+{
+    return m_sampleSource;
+}
+
+/**
+ * @brief QCpuModel::setSampleSource
+ */
+void QCpuModel::setSampleSource(int sampleSource)
+{
+    //nothing changed ?
+    if (m_sampleSource == sampleSource)
+    {
+        return;
+    }
+
+    //update the sampling source
+    m_sampleSource = sampleSource;
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "setSampleSource",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, sampleSource));
+
+    //emit the signal
+    emit sampleSourceChanged();
+}
+
+/**
+ * @brief QCpuModel::descendantLimit
+ */
+int QCpuModel::descendantLimit() const
+{
+    return m_descendantLimit;
+}
+
+/**
+ * @brief QCpuModel::setDescendantLimit
+ */
+void QCpuModel::setDescendantLimit(int descendantLimit)
+{
+    //nothing changed ?
+    if (m_descendantLimit == descendantLimit)
+    {
+        return;
+    }
+
+    //update the descendant policy
+    m_descendantLimit = descendantLimit;
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "setDescendantLimit",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, descendantLimit));
+
+    //emit the signal
+    emit descendantLimitChanged();
+}
+
+/**
+ * @brief QCpuModel::autoProtection
+ */
+bool QCpuModel::autoProtection() const
+{
+    return m_autoProtection;
+}
+
+/**
+ * @brief QCpuModel::setAutoProtection
+ */
+void QCpuModel::setAutoProtection(bool enabled)
+{
+    //nothing changed ?
+    if (m_autoProtection == enabled)
+    {
+        return;
+    }
+
+    //update the protection mode
+    m_autoProtection = enabled;
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "setAutoProtection",
+                              Qt::QueuedConnection,
+                              Q_ARG(bool, enabled));
+
+    //emit the signal
+    emit autoProtectionChanged();
+}
+
+/**
+ * @brief QCpuModel::subscription
+ */
+int QCpuModel::subscription() const
+{
+    return m_subscription;
+}
+
+/**
+ * @brief QCpuModel::setSubscription
+ */
+void QCpuModel::setSubscription(int subscription)
+{
+    //nothing changed ?
+    if (m_subscription == subscription)
+    {
+        return;
+    }
+
+    //tell the monitor whether the process list is shown
+    m_subscription = subscription;
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "setSubscription",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, subscription));
+
+    //emit the signal
+    emit subscriptionChanged();
+}
+
+/**
+ * @brief QCpuModel::refreshInterval
+ */
+int QCpuModel::refreshInterval() const
+{
+    return m_refreshInterval;
+}
+
+/**
+ * @brief QCpuModel::setRefreshInterval
+ */
+void QCpuModel::setRefreshInterval(int refreshIntervalInMs)
+{
+    //nothing changed ?
+    if (m_refreshInterval == refreshIntervalInMs)
+    {
+        return;
+    }
+
+    //update the refresh cadence of the process list
+    m_refreshInterval = refreshIntervalInMs;
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "setRefreshInterval",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, refreshIntervalInMs));
+
+    //emit the signal
+    emit refreshIntervalChanged();
+}
+
+/**
+ * @brief QCpuModel::cpuLoads
+ */
+QVariantList QCpuModel::cpuLoads() const
+{
+    return m_cpuLoads;
+}
+
+/**
+ * @brief QCpuModel::extendedStatistics
+ */
+bool QCpuModel::extendedStatistics() const
+{
+    return m_extendedStatistics;
+}
+
+/**
+ * @brief QCpuModel::setExtendedStatistics
+ */
+void QCpuModel::setExtendedStatistics(bool enabled)
+{
+    //nothing changed ?
+    if (m_extendedStatistics == enabled)
+    {
+        return;
+    }
+
+    //show or hide the extended columns, after the command column
+    if (enabled)
+    {
+        beginInsertColumns(QModelIndex(), StateColumn, ColumnCount - 1);
+        m_extendedStatistics = true;
+        endInsertColumns();
+    }
+    else
+    {
+        beginRemoveColumns(QModelIndex(), StateColumn, ColumnCount - 1);
+        m_extendedStatistics = false;
+        endRemoveColumns();
+
+        m_shownStatisticsSet.clear();
+        m_requestedStatisticsSet.clear();
+    }
+
+    //the context switches are only read while the columns are shown
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "setExtendedStatistics",
+                              Qt::QueuedConnection,
+                              Q_ARG(bool, enabled));
+
+    //emit the signal
+    emit extendedStatisticsChanged();
+}
+
+/**
+ * @brief QCpuModel::cpuCount
+ */
+int QCpuModel::cpuCount() const
+{
+    return m_cpuLoads.size();
+}
+
+/**
+ * @brief QCpuModel::updateCpuLoadList
+ */
+void QCpuModel::updateCpuLoadList(const QCpuLoadList& cpuLoadList)
+{
+    //the count changes rarely (CPU hotplug, aggregator hosts), the views keep their cells until it does
+    const bool countChanged = m_cpuLoads.size() != cpuLoadList.size();
+
+    //convert the loads for QML
+    m_cpuLoads.clear();
+    m_cpuLoads.reserve(cpuLoadList.size());
+    std::for_each(cpuLoadList.cbegin(), cpuLoadList.cend(), [this](double cpuLoad)
+    {
+        m_cpuLoads.push_back(cpuLoad);
+    });
+
+    //emit the signals
+    if (countChanged)
+    {
+        emit cpuCountChanged();
+    }
+
+    emit cpuLoadsChanged();
+}
+
 /**
  * @brief QCpuModel::updateProcessList
  */
-void QCpuModel::updateProcessList(const QCpuProcessList& processList,
-                                  const PidList& processToAdd,
-                                  const PidList& processToRemove)
+void QCpuModel::updateProcessList(const QCpuProcessList& processList)
 {
-    //the process count changed ?
-    const bool countChanged = m_processList.size() != processList.size();
+    //the rows read by the view since the previous list are the ones to refresh from now on
+    requestShownStatistics();
+
+    //the first list is still being inserted: the merge below inserts the rest of the rows at once
+    if (m_timerPendingRowsPtr->isActive())
+    {
+        m_timerPendingRowsPtr->stop();
+        m_pendingProcessList.clear();
+        m_pendingProcessIndex = 0;
+    }
 
-    //treat the case of the first update
+    //treat the case of the first update: the view is usable from the first chunk
     if (Q_UNLIKELY(m_processList.empty() && !processList.empty()))
     {
-        beginResetModel();
-        m_processList = processList;
-        endResetModel();
-        emit processCountChanged();
+        //the screen is useful once the processes shown at startup have their first real sample
+        if (m_profilingEnabled && !m_firstUsefulScreenReported)
+        {
+            std::for_each(processList.cbegin(), processList.cend(), [this](const QCpuProcess & process)
+            {
+                if (!process.usageSeeded)
+                {
+                    m_unseededStartupSet.insert(process.pid);
+                }
+            });
+        }
+
+        m_pendingProcessList = processList;
+        m_pendingProcessIndex = 0;
+        insertPendingRows();
         return;
     }
 
-    //treat the case of process removal
-    std::for_each(processToRemove.cbegin(),
-                  processToRemove.cend(),
-                  [this](pid_t pid)
+    //the startup processes are seeded once each has a real sample or is gone, the processes started later don't count
+    if (m_profilingEnabled && !m_firstUsefulScreenReported && !m_processList.empty())
     {
-        const auto it = std::find_if(m_processList.begin(),
-                                     m_processList.end(),
-                                     [pid](const QCpuProcess & process)
+        std::for_each(processList.cbegin(), processList.cend(), [this](const QCpuProcess & process)
         {
-            return process.pid == pid;
+            if (process.usageSeeded)
+            {
+                m_unseededStartupSet.remove(process.pid);
+            }
         });
 
-        if (it != m_processList.end())
+        //the exited processes
+        if (!m_unseededStartupSet.isEmpty())
         {
-            const auto index = std::distance(m_processList.begin(), it);
-            beginRemoveRows(QModelIndex(), index, index);
-            m_processList.erase(it);
-            endRemoveRows();
+            QSet<pid_t> runningSet;
+            runningSet.reserve(processList.size());
+            std::for_each(processList.cbegin(), processList.cend(), [&runningSet](const QCpuProcess & process)
+            {
+                runningSet.insert(process.pid);
+            });
+
+            m_unseededStartupSet.intersect(runningSet);
         }
-    });
 
-    //treat the case of process addition
-    std::for_each(processToAdd.cbegin(),
-                  processToAdd.cend(),
-                  [this, &processList](pid_t pid)
+        if (m_unseededStartupSet.isEmpty())
+        {
+            m_firstUsefulScreenReported = true;
+            qDebug() << "QCpuModel::updateProcessList: first useful screen - processes:" << processList.size()
+                     << "time (ms):" << m_startupTimer.elapsed();
+        }
+    }
+
+    //the process count changed ?
+    const bool countChanged = m_processList.size() != processList.size();
+
+    //merge in one pass: m_processList is rebuilt from the front while the previous rows are consumed
+    //rowCount() and data() see the merged rows followed by the remaining previous rows,
+    //so the view reads a consistent list at every notification
+    m_previousProcessList.swap(m_processList);
+    m_processList.clear();
+    m_processList.reserve(processList.size());
+    m_previousIndex = 0;
+
+    bool rowsMoved      = false;
+    int firstChangedRow = -1;
+    int lastChangedRow  = -1;
+    int newIndex        = 0;
+    while (m_previousIndex < m_previousProcessList.size() || newIndex < processList.size())
     {
-        const auto it = std::find_if(processList.begin(),
-                                     processList.end(),
-                                     [pid](const QCpuProcess & process)
+        const int row = m_processList.size();
+
+        //the row is kept: take the new values, remember if the sampled columns changed
+        if (m_previousIndex < m_previousProcessList.size() && newIndex < processList.size() &&
+                m_previousProcessList[m_previousIndex].pid == processList[newIndex].pid)
         {
-            return process.pid == pid;
-        });
+            const QCpuProcess& process = m_previousProcessList[m_previousIndex];
+            const QCpuProcess& update = processList[newIndex];
+            if (!(process.cpuUsageInPercent == update.cpuUsageInPercent &&
+                  process.cpuLimitInPercent == update.cpuLimitInPercent &&
+                  process.autoLimited == update.autoLimited &&
+                  process.ioRateInBytesPerSecond == update.ioRateInBytesPerSecond &&
+                  process.ioLimitInBytesPerSecond == update.ioLimitInBytesPerSecond &&
+                  process.processor == update.processor &&
+                  process.statCounters == update.statCounters &&
+                  process.voluntaryContextSwitches == update.voluntaryContextSwitches &&
+                  process.involuntaryContextSwitches == update.involuntaryContextSwitches))
+            {
+                firstChangedRow = firstChangedRow < 0 ? row : firstChangedRow;
+                lastChangedRow  = row;
+            }
 
-        if (it != processList.end())
+            m_processList.push_back(update);
+            ++m_previousIndex;
+            ++newIndex;
+            continue;
+        }
+
+        //a run of removed rows, up to the next new pid
+        if (m_previousIndex < m_previousProcessList.size() &&
+                (newIndex >= processList.size() || m_previousProcessList[m_previousIndex].pid < processList[newIndex].pid))
         {
-            beginInsertRows(QModelIndex(), m_processList.size(), m_processList.size());
-            m_processList.push_back(*it);
-            endInsertRows();
+            int last = m_previousIndex;
+            while (last < m_previousProcessList.size() &&
+                   (newIndex >= processList.size() || m_previousProcessList[last].pid < processList[newIndex].pid))
+            {
+                //drop the metadata of the process
+                m_metadataMap.remove(m_previousProcessList[last].pid);
+                m_requestedMetadataSet.remove(m_previousProcessList[last].pid);
+                ++last;
+            }
+
+            beginRemoveRows(QModelIndex(), row, row + last - m_previousIndex - 1);
+            m_previousIndex = last;
+            endRemoveRows();
+            rowsMoved = true;
+            continue;
         }
-    });
 
-    //update the CpuUsage and CpuLimit columns
-    int index = 0;
-    std::for_each(m_processList.begin(),
-                  m_processList.end(),
-                  [this, &index, &processList](QCpuProcess & process)
-    {
-        const auto it = std::find_if(processList.begin(),
-                                     processList.end(),
-                                     [&process](const QCpuProcess & p)
+        //a run of new rows, up to the next previous pid
+        int last = newIndex;
+        while (last < processList.size() &&
+               (m_previousIndex >= m_previousProcessList.size() || processList[last].pid < m_previousProcessList[m_previousIndex].pid))
         {
-            return p.pid == process.pid;
-        });
+            ++last;
+        }
 
-        if (it != processList.end())
+        beginInsertRows(QModelIndex(), row, row + last - newIndex - 1);
+        for (; newIndex < last; ++newIndex)
         {
-            process.cpuUsageInPercent = it->cpuUsageInPercent;
-            process.cpuLimitInPercent = it->cpuLimitInPercent;
+            m_processList.push_back(processList[newIndex]);
         }
+        endInsertRows();
+        rowsMoved = true;
+    }
 
-        emit dataChanged(createIndex(index, 2),
-                         createIndex(index, 3), {CpuUsage, CpuLimit});
+    //the previous rows are all consumed
+    m_previousProcessList.clear();
+    m_previousIndex = 0;
 
-        ++index;
-    });
+    //a single notification covers all the changed rows (the command column is skipped)
+    if (firstChangedRow >= 0)
+    {
+        emit dataChanged(createIndex(firstChangedRow, CpuUsageColumn),
+                         createIndex(lastChangedRow, ProcessorColumn),
+                         {Qt::DisplayRole, CpuUsage, CpuLimit, CpuUsageValue, CpuLimitValue, IoRate, IoRateValue, Processor});
+
+    }
+
+    //the extended columns of every row: the view reads them back for the rows it shows, which tells the source what to refresh
+    if (m_extendedStatistics && !m_processList.empty())
+    {
+        emit dataChanged(createIndex(0, StateColumn),
+                         createIndex(m_processList.size() - 1, InvoluntaryContextSwitchesColumn),
+                         {Qt::DisplayRole, State, Threads, Rss, RssValue, MinorFaults, MajorFaults,
+                          VoluntaryContextSwitches, InvoluntaryContextSwitches});
+    }
+
+    //the row numbers moved
+    if (rowsMoved)
+    {
+        rebuildRowMap();
+    }
 
     //emit the process count changed signal
     if (countChanged)
@@ -281,3 +954,188 @@ void QCpuModel::updateProcessList(const QCpuProcessList& processList,
         emit processCountChanged();
     }
 }
+
+/**
+ * @brief QCpuModel::updateProcessMetadata
+ */
+void QCpuModel::updateProcessMetadata(const QCpuProcessMetadataList& metadataList)
+{
+    //store the metadata
+    QSet<pid_t> updatedSet;
+    std::for_each(metadataList.cbegin(), metadataList.cend(), [this, &updatedSet](const QCpuProcessMetadata & metadata)
+    {
+        m_metadataMap.insert(metadata.pid, metadata);
+        m_requestedMetadataSet.remove(metadata.pid);
+        updatedSet.insert(metadata.pid);
+    });
+
+    //refresh the rows of the updated processes
+    std::for_each(updatedSet.cbegin(), updatedSet.cend(), [this](pid_t pid)
+    {
+        const int index = m_rowMap.value(pid, -1);
+        if (index >= 0)
+        {
+            emit dataChanged(createIndex(index, 0),
+                             createIndex(index, columnCount() - 1), {Qt::DisplayRole, User, Command, Cwd, Cgroup, StartTime});
+        }
+    });
+
+    //refresh the selected process
+    if (updatedSet.contains(m_selectedProcessPid))
+    {
+        m_selectedProcessMetadata = m_metadataMap.value(m_selectedProcessPid);
+        m_selectedProcessCommand  = command(m_selectedProcessMetadata);
+        emit selectedProcessCommandChanged();
+        emit selectedProcessMetadataChanged();
+    }
+}
+
+/**
+ * @brief QCpuModel::insertPendingRows
+ */
+void QCpuModel::insertPendingRows()
+{
+    //append the next chunk, the list is sorted by pid so the rows stay sorted
+    const int first = m_processList.size();
+    const int count = std::min(c_firstPaintChunkSize, m_pendingProcessList.size() - m_pendingProcessIndex);
+    if (count <= 0)
+    {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), first, first + count - 1);
+    for (int index = 0; index < count; ++index)
+    {
+        const QCpuProcess& process = m_pendingProcessList[m_pendingProcessIndex++];
+        m_rowMap.insert(process.pid, m_processList.size());
+        m_processList.push_back(process);
+    }
+    endInsertRows();
+    emit processCountChanged();
+
+    if (m_profilingEnabled && first == 0)
+    {
+        qDebug() << "QCpuModel::insertPendingRows: first rows shown - rows:" << count << "time (ms):" << m_startupTimer.elapsed();
+    }
+
+    //more rows to insert: let the view paint first
+    if (m_pendingProcessIndex < m_pendingProcessList.size())
+    {
+        m_timerPendingRowsPtr->start();
+        return;
+    }
+
+    if (m_profilingEnabled)
+    {
+        qDebug() << "QCpuModel::insertPendingRows: all rows shown - rows:" << m_processList.size() << "time (ms):" << m_startupTimer.elapsed();
+    }
+
+    m_pendingProcessList.clear();
+    m_pendingProcessIndex = 0;
+}
+
+/**
+ * @brief QCpuModel::processAt, the merged rows first, then the previous rows not merged yet
+ */
+const QCpuProcess& QCpuModel::processAt(int row) const
+{
+    if (row < m_processList.size())
+    {
+        return m_processList[row];
+    }
+
+    return m_previousProcessList[m_previousIndex + row - m_processList.size()];
+}
+
+/**
+ * @brief QCpuModel::rebuildRowMap
+ */
+void QCpuModel::rebuildRowMap()
+{
+    m_rowMap.clear();
+    m_rowMap.reserve(m_processList.size());
+
+    for (int index = 0; index < m_processList.size(); ++index)
+    {
+        m_rowMap.insert(m_processList[index].pid, index);
+    }
+}
+
+/**
+ * @brief QCpuModel::metadata
+ */
+const QCpuProcessMetadata* QCpuModel::metadata(pid_t pid) const
+{
+    //already loaded?
+    auto metadataIt = m_metadataMap.constFind(pid);
+    if (metadataIt != m_metadataMap.constEnd())
+    {
+        return &metadataIt.value();
+    }
+
+    //request it once, the view is refreshed when it arrives
+    if (!m_requestedMetadataSet.contains(pid))
+    {
+        m_requestedMetadataSet.insert(pid);
+        m_pendingMetadataList.push_back(pid);
+        m_timerMetadataRequestPtr->start();
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief QCpuModel::command
+ */
+QString QCpuModel::command(const QCpuProcessMetadata& metadata) const
+{
+    //kernel threads have no command line: show the name between brackets like ps does
+    if (metadata.commandLine.isEmpty() && metadata.nameId != 0)
+    {
+        return QString("[%1]").arg(m_stringPoolPtr->string(metadata.nameId));
+    }
+
+    return metadata.commandLine;
+}
+
+/**
+ * @brief QCpuModel::requestShownStatistics
+ */
+void QCpuModel::requestShownStatistics()
+{
+    //the same rows are shown most of the time: only send a change
+    if (!m_extendedStatistics || m_shownStatisticsSet == m_requestedStatisticsSet)
+    {
+        m_shownStatisticsSet.clear();
+        return;
+    }
+
+    m_requestedStatisticsSet = m_shownStatisticsSet;
+    m_shownStatisticsSet.clear();
+
+    //the context switches and counters are read for these rows only
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "requestProcessStatistics",
+                              Qt::QueuedConnection,
+                              Q_ARG(PidList, m_requestedStatisticsSet.values()));
+}
+
+/**
+ * @brief QCpuModel::requestPendingMetadata
+ */
+void QCpuModel::requestPendingMetadata()
+{
+    //nothing to request ?
+    if (m_pendingMetadataList.isEmpty())
+    {
+        return;
+    }
+
+    //request the metadata of the rows shown by the view
+    QMetaObject::invokeMethod(m_cpuSourcePtr,
+                              "requestProcessMetadata",
+                              Qt::QueuedConnection,
+                              Q_ARG(PidList, m_pendingMetadataList));
+
+    m_pendingMetadataList.clear();
+}
@@ -8,7 +8,10 @@
 #define QCPUMODEL_H
 
 #include <QAbstractTableModel>
+#include <QElapsedTimer>
 #include <QMetaObject>
+#include <QSet>
+#include <QTimer>
 #include "QCpuMonitor.h"
 
 /**
@@ -20,7 +23,20 @@ class QCpuModel final : public QAbstractTableModel
     Q_PROPERTY(int processCount READ processCount NOTIFY processCountChanged)
     Q_PROPERTY(int selectedProcessPid READ selectedProcessPid NOTIFY selectedProcessPidChanged)
     Q_PROPERTY(int selectedProcessCpuLimit READ selectedProcessCpuLimit NOTIFY selectedProcessCpuLimitChanged)
+    Q_PROPERTY(int selectedProcessIoLimit READ selectedProcessIoLimit NOTIFY selectedProcessIoLimitChanged)
     Q_PROPERTY(QString selectedProcessCommand READ selectedProcessCommand NOTIFY selectedProcessCommandChanged)
+    Q_PROPERTY(QString selectedProcessCwd READ selectedProcessCwd NOTIFY selectedProcessMetadataChanged)
+    Q_PROPERTY(QString selectedProcessCgroup READ selectedProcessCgroup NOTIFY selectedProcessMetadataChanged)
+    Q_PROPERTY(QString selectedProcessStartTime READ selectedProcessStartTime NOTIFY selectedProcessMetadataChanged)
+    Q_PROPERTY(bool softThrottling READ softThrottling WRITE setSoftThrottling NOTIFY softThrottlingChanged)
+    Q_PROPERTY(int sampleSource READ sampleSource WRITE setSampleSource NOTIFY sampleSourceChanged)
+    Q_PROPERTY(int descendantLimit READ descendantLimit WRITE setDescendantLimit NOTIFY descendantLimitChanged)
+    Q_PROPERTY(bool autoProtection READ autoProtection WRITE setAutoProtection NOTIFY autoProtectionChanged)
+    Q_PROPERTY(int subscription READ subscription WRITE setSubscription NOTIFY subscriptionChanged)
+    Q_PROPERTY(int refreshInterval READ refreshInterval WRITE setRefreshInterval NOTIFY refreshIntervalChanged)
+    Q_PROPERTY(QVariantList cpuLoads READ cpuLoads NOTIFY cpuLoadsChanged)
+    Q_PROPERTY(int cpuCount READ cpuCount NOTIFY cpuCountChanged)
+    Q_PROPERTY(bool extendedStatistics READ extendedStatistics WRITE setExtendedStatistics NOTIFY extendedStatisticsChanged)
 
 public:
 
@@ -31,43 +47,147 @@ public:
         CpuUsage,
         CpuLimit,
         Command,
+        Cwd,
+        Cgroup,
+        StartTime,
+        CpuUsageValue,
+        CpuLimitValue,
+        IoRate,
+        IoRateValue,
+        Processor,
+        State,
+        Threads,
+        Rss,
+        RssValue,
+        MinorFaults,
+        MajorFaults,
+        VoluntaryContextSwitches,
+        InvoluntaryContextSwitches,
     };
 
-    explicit QCpuModel();
+    enum CpuModelColumns
+    {
+        PidColumn = 0,
+        UserColumn,
+        CpuUsageColumn,
+        CpuLimitColumn,
+        IoRateColumn,
+        ProcessorColumn,
+        CommandColumn,
+        StateColumn,        // the extended statistics columns, only counted while enabled
+        ThreadsColumn,
+        RssColumn,
+        MinorFaultsColumn,
+        MajorFaultsColumn,
+        VoluntaryContextSwitchesColumn,
+        InvoluntaryContextSwitchesColumn,
+        ColumnCount,
+    };
+
+    explicit QCpuModel(QCpuSource* cpuSourcePtr = nullptr);
 
     Q_INVOKABLE void selectProcess(int index);
+    Q_INVOKABLE void selectProcessByPid(int pid);
     Q_INVOKABLE void setProcessLimit(int cpuLimit);
     Q_INVOKABLE void removeProcessLimit();
+    Q_INVOKABLE void setProcessIoLimit(int ioLimitInMiBPerSecond);
+    Q_INVOKABLE void removeProcessIoLimit();
 
     QHash<int, QByteArray> roleNames() const override;
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
     QVariant data(const QModelIndex& index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
     int processCount() const;
     int selectedProcessPid() const;
     int selectedProcessCpuLimit() const;
+    int selectedProcessIoLimit() const;
     QString selectedProcessCommand() const;
+    QString selectedProcessCwd() const;
+    QString selectedProcessCgroup() const;
+    QString selectedProcessStartTime() const;
+    bool softThrottling() const;
+    void setSoftThrottling(bool enabled);
+    int sampleSource() const;
+    void setSampleSource(int sampleSource);
+    int descendantLimit() const;
+    void setDescendantLimit(int descendantLimit);
+    bool autoProtection() const;
+    void setAutoProtection(bool enabled);
+    int subscription() const;
+    void setSubscription(int subscription);
+    int refreshInterval() const;
+    void setRefreshInterval(int refreshIntervalInMs);
+    QVariantList cpuLoads() const;
+    int cpuCount() const;
+    bool extendedStatistics() const;
+    void setExtendedStatistics(bool enabled);
 
 signals:
 
     void processCountChanged();
     void selectedProcessPidChanged();
     void selectedProcessCpuLimitChanged();
+    void selectedProcessIoLimitChanged();
     void selectedProcessCommandChanged();
+    void selectedProcessMetadataChanged();
+    void softThrottlingChanged();
+    void sampleSourceChanged();
+    void descendantLimitChanged();
+    void autoProtectionChanged();
+    void subscriptionChanged();
+    void refreshIntervalChanged();
+    void cpuLoadsChanged();
+    void cpuCountChanged();
+    void extendedStatisticsChanged();
 
 private:
 
-    void updateProcessList(const QCpuProcessList& processList,
-                           const PidList& processToAdd,
-                           const PidList& processToRemove);
+    void updateProcessList(const QCpuProcessList& processList);
+    void updateProcessMetadata(const QCpuProcessMetadataList& metadataList);
+    void updateCpuLoadList(const QCpuLoadList& cpuLoadList);
+    void rebuildRowMap();
+    const QCpuProcess& processAt(int row) const;
+    void insertPendingRows();
+    const QCpuProcessMetadata* metadata(pid_t pid) const;
+    QString command(const QCpuProcessMetadata& metadata) const;
+    void requestPendingMetadata();
+    void requestShownStatistics();
 
     int m_selectedProcessPid { -1 };
     int m_selectedProcessCpuLimit { -1 };
+    int m_selectedProcessIoLimit { -1 };
     QString m_selectedProcessCommand;
-
-    QCpuProcessList m_processList;
-    QCpuMonitor* m_cpuMonitorPtr { nullptr };
+    QCpuProcessMetadata m_selectedProcessMetadata;
+    bool m_softThrottling { true };
+    int m_sampleSource { static_cast<int>(QCpuSampleSource::SchedStat) };
+    int m_descendantLimit { static_cast<int>(QCpuDescendantLimit::None) };
+    bool m_autoProtection { false };
+    int m_subscription { static_cast<int>(QCpuSubscription::Visible) };
+    int m_refreshInterval { c_timerRefreshProcessListIntervalInMs };
+    bool m_extendedStatistics { false };
+
+    QVariantList m_cpuLoads;
+    QCpuProcessList m_processList;                      // sorted by pid, like the snapshots of the monitor
+    QCpuProcessList m_previousProcessList;              // rows not merged yet while updateProcessList runs
+    int m_previousIndex { 0 };                          // first row of m_previousProcessList not merged yet
+    QHash<pid_t, int> m_rowMap;                         // pid -> row
+    QHash<pid_t, QCpuProcessMetadata> m_metadataMap;    // loaded for the rows shown by the view only
+    mutable PidList m_pendingMetadataList;              // requested by data(), sent by requestPendingMetadata
+    mutable QSet<pid_t> m_requestedMetadataSet;         // sent to the monitor, waiting for the answer
+    mutable QSet<pid_t> m_shownStatisticsSet;           // extended statistics read by the view since the last process list
+    QSet<pid_t> m_requestedStatisticsSet;               // extended statistics refreshed by the source
+    QTimer* m_timerMetadataRequestPtr { nullptr };
+    QCpuProcessList m_pendingProcessList;               // first process list, inserted in chunks
+    int m_pendingProcessIndex { 0 };                    // next row of m_pendingProcessList to insert
+    QTimer* m_timerPendingRowsPtr { nullptr };
+    QElapsedTimer m_startupTimer;                       // time to the first useful screen, reported when profiling
+    bool m_profilingEnabled { false };
+    bool m_firstUsefulScreenReported { false };
+    QSet<pid_t> m_unseededStartupSet;                   // processes of the first list without a real sample yet, when profiling
+    std::shared_ptr<const QCpuStringPool> m_stringPoolPtr;
+    QCpuSource* m_cpuSourcePtr { nullptr };                 // the local monitor or the fleet aggregator
 };
 
 #endif // QCPUMODEL_H
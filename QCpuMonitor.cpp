@@ -6,16 +6,6 @@
 
 #include "QCpuMonitor.h"
 
-# if defined(_SC_CLK_TCK)
-#  define HZ ((double)sysconf(_SC_CLK_TCK))
-# else
-#  ifndef CLK_TCK
-#    define HZ  100.0
-#  else
-#   define HZ ((double)CLK_TCK)
-#  endif
-# endif
-
 /**
  * @brief QCpuMonitor::create
  */
@@ -46,25 +36,24 @@ QCpuMonitor* QCpuMonitor::create()
     return instancePtr;
 }
 
+/**
+ * @brief QCpuMonitor::stringPool
+ */
+std::shared_ptr<const QCpuStringPool> QCpuMonitor::stringPool() const
+{
+    return m_stringPoolPtr;
+}
+
 /**
  * @brief QCpuMonitor::~QCpuMonitor
  */
 QCpuMonitor::~QCpuMonitor() noexcept
 {
-    //the current process id
-    const pid_t currentProcessId = getpid();
+    //stop watching the CPU pressure
+    closePressureTrigger();
 
-    //send a SIGCONT signal to all processes
-    std::for_each(m_processList.constBegin(),
-                  m_processList.constEnd(),
-                  [currentProcessId](const QCpuProcess & process)
-    {
-        //send a SIGCONT signal except for the current process
-        if (process.pid != currentProcessId)
-        {
-            kill(process.pid, SIGCONT);
-        }
-    });
+    //resume the processes we limited and give back their priority
+    m_limiter.releaseLimitedProcesses();
 }
 
 /**
@@ -92,24 +81,18 @@ void QCpuMonitor::setProcessLimit(pid_t pid, int cpuLimit)
     }
 
     //find the process
-    auto processIt = std::find_if(m_processList.begin(), m_processList.end(), [pid](const QCpuProcess & process)
-    {
-        return process.pid == pid;
-    });
+    const int index = m_processTable.indexOf(pid);
 
     //check if the process is found
-    if (processIt == m_processList.end())
+    if (index < 0)
     {
         qDebug() << "QCpuMonitor::setProcessLimit: process not found - pid:" << pid;
         return;
     }
 
-    //send a SIGCONT signal to the process
-    kill(processIt->pid, SIGCONT);
-
-    //set the cpu limit
-    processIt->cpuLimitInPercent = static_cast<double>(cpuLimit) / 100.0;
-    processIt->sleepCountInCycle = 0;
+    //set the cpu limit, a manual limit replaces an automatic one and covers the descendants with the policy
+    m_processTable.cold(index).autoLimited = false;
+    applyTreeLimit(index, static_cast<double>(cpuLimit) / 100.0);
 }
 
 /**
@@ -130,24 +113,358 @@ void QCpuMonitor::removeProcessLimit(pid_t pid)
     }
 
     //find the process
-    auto processIt = std::find_if(m_processList.begin(), m_processList.end(), [pid](const QCpuProcess & process)
-    {
-        return process.pid == pid;
-    });
+    const int index = m_processTable.indexOf(pid);
 
     //check if the process is found
-    if (processIt == m_processList.end())
+    if (index < 0)
     {
         qDebug() << "QCpuMonitor::removeProcessLimit: process not found - pid:" << pid;
         return;
     }
 
-    //send a SIGCONT signal to the process
-    kill(processIt->pid, SIGCONT);
+    //remove the cpu limit, and the limits the descendants inherited from it
+    clearTreeLimit(index);
+}
+
+/**
+ * @brief QCpuMonitor::setProcessIoLimit
+ */
+void QCpuMonitor::setProcessIoLimit(pid_t pid, qint64 ioLimitInBytesPerSecond)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::setProcessIoLimit",
+               "This method must be called from the owner thread");
+
+    //ignore the action if the pid is the current process
+    if (pid == getpid())
+    {
+        qDebug() << "QCpuMonitor::setProcessIoLimit: cannot set an I/O limit for the current process";
+        return;
+    }
+
+    //check if the I/O limit is valid
+    if (ioLimitInBytesPerSecond <= 0)
+    {
+        qDebug() << "QCpuMonitor::setProcessIoLimit: invalid I/O limit - ioLimitInBytesPerSecond:" << ioLimitInBytesPerSecond;
+        return;
+    }
+
+    //find the process
+    const int index = m_processTable.indexOf(pid);
+
+    //check if the process is found
+    if (index < 0)
+    {
+        qDebug() << "QCpuMonitor::setProcessIoLimit: process not found - pid:" << pid;
+        return;
+    }
+
+    //the I/O counters are only readable with the ptrace access mode of the process
+    quint64 ioBytes = 0;
+    if (!m_timeSource.readIoBytes(pid, ioBytes))
+    {
+        qDebug() << "QCpuMonitor::setProcessIoLimit: cannot read the I/O counters - pid:" << pid;
+        return;
+    }
+
+    //set the I/O limit
+    applyIoLimit(index, static_cast<quint64>(ioLimitInBytesPerSecond));
+}
+
+/**
+ * @brief QCpuMonitor::removeProcessIoLimit
+ */
+void QCpuMonitor::removeProcessIoLimit(pid_t pid)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::removeProcessIoLimit",
+               "This method must be called from the owner thread");
+
+    //find the process
+    const int index = m_processTable.indexOf(pid);
+
+    //check if the process is found
+    if (index < 0)
+    {
+        qDebug() << "QCpuMonitor::removeProcessIoLimit: process not found - pid:" << pid;
+        return;
+    }
+
+    //remove the I/O limit
+    clearIoLimit(index);
+}
+
+/**
+ * @brief QCpuMonitor::requestProcessMetadata
+ */
+void QCpuMonitor::requestProcessMetadata(const PidList pidList)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::requestProcessMetadata",
+               "This method must be called from the owner thread");
+
+    //create the list
+    QCpuProcessMetadataList metadataList;
+    metadataList.reserve(pidList.size());
+
+    //loop through the requested processes
+    std::for_each(pidList.constBegin(), pidList.constEnd(), [this, &metadataList](pid_t pid)
+    {
+        //find the process
+        const int index = m_processTable.indexOf(pid);
+
+        //the process is gone, the model drops it at the next update
+        if (index < 0)
+        {
+            return;
+        }
+
+        //the cache is keyed by pid and start time: a reused pid is a different process
+        const quint64 startTimeInTicks = m_processTable.cold(index).startTimeInTicks;
+        auto cacheIt = m_metadataCache.find(pid);
+        if (cacheIt == m_metadataCache.end() || cacheIt->startTimeInTicks != startTimeInTicks)
+        {
+            QCpuProcessMetadata metadata;
+            metadata.pid              = pid;
+            metadata.startTimeInTicks = startTimeInTicks;
+            readProcessMetadata(metadata);
+            cacheIt = m_metadataCache.insert(pid, metadata);
+        }
+
+        metadataList.push_back(cacheIt.value());
+    });
+
+    //emit the signal
+    emit updateProcessMetadata(metadataList);
+}
+
+/**
+ * @brief QCpuMonitor::requestProcessStatistics
+ */
+void QCpuMonitor::requestProcessStatistics(const PidList pidList)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::requestProcessStatistics",
+               "This method must be called from the owner thread");
+
+    //the rows scrolled out of the view drop their counters, so that they are never sent stale once shown again
+    const QSet<pid_t> pidSet(pidList.constBegin(), pidList.constEnd());
+    std::for_each(m_statisticsPidSet.constBegin(), m_statisticsPidSet.constEnd(), [this, &pidSet](pid_t pid)
+    {
+        const int index = m_processTable.indexOf(pid);
+        if (index < 0 || pidSet.contains(pid))
+        {
+            return;
+        }
+
+        QCpuProcessColdState& coldState = m_processTable.cold(index);
+        coldState.statCounters               = QCpuStatCounters();
+        coldState.voluntaryContextSwitches   = 0;
+        coldState.involuntaryContextSwitches = 0;
+    });
+
+    //read from the next refresh on
+    m_statisticsPidSet = pidSet;
+}
+
+/**
+ * @brief QCpuMonitor::setSoftThrottling
+ */
+void QCpuMonitor::setSoftThrottling(bool enabled)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::setSoftThrottling",
+               "This method must be called from the owner thread");
+
+    //update the policy, the limited processes pick it up at their next evaluation
+    m_limiter.setSoftThrottling(enabled);
+}
+
+/**
+ * @brief QCpuMonitor::setAutoProtection
+ */
+void QCpuMonitor::setAutoProtection(bool enabled)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::setAutoProtection",
+               "This method must be called from the owner thread");
+
+    //nothing changed?
+    if (m_autoProtectionEnabled == enabled)
+    {
+        return;
+    }
+
+    m_autoProtectionEnabled = enabled;
+
+    //disabled: lift every automatic limit and stop watching the pressure
+    if (!enabled)
+    {
+        closePressureTrigger();
+        m_timerPressurePtr->stop();
+
+        for (int index = 0; index < m_processTable.size(); ++index)
+        {
+            if (m_processTable.cold(index).autoLimited)
+            {
+                clearCpuLimit(index);
+            }
+        }
+
+        m_underPressure = false;
+        return;
+    }
+
+    //enabled: use the PSI trigger when the kernel supports it, poll /proc/stat otherwise
+    if (!openPressureTrigger())
+    {
+        qDebug() << "QCpuMonitor::setAutoProtection: PSI is not available, falling back to /proc/stat";
+        m_timerPressurePtr->start();
+    }
+}
+
+/**
+ * @brief QCpuMonitor::setSubscription
+ */
+void QCpuMonitor::setSubscription(int subscription)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::setSubscription",
+               "This method must be called from the owner thread");
+
+    //check if the subscription is valid
+    if (subscription < static_cast<int>(QCpuSubscription::Visible) ||
+            subscription > static_cast<int>(QCpuSubscription::Hidden))
+    {
+        qDebug() << "QCpuMonitor::setSubscription: invalid subscription - subscription:" << subscription;
+        return;
+    }
+
+    //nothing changed?
+    const QCpuSubscription previousSubscription = m_subscription;
+    m_subscription = static_cast<QCpuSubscription>(subscription);
+    if (previousSubscription == m_subscription)
+    {
+        return;
+    }
+
+    //the GUI is shown again: refresh it now instead of waiting for the next refresh
+    if (m_subscription == QCpuSubscription::Visible && m_timerMonitorCpuPtr)
+    {
+        m_timerMonitorCpuPtr->stop();
+        timeoutCpuMonitor();
+    }
+}
+
+/**
+ * @brief QCpuMonitor::setRefreshInterval
+ */
+void QCpuMonitor::setRefreshInterval(int refreshIntervalInMs)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::setRefreshInterval",
+               "This method must be called from the owner thread");
+
+    //check if the interval is valid
+    if (refreshIntervalInMs < c_minRefreshProcessListIntervalInMs ||
+            refreshIntervalInMs > c_maxRefreshProcessListIntervalInMs)
+    {
+        qDebug() << "QCpuMonitor::setRefreshInterval: invalid refresh interval - refreshIntervalInMs:" << refreshIntervalInMs;
+        return;
+    }
+
+    //the timer is created by start: remember the interval until then
+    m_refreshIntervalInMs = refreshIntervalInMs;
+    if (!m_timerMonitorCpuPtr)
+    {
+        return;
+    }
+
+    //restart the timer so that a shorter interval applies immediately
+    m_timerMonitorCpuPtr->start(refreshIntervalInMs);
+}
+
+/**
+ * @brief QCpuMonitor::setSampleSource
+ */
+void QCpuMonitor::setSampleSource(int sampleSource)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::setSampleSource",
+               "This method must be called from the owner thread");
+
+    //check if the source is valid
+    if (sampleSource != static_cast<int>(QCpuSampleSource::StatTicks) &&
+            sampleSource != static_cast<int>(QCpuSampleSource::SchedStat))
+    {
+        qDebug() << "QCpuMonitor::setSampleSource: invalid sample source - sampleSource:" << sampleSource;
+        return;
+    }
+
+    //update the source, each process takes a new baseline at its next sample
+    m_limiter.setSampleSource(static_cast<QCpuSampleSource>(sampleSource));
+}
+
+/**
+ * @brief QCpuMonitor::setDescendantLimit
+ */
+void QCpuMonitor::setDescendantLimit(int descendantLimit)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::setDescendantLimit",
+               "This method must be called from the owner thread");
+
+    //check if the policy is valid
+    if (descendantLimit < static_cast<int>(QCpuDescendantLimit::None) ||
+            descendantLimit > static_cast<int>(QCpuDescendantLimit::Share))
+    {
+        qDebug() << "QCpuMonitor::setDescendantLimit: invalid descendant limit - descendantLimit:" << descendantLimit;
+        return;
+    }
+
+    //the running descendants of the limited processes are updated now, the new ones on discovery
+    m_limiter.setDescendantLimit(static_cast<QCpuDescendantLimit>(descendantLimit));
+    scheduleSampleCpuTime();
+    scheduleControlCpuLimit();
+}
 
-    //remove the cpu limit
-    processIt->cpuLimitInPercent.reset();
-    processIt->sleepCountInCycle = 0;
+/**
+ * @brief QCpuMonitor::setExtendedStatistics
+ */
+void QCpuMonitor::setExtendedStatistics(bool enabled)
+{
+    //check if the method is called from the owner thread
+    Q_ASSERT_X(QThread::currentThread() == thread(),
+               "QCpuMonitor::setExtendedStatistics",
+               "This method must be called from the owner thread");
+
+    //the counters cost one or two more files per process and refresh: only read them while shown
+    m_extendedStatisticsEnabled = enabled;
+    m_limiter.setStatCounters(enabled);
+    m_statisticsTimestampInNs = m_clock.monotonicInNs();   // the samples taken before didn't keep their counters
+
+    //hidden counters are dropped, so that they are never sent stale once shown again
+    if (!enabled)
+    {
+        m_statisticsPidSet.clear();
+        for (int index = 0; index < m_processTable.size(); ++index)
+        {
+            QCpuProcessColdState& coldState = m_processTable.cold(index);
+            coldState.statCounters               = QCpuStatCounters();
+            coldState.voluntaryContextSwitches   = 0;
+            coldState.involuntaryContextSwitches = 0;
+        }
+    }
 }
 
 /**
@@ -160,24 +477,61 @@ void QCpuMonitor::start() noexcept
                "QCpuMonitor::start",
                "This method must be called from the owner thread");
 
+    //report the cycle times?
+    m_profilingEnabled = qEnvironmentVariableIntValue("QTCPULIMIT_PROFILE") != 0;
+
     //scan the users
     scanUsers();
 
-    //create the m_timerMonitorCpuPtr timer
+    //scan the boot time
+    scanBootTime();
+
+    //create the m_timerMonitorCpuPtr timer, started by the first refresh
     m_timerMonitorCpuPtr = new QTimer(this);
-    m_timerMonitorCpuPtr->setInterval(c_timerRefreshProcessListIntervalInMs);
+    m_timerMonitorCpuPtr->setInterval(m_refreshIntervalInMs);
     m_timerMonitorCpuPtr->setTimerType(Qt::PreciseTimer);
     m_timerMonitorCpuPtr->setSingleShot(true);
     connect(m_timerMonitorCpuPtr, &QTimer::timeout, this, &QCpuMonitor::timeoutCpuMonitor);
-    m_timerMonitorCpuPtr->start();
 
-    //create the m_timerLimitCpuPtr timer
+    //create the m_timerSampleCpuPtr timer, armed on demand by scheduleSampleCpuTime
+    m_timerSampleCpuPtr = new QTimer(this);
+    m_timerSampleCpuPtr->setTimerType(Qt::PreciseTimer);
+    m_timerSampleCpuPtr->setSingleShot(true);
+    connect(m_timerSampleCpuPtr, &QTimer::timeout, this, &QCpuMonitor::timeoutSampleCpuTime);
+
+    //create the m_timerSystemLoadPtr timer
+    m_timerSystemLoadPtr = new QTimer(this);
+    m_timerSystemLoadPtr->setInterval(c_timerSystemLoadIntervalInMs);
+    m_timerSystemLoadPtr->setTimerType(Qt::CoarseTimer);
+    m_timerSystemLoadPtr->setSingleShot(true);
+    connect(m_timerSystemLoadPtr, &QTimer::timeout, this, &QCpuMonitor::timeoutSystemLoad);
+    m_timerSystemLoadPtr->start();
+
+    //create the m_timerPressurePtr timer, only running while the system is protected
+    m_timerPressurePtr = new QTimer(this);
+    m_timerPressurePtr->setInterval(c_timerPressureIntervalInMs);
+    m_timerPressurePtr->setTimerType(Qt::CoarseTimer);
+    m_timerPressurePtr->setSingleShot(true);
+    connect(m_timerPressurePtr, &QTimer::timeout, this, &QCpuMonitor::timeoutPressure);
+
+    //create the m_timerLimitCpuPtr timer, armed on demand by scheduleControlCpuLimit
     m_timerLimitCpuPtr = new QTimer(this);
-    m_timerLimitCpuPtr->setInterval(c_timerCpuLimitIntervalInMs);
     m_timerLimitCpuPtr->setTimerType(Qt::PreciseTimer);
     m_timerLimitCpuPtr->setSingleShot(true);
     connect(m_timerLimitCpuPtr, &QTimer::timeout, this, &QCpuMonitor::timeoutControlCpuLimit);
-    m_timerLimitCpuPtr->start();
+
+    //first paint: send the processes now rather than after a whole refresh interval
+    const quint64 firstScanStartInNs = m_clock.monotonicInNs();
+    scanRunningProcesses();
+
+    if (m_profilingEnabled)
+    {
+        qDebug() << "QCpuMonitor::start: first scan - processes:" << m_processTable.size()
+                 << "time (ms):" << (m_clock.monotonicInNs() - firstScanStartInNs) / 1'000'000.0;
+    }
+
+    //the next process list carries the usages seeded by the first sample of each process
+    QTimer::singleShot(c_firstRefreshDelayInMs, this, &QCpuMonitor::timeoutCpuMonitor);
 }
 
 /**
@@ -233,8 +587,8 @@ void QCpuMonitor::scanUsers() noexcept
             continue;
         }
 
-        //add the user to the map
-        m_userMap.insert(userId, userName);
+        //add the user to the map, the name is interned once for all its processes
+        m_userMap.insert(userId, m_stringPoolPtr->intern(userName));
     }
 
     //close the password file
@@ -242,363 +596,580 @@ void QCpuMonitor::scanUsers() noexcept
 }
 
 /**
- * @brief QCpuMonitor::scanRunningProcesses
+ * @brief QCpuMonitor::scanBootTime
  */
-void QCpuMonitor::scanRunningProcesses() noexcept
+void QCpuMonitor::scanBootTime() noexcept
 {
-    //utility function to return all running processes
-    auto getRunningProcesses = [this]() -> PidList
-    {
-        //create the list
-        PidList ret;
+    //create the stat file object
+    QFile statFile("/proc/stat");
 
-        //loop "/proc/[pid]/stat" files. PID should be a number
-        QDirIterator it("/proc", QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks | QDir::Readable, QDirIterator::NoIteratorFlags);
+    //try to open the stat file
+    if (!statFile.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "QCpuMonitor::scanBootTime: cannot open the stat file";
+        return;
+    }
 
-        //loop through the directories
-        while (it.hasNext())
+    //look for "btime <seconds since epoch>"
+    while (!statFile.atEnd())
+    {
+        const QByteArray line = statFile.readLine();
+        if (line.startsWith("btime "))
         {
-            //get the next directory
-            const QString dir = it.next();
-
-            //get the pid
-            const QString pidStr = dir.section('/', -1);
-
-            //check if the pid is a number
-            bool ok = false;
-            const int pid = pidStr.toInt(&ok);
-            if (!ok || pid < 0)
-            {
-                continue;
-            }
-
-            //add the pid to the list
-            ret.push_back(pid);
+            m_bootTimestampInMs = line.mid(6).trimmed().toULongLong() * 1000;
+            break;
         }
+    }
 
-        //return the list
-        return ret;
-    };
+    //close the stat file
+    statFile.close();
+}
 
-    //utility function to read command and user
-    auto readCommandAndUser = [this](QCpuProcess & process)
-    {
-        //the status file path
-        const QString statusFilePath = QString("/proc/%1/status").arg(process.pid);
+/**
+ * @brief QCpuMonitor::scanRunningProcesses
+ */
+void QCpuMonitor::scanRunningProcesses() noexcept
+{
+    //discover the new processes and drop the exited ones
+    PidList processToRemove;
+    PidList processChanged;
+    m_limiter.scanRunningProcesses(processToRemove, processChanged);
 
-        //create the status file object
-        QFile statusFile(statusFilePath);
+    //forget the metadata of the removed processes
+    std::for_each(processToRemove.constBegin(), processToRemove.constEnd(), [this](pid_t pid)
+    {
+        m_metadataCache.remove(pid);
+        m_statisticsPidSet.remove(pid);
+    });
 
-        //try to open the status file
-        if (!statusFile.open(QFile::ReadOnly))
+    //reload the metadata sent to the model for the reused pids and the processes that exec'd
+    QCpuProcessMetadataList metadataList;
+    std::for_each(processChanged.constBegin(), processChanged.constEnd(), [this, &metadataList](pid_t pid)
+    {
+        const int index = m_processTable.indexOf(pid);
+        auto cacheIt = m_metadataCache.find(pid);
+        if (index < 0 || cacheIt == m_metadataCache.end())
         {
-            qDebug() << "QCpuMonitor::scanRunningProcesses: cannot open the status file - pid:" << process.pid;
             return;
         }
 
-        //read the status file content
-        const QString statusFileContent = statusFile.readAll();
+        QCpuProcessMetadata metadata;
+        metadata.pid              = pid;
+        metadata.startTimeInTicks = m_processTable.cold(index).startTimeInTicks;
+        readProcessMetadata(metadata);
+        cacheIt.value() = metadata;
+        metadataList.push_back(metadata);
+    });
 
-        //close the status file
-        statusFile.close();
+    if (!metadataList.isEmpty())
+    {
+        emit updateProcessMetadata(metadataList);
+    }
+
+    //the new processes may be due before the current deadlines, and may have inherited a limit
+    scheduleSampleCpuTime();
+    scheduleControlCpuLimit();
+
+    //send the process list according to the subscription of the GUI, the limiting is not affected
+    ++m_refreshCount;
+    const bool sendProcessList = m_subscription == QCpuSubscription::Visible ||
+                                 (m_subscription == QCpuSubscription::Hidden && m_refreshCount % c_hiddenRefreshDecimation == 0);
 
-        //split the content by line
-        const QStringList statusFileContentList = statusFileContent.split('\n');
+    //emit the signals, the snapshot is sorted by pid so the model can merge it in linear time
+    if (sendProcessList)
+    {
+        scanProcessStatistics();
+        emit updateProcessList(m_processTable.snapshot());
+        emit updateCpuLoadList(m_limiter.cpuLoadList());
+    }
+}
+
+/**
+ * @brief QCpuMonitor::readProcessMetadata
+ */
+void QCpuMonitor::readProcessMetadata(QCpuProcessMetadata& metadata) noexcept
+{
+    //the process directory
+    const QString processDir = QString("/proc/%1/").arg(metadata.pid);
 
+    //read the name and the user from the status file
+    QFile statusFile(processDir + "status");
+    if (statusFile.open(QFile::ReadOnly))
+    {
         //don't go through all the keys
         bool nameSet = false;
         bool uidSet  = false;
 
         //loop through the lines
-        for (const QString& line : statusFileContentList)
+        while (!statusFile.atEnd() && !(nameSet && uidSet))
         {
             //split the line
-            const QStringList splitList = line.split(':');
-
-            //check if the line is valid
-            if (splitList.size() < 2)
-            {
-                continue;
-            }
-
-            //get the key
-            const QString key = splitList[0];
-
-            //get the value
-            const QString value = splitList[1].trimmed();
+            const QString line = QString::fromUtf8(statusFile.readLine());
+            const QString key = line.section(':', 0, 0);
+            const QString value = line.section(':', 1).trimmed();
 
             //check if the key is valid
             if (key == "Name")
             {
-                process.command = value;
+                metadata.nameId = m_stringPoolPtr->intern(value);
                 nameSet = true;
             }
             else if (key == "Uid")
             {
-                //get the user id
+                //find the user
                 bool ok = false;
                 const int userId = value.section('\t', 0, 0).toInt(&ok);
-                if (!ok || userId < 0)
-                {
-                    continue;
-                }
-
-                //find the user
                 auto userIt = m_userMap.constFind(userId);
-                if (userIt != m_userMap.constEnd())
+                if (ok && userIt != m_userMap.constEnd())
                 {
-                    process.user = userIt.value();
+                    metadata.userId = userIt.value();
                 }
 
                 uidSet = true;
             }
+        }
+
+        statusFile.close();
+    }
+    else
+    {
+        qDebug() << "QCpuMonitor::readProcessMetadata: cannot open the status file - pid:" << metadata.pid;
+    }
+
+    //read the full command line, the arguments are separated by '\0'
+    //kernel threads have none: the model shows the name instead
+    QFile cmdlineFile(processDir + "cmdline");
+    if (cmdlineFile.open(QFile::ReadOnly))
+    {
+        QByteArray cmdline = cmdlineFile.read(c_maxCommandLineLength);
+        cmdlineFile.close();
+
+        while (cmdline.endsWith('\0'))
+        {
+            cmdline.chop(1);
+        }
+
+        metadata.commandLine = QString::fromUtf8(cmdline.replace('\0', ' '));
+    }
+
+    //read the current working directory
+    metadata.cwd = QFile::symLinkTarget(processDir + "cwd");
+
+    //read the cgroup, the unified hierarchy line is "0::/path"
+    QFile cgroupFile(processDir + "cgroup");
+    if (cgroupFile.open(QFile::ReadOnly))
+    {
+        QString cgroup;
+        while (!cgroupFile.atEnd())
+        {
+            const QString line = QString::fromUtf8(cgroupFile.readLine()).trimmed();
+            cgroup = line.section(':', 2);
 
-            if (nameSet && uidSet)
+            if (line.startsWith("0::"))
             {
                 break;
             }
         }
-    };
 
-    //get all running processes
-    const PidList runningProcesses = getRunningProcesses();
+        cgroupFile.close();
+        metadata.cgroup = cgroup;
+    }
 
-    //create the lists
-    PidList processToAdd;
-    PidList processToRemove;
+    //convert the start time (ticks since boot) to a wall clock timestamp
+    metadata.startTimestampInMs = m_bootTimestampInMs + static_cast<quint64>(metadata.startTimeInTicks * 1000 / HZ);
+}
 
-    //remove all processes that are not running anymore
-    std::remove_if(m_processList.begin(), m_processList.end(), [&runningProcesses, &processToRemove](const QCpuProcess & process)
-    {
-        const bool toRemove = std::find(runningProcesses.constBegin(), runningProcesses.constEnd(), process.pid) == runningProcesses.constEnd();
+/**
+ * @brief QCpuMonitor::scanSystemLoad
+ */
+void QCpuMonitor::scanSystemLoad() noexcept
+{
+    //the limiter reads /proc/stat: the contention decides if an over-limit process is stopped or only demoted
+    m_limiter.scanSystemLoad();
+}
 
-        if (toRemove)
+/**
+ * @brief QCpuMonitor::scanProcessStatistics
+ */
+void QCpuMonitor::scanProcessStatistics() noexcept
+{
+    //the stat sampler records the CPU at every sample, the schedstat sampler doesn't read it
+    //refresh the CPU of the active processes only: an idle process doesn't load its CPU
+    for (int index = 0; index < m_processTable.size(); ++index)
+    {
+        QCpuProcessHotState& process = m_processTable.hot(index);
+        if (process.sampleSource == QCpuSampleSource::StatTicks || process.cpuUsageInPercent < c_sampleActivityThreshold)
         {
-            processToRemove.push_back(process.pid);
+            continue;
         }
 
-        return toRemove;
-    });
-
-    //add new processes
-    std::for_each(runningProcesses.constBegin(), runningProcesses.constEnd(), [this, readCommandAndUser, &processToAdd](pid_t pid)
-    {
-        //check if the process is already in the list
-        auto it = std::find_if(m_processList.constBegin(), m_processList.constEnd(), [pid](const QCpuProcess & process)
+        //a shown row gets its CPU with the extended statistics below, from the same read
+        if (m_extendedStatisticsEnabled && m_statisticsPidSet.contains(process.pid))
         {
-            return process.pid == pid;
-        });
+            continue;
+        }
 
-        if (it != m_processList.constEnd()) //process already in the list
+        QCpuStatSample statSample;
+        if (m_timeSource.readStat(process.pid, statSample))
         {
-            return;
+            process.processor = statSample.processor;
         }
+    }
 
-        //create the process
-        QCpuProcess process;
-        process.pid                       = pid;
-        process.lastMeasuredTimestampInMs = QDateTime::currentMSecsSinceEpoch();
+    //the extended statistics of the rows shown by the view only
+    const quint64 nowInNs = m_clock.monotonicInNs();
+    if (m_extendedStatisticsEnabled)
+    {
+        std::for_each(m_statisticsPidSet.constBegin(), m_statisticsPidSet.constEnd(), [this](pid_t pid)
+        {
+            const int index = m_processTable.indexOf(pid);
+            if (index < 0)
+            {
+                return;
+            }
 
-        //read the command and the user
-        readCommandAndUser(process);
+            //the stat sampler kept the counters of the rows it sampled since the previous refresh
+            QCpuProcessHotState& process = m_processTable.hot(index);
+            QCpuProcessColdState& coldState = m_processTable.cold(index);
+            if (process.sampleSource != QCpuSampleSource::StatTicks ||
+                    process.lastMeasuredTimestampInNs < m_statisticsTimestampInNs)
+            {
+                QCpuStatSample statSample;
+                if (!m_timeSource.readStat(pid, statSample))
+                {
+                    return;
+                }
 
-        //add the process to the list
-        m_processList.push_back(process);
+                process.processor = statSample.processor;
+                coldState.statCounters = statSample.counters;
+            }
 
-        //add the process to the list
-        processToAdd.push_back(pid);
-    });
+            //the context switches live in /proc/[pid]/status, a second read
+            m_timeSource.readContextSwitches(pid, coldState.voluntaryContextSwitches, coldState.involuntaryContextSwitches);
+        });
+    }
 
-    //emit the signal
-    emit updateProcessList(m_processList, processToAdd, processToRemove);
+    m_statisticsTimestampInNs = nowInNs;
 }
 
 /**
- * @brief QCpuMonitor::scanProcessCpuTime
+ * @brief QCpuMonitor::openPressureTrigger
  */
-void QCpuMonitor::scanProcessCpuTime(quint64 now, QCpuProcess& process) noexcept
+bool QCpuMonitor::openPressureTrigger() noexcept
 {
-    //calculate the elapsed time since the last measurement
-    //update each 20ms
-    constexpr quint64 refreshIntervalInMs = 20;
-    quint64 elapsed = now - process.lastMeasuredTimestampInMs;
+    //already opened?
+    if (m_pressureFd >= 0)
+    {
+        return true;
+    }
 
-    if (elapsed < refreshIntervalInMs)
+    //open the PSI file, the trigger lives as long as the file descriptor
+    const int fd = ::open("/proc/pressure/cpu", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
     {
-        return;
+        return false;
     }
 
-    //create the stat file path
-    const QString statFilePath = QString("/proc/%1/stat").arg(process.pid);
+    //register the trigger: "some <stall in us> <window in us>"
+    const QByteArray trigger = QString("some %1 %2").arg(c_psiTriggerStallInUs).arg(c_psiTriggerWindowInUs).toLatin1();
+    if (::write(fd, trigger.constData(), static_cast<size_t>(trigger.size()) + 1) < 0)
+    {
+        qDebug() << "QCpuMonitor::openPressureTrigger: cannot register the PSI trigger - errno:" << errno;
+        ::close(fd);
+        return false;
+    }
 
-    //create the stat file object
-    QFile statFile(statFilePath);
+    //the kernel signals the trigger with POLLPRI, which is QSocketNotifier::Exception
+    m_pressureFd = fd;
+    m_pressureNotifierPtr = new QSocketNotifier(fd, QSocketNotifier::Exception, this);
+    connect(m_pressureNotifierPtr,
+            qOverload<QSocketDescriptor, QSocketNotifier::Type>(&QSocketNotifier::activated),
+            this,
+            &QCpuMonitor::protectSystem);
+    return true;
+}
 
-    //try to open the stat file
-    if (!statFile.open(QIODevice::ReadOnly))
+/**
+ * @brief QCpuMonitor::closePressureTrigger
+ */
+void QCpuMonitor::closePressureTrigger() noexcept
+{
+    //delete the notifier before closing the file descriptor
+    delete m_pressureNotifierPtr;
+    m_pressureNotifierPtr = nullptr;
+
+    if (m_pressureFd >= 0)
     {
-        return;
+        ::close(m_pressureFd);
+        m_pressureFd = -1;
     }
+}
 
-    //create the text stream
-    QTextStream textStream(&statFile);
+/**
+ * @brief QCpuMonitor::readPressureAverage
+ */
+bool QCpuMonitor::readPressureAverage(double& averageInPercent) noexcept
+{
+    //create the PSI file object
+    QFile pressureFile("/proc/pressure/cpu");
 
-    //read the first line
-    const QString line = textStream.readLine();
+    //try to open the PSI file
+    if (!pressureFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
 
-    //close the stat file
-    statFile.close();
+    //read the first line: "some avg10=1.23 avg60=0.50 avg300=0.10 total=123456"
+    const QString line = QString::fromLatin1(pressureFile.readLine());
+
+    //close the PSI file
+    pressureFile.close();
+
+    //extract avg10
+    bool ok = false;
+    averageInPercent = line.section("avg10=", 1, 1).section(' ', 0, 0).toDouble(&ok);
+    return ok;
+}
 
-    //check if the line is valid
-    if (line.isEmpty())
+/**
+ * @brief QCpuMonitor::protectSystem
+ */
+void QCpuMonitor::protectSystem() noexcept
+{
+    //the protection has been disabled in the meantime
+    if (!m_autoProtectionEnabled)
     {
-        qDebug() << "QCpuMonitor::scanProcessCpuTime: cannot read the stat file - pid:" << process.pid;
         return;
     }
 
-    //scan the line
-    const auto str = line.toStdString();
-    char* buf = const_cast<char*>(str.c_str());
+    //the current process id
+    const pid_t currentProcessId = getpid();
 
-    /* (1) pid -  %d */
-    char* location = strchr(buf, ' ');
-    if (!location)
+    //find the heaviest non-exempt process without a limit
+    //exempt: ourselves, init, kthreadd and the kernel threads, and the processes limited by the user
+    int victimIndex = -1;
+    for (int index = 0; index < m_processTable.size(); ++index)
     {
-        return;
+        const QCpuProcessHotState& process = m_processTable.hot(index);
+        if (process.pid == currentProcessId || process.pid <= 2 || m_processTable.cold(index).ppid == 2 ||
+                process.cpuLimitInPercent.has_value() ||
+                process.cpuUsageInPercent < c_autoProtectionMinUsageInPercent)
+        {
+            continue;
+        }
+
+        if (victimIndex < 0 || process.cpuUsageInPercent > m_processTable.hot(victimIndex).cpuUsageInPercent)
+        {
+            victimIndex = index;
+        }
     }
 
-    /* (2) comm - (%s) */
-    location += 2;
-    char* end = strrchr(location, ')');
-    if (!end)
+    //we are under pressure: watch for the recovery
+    m_underPressure = true;
+    m_timerPressurePtr->start();
+
+    //nobody to limit
+    if (victimIndex < 0)
     {
         return;
     }
 
-    location = end + 2;
+    //limit the victim to a share of its current usage, one victim per pressure event
+    const QCpuProcessHotState& victim = m_processTable.hot(victimIndex);
+    const double cpuLimitInPercent = std::clamp(victim.cpuUsageInPercent * c_autoProtectionLimitRatio, 0.05, 1.0);
+    qDebug() << "QCpuMonitor::protectSystem: CPU pressure, limiting - pid:" << victim.pid << "limit:" << cpuLimitInPercent;
 
-    /* (3) state - %c */
-    location += 2;
+    m_processTable.cold(victimIndex).autoLimited = true;
+    applyCpuLimit(victimIndex, cpuLimitInPercent);
+}
 
-    /* (4) ppid - %d */
-    strtol(location, &location, 10);
-    location += 1;
+/**
+ * @brief QCpuMonitor::relaxSystem
+ */
+void QCpuMonitor::relaxSystem() noexcept
+{
+    //lift the automatic limit of the lightest process, one per check
+    int lightestIndex = -1;
+    for (int index = 0; index < m_processTable.size(); ++index)
+    {
+        if (!m_processTable.cold(index).autoLimited)
+        {
+            continue;
+        }
 
-    /* (5) pgrp - %d */
-    strtol(location, &location, 10);
-    location += 1;
+        if (lightestIndex < 0 || m_processTable.hot(index).cpuUsageInPercent < m_processTable.hot(lightestIndex).cpuUsageInPercent)
+        {
+            lightestIndex = index;
+        }
+    }
 
-    /* (6) session - %d */
-    strtol(location, &location, 10);
-    location += 1;
+    //no more automatic limits: the pressure is gone
+    if (lightestIndex < 0)
+    {
+        m_underPressure = false;
+        return;
+    }
 
-    /* (7) tty_nr - %d */
-    strtoul(location, &location, 10);
-    location += 1;
+    qDebug() << "QCpuMonitor::relaxSystem: CPU pressure cleared, lifting the limit - pid:" << m_processTable.hot(lightestIndex).pid;
+    clearCpuLimit(lightestIndex);
+}
 
-    /* (8) tpgid - %d */
-    strtol(location, &location, 10);
-    location += 1;
+/**
+ * @brief QCpuMonitor::scheduleSampleCpuTime
+ */
+void QCpuMonitor::scheduleSampleCpuTime() noexcept
+{
+    //get the next deadline
+    const std::optional<quint64> deadline = m_limiter.nextSampleDeadlineInNs();
 
-    /* Skip (9) flags - %u */
-    location = strchr(location, ' ') + 1;
+    //nothing to sample
+    if (!deadline.has_value())
+    {
+        m_timerSampleCpuPtr->stop();
+        return;
+    }
 
-    /* (10) minflt - %lu */
-    strtoull(location, &location, 10);
-    location += 1;
+    //wake up when the next sample is due, rounded up to the timer resolution
+    const quint64 nowInNs = m_clock.monotonicInNs();
+    const quint64 deadlineInNs = deadline.value();
+    const quint64 delayInNs = deadlineInNs > nowInNs ? deadlineInNs - nowInNs : 0;
+    m_timerSampleCpuPtr->start(static_cast<int>((delayInNs + 999'999) / 1'000'000));
+}
 
-    /* (11) cminflt - %lu */
-    strtoull(location, &location, 10);
-    location += 1;
+/**
+ * @brief QCpuMonitor::scheduleControlCpuLimit
+ */
+void QCpuMonitor::scheduleControlCpuLimit() noexcept
+{
+    //get the next deadline
+    const std::optional<quint64> deadline = m_limiter.nextControlDeadlineInMs();
 
-    /* (12) majflt - %lu */
-    strtoull(location, &location, 10);
-    location += 1;
+    //nothing to do until a limit is set
+    if (!deadline.has_value())
+    {
+        m_timerLimitCpuPtr->stop();
+        return;
+    }
 
-    /* (13) cmajflt - %lu */
-    strtoull(location, &location, 10);
-    location += 1;
+    //wake up exactly when the next event is due
+    const quint64 now = m_clock.monotonicInMs();
+    const quint64 delay = deadline.value() > now ? deadline.value() - now : 0;
+    m_timerLimitCpuPtr->start(static_cast<int>(delay));
+}
 
-    /* (14) utime - %lu */
-    const quint64 utime = strtoull(location, &location, 10);
-    location += 1;
+/**
+ * @brief QCpuMonitor::applyCpuLimit
+ */
+void QCpuMonitor::applyCpuLimit(int index, double cpuLimitInPercent) noexcept
+{
+    //set the limit and wake up for the new deadlines
+    m_limiter.applyCpuLimit(index, cpuLimitInPercent);
+    scheduleSampleCpuTime();
+    scheduleControlCpuLimit();
+}
 
-    /* (15) stime - %lu */
-    const quint64 stime = strtoull(location, &location, 10);
-    location += 1;
+/**
+ * @brief QCpuMonitor::clearCpuLimit
+ */
+void QCpuMonitor::clearCpuLimit(int index) noexcept
+{
+    //remove the limit and wake up for the remaining deadlines
+    m_limiter.clearCpuLimit(index);
+    scheduleControlCpuLimit();
+}
 
-    //update the CPU time
-    process.previousCpuTimeInTicks = process.cpuTimeInTicks;
-    process.cpuTimeInTicks = (utime + stime) * 1000 / HZ;
+/**
+ * @brief QCpuMonitor::applyIoLimit
+ */
+void QCpuMonitor::applyIoLimit(int index, quint64 ioLimitInBytesPerSecond) noexcept
+{
+    //set the limit and wake up for the new deadlines
+    m_limiter.applyIoLimit(index, ioLimitInBytesPerSecond);
+    scheduleSampleCpuTime();
+    scheduleControlCpuLimit();
+}
 
-    //calculate the sample
-    const double sample = 1.0 * (process.cpuTimeInTicks - process.previousCpuTimeInTicks) / elapsed;
+/**
+ * @brief QCpuMonitor::clearIoLimit
+ */
+void QCpuMonitor::clearIoLimit(int index) noexcept
+{
+    //remove the limit and wake up for the remaining deadlines
+    m_limiter.clearIoLimit(index);
+    scheduleControlCpuLimit();
+}
 
-    //calculate CPU usage
-    constexpr double alpha = 0.08;
-    process.cpuUsageInPercent = (1.0 - alpha) * process.cpuUsageInPercent + (alpha * sample);
+/**
+ * @brief QCpuMonitor::applyTreeLimit
+ */
+void QCpuMonitor::applyTreeLimit(int index, double cpuLimitInPercent) noexcept
+{
+    //set the limits and wake up for the new deadlines
+    m_limiter.applyTreeLimit(index, cpuLimitInPercent);
+    scheduleSampleCpuTime();
+    scheduleControlCpuLimit();
+}
 
-    //update the timestamp
-    process.lastMeasuredTimestampInMs = now;
+/**
+ * @brief QCpuMonitor::clearTreeLimit
+ */
+void QCpuMonitor::clearTreeLimit(int index) noexcept
+{
+    //remove the limits and wake up for the remaining deadlines
+    m_limiter.clearTreeLimit(index);
+    scheduleControlCpuLimit();
 }
 
 /**
- * @brief QCpuMonitor::timeoutControlCpuLimit
+ * @brief QCpuMonitor::timeoutSampleCpuTime
  */
-void QCpuMonitor::timeoutControlCpuLimit() noexcept
+void QCpuMonitor::timeoutSampleCpuTime() noexcept
 {
-    //start the timer again once we go out of this method
+    //arm the timer for the next deadline once we go out of this method
     auto timerGuard = qScopeGuard([this]()
     {
-        m_timerLimitCpuPtr->start();
+        scheduleSampleCpuTime();
     });
 
-    //get the current timestamp
-    const quint64 now = QDateTime::currentMSecsSinceEpoch();
-
-    //loop through the processes
-    std::for_each(m_processList.begin(), m_processList.end(), [this, now](QCpuProcess & process)
+    //measure the cycle time when profiling
+    const quint64 cycleStartInNs = m_clock.monotonicInNs();
+    auto profileGuard = qScopeGuard([this, cycleStartInNs]()
     {
-        //scan the cpu time for each process
-        scanProcessCpuTime(now, process);
-
-        //check if the process has a cpu limit
-        if (!process.cpuLimitInPercent.has_value())
-        {
-            return;
-        }
-
-        //check if the process is sleeping
-        if (process.sleepCountInCycle >= 1)
-        {
-            //subtract the sleep count
-            process.sleepCountInCycle--;
+        m_profileSampleCycleTimeInNs += m_clock.monotonicInNs() - cycleStartInNs;
+        m_profileSampleCycleCount++;
+    });
 
-            //should we send a SIGCONT signal to the process?
-            if (process.sleepCountInCycle == 0)
-            {
-                //send a SIGCONT signal to the process
-                kill(process.pid, SIGCONT);
-            }
+    //sample the due processes only
+    m_limiter.sampleDueProcesses();
+}
 
-            //skip the process
-            return;
-        }
+/**
+ * @brief QCpuMonitor::timeoutControlCpuLimit
+ */
+void QCpuMonitor::timeoutControlCpuLimit() noexcept
+{
+    //arm the timer for the next deadline once we go out of this method
+    auto timerGuard = qScopeGuard([this]()
+    {
+        scheduleControlCpuLimit();
+    });
 
-        //do we exceed the cpu limit?
-        if (process.cpuLimitInPercent.value() <= 0.001 ||
-                process.cpuUsageInPercent <= process.cpuLimitInPercent.value())
-        {
-            return;
-        }
+    //measure the cycle time when profiling
+    const quint64 cycleStartInNs = m_clock.monotonicInNs();
+    auto profileGuard = qScopeGuard([this, cycleStartInNs]()
+    {
+        m_profileLimitCycleTimeInNs += m_clock.monotonicInNs() - cycleStartInNs;
+        m_profileLimitCycleCount++;
+    });
 
-        //count the sleep count
-        process.sleepCountInCycle = (process.cpuUsageInPercent - process.cpuLimitInPercent.value()) / process.cpuLimitInPercent.value();
-        process.sleepCountInCycle = std::max(process.sleepCountInCycle, 1);
+    //the children forked by the limited trees are sampled before the next full rescan
+    if (m_limiter.scanProcessEvents())
+    {
+        scheduleSampleCpuTime();
+    }
 
-        //send a SIGSTOP signal to the process
-        kill(process.pid, SIGSTOP);
-    });
+    //process the due events
+    m_limiter.controlDueProcesses();
 }
 
 /**
@@ -609,6 +1180,73 @@ void QCpuMonitor::timeoutCpuMonitor() noexcept
     //scan running processes
     scanRunningProcesses();
 
+    //report the average cycle times, enabled with QTCPULIMIT_PROFILE=1
+    if (m_profilingEnabled)
+    {
+        qDebug() << "QCpuMonitor::timeoutCpuMonitor: processes:" << m_processTable.size()
+                 << "sample cycle (us):" << (m_profileSampleCycleCount ? m_profileSampleCycleTimeInNs / m_profileSampleCycleCount / 1000.0 : 0.0)
+                 << "limit cycle (us):" << (m_profileLimitCycleCount ? m_profileLimitCycleTimeInNs / m_profileLimitCycleCount / 1000.0 : 0.0);
+    }
+
+    m_profileSampleCycleTimeInNs = 0;
+    m_profileSampleCycleCount    = 0;
+    m_profileLimitCycleTimeInNs  = 0;
+    m_profileLimitCycleCount     = 0;
+
     //start the timer again
     m_timerMonitorCpuPtr->start();
 }
+
+/**
+ * @brief QCpuMonitor::timeoutSystemLoad
+ */
+void QCpuMonitor::timeoutSystemLoad() noexcept
+{
+    //scan the system load
+    scanSystemLoad();
+
+    //start the timer again
+    m_timerSystemLoadPtr->start();
+}
+
+/**
+ * @brief QCpuMonitor::timeoutPressure
+ */
+void QCpuMonitor::timeoutPressure() noexcept
+{
+    //the protection has been disabled in the meantime
+    if (!m_autoProtectionEnabled)
+    {
+        return;
+    }
+
+    //PSI is available: the trigger raises the pressure, the average below the hysteresis band clears it
+    if (m_pressureFd >= 0)
+    {
+        double averageInPercent = 0;
+        if (readPressureAverage(averageInPercent) && averageInPercent < c_psiReleaseAverageInPercent)
+        {
+            relaxSystem();
+        }
+
+        //keep watching until the last automatic limit is lifted
+        if (m_underPressure)
+        {
+            m_timerPressurePtr->start();
+        }
+
+        return;
+    }
+
+    //PSI is not available: rely on the /proc/stat contention
+    if (m_limiter.systemContended())
+    {
+        protectSystem();
+    }
+    else if (m_underPressure)
+    {
+        relaxSystem();
+    }
+
+    m_timerPressurePtr->start();
+}
@@ -16,20 +16,38 @@
 #include <QTextStream>
 #include <QScopeGuard>
 #include <QDateTime>
-#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QSet>
+#include <QSocketNotifier>
 #include <exception>
 #include <stdexcept>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
 #include <signal.h>
 #include <unistd.h>
 #include <limits.h>
 #include <dirent.h>
-#include <sys/sysinfo.h>
+#include <sys/resource.h>
+#include <sched.h>
+#include <errno.h>
+#include <fcntl.h>
 #include "QCpuTypes.h"
+#include "QCpuProcessTable.h"
+#include "QCpuScheduler.h"
+#include "QCpuPlatform.h"
+#include "QCpuLimiter.h"
+#include "QCpuStringPool.h"
+#include "QCpuSource.h"
 
 /**
  * @brief QCpuMonitor class
  */
-class QCpuMonitor final : public QObject
+class QCpuMonitor final : public QCpuSource
 {
     Q_OBJECT
 
@@ -39,16 +57,23 @@ public:
 
     ~QCpuMonitor() noexcept override;
 
-public slots:
-
-    void setProcessLimit(pid_t pid, int cpuLimit);
-    void removeProcessLimit(pid_t pid);
+    std::shared_ptr<const QCpuStringPool> stringPool() const override;
 
-signals:
+public slots:
 
-    void updateProcessList(const QCpuProcessList processList,
-                           const PidList processToAdd,
-                           const PidList processToRemove); //This signal is cross-thread, don't use references
+    void setProcessLimit(pid_t pid, int cpuLimit) override;
+    void removeProcessLimit(pid_t pid) override;
+    void setProcessIoLimit(pid_t pid, qint64 ioLimitInBytesPerSecond) override;
+    void removeProcessIoLimit(pid_t pid) override;
+    void setSoftThrottling(bool enabled) override;
+    void setSampleSource(int sampleSource) override;
+    void setAutoProtection(bool enabled) override;
+    void setSubscription(int subscription) override;
+    void setRefreshInterval(int refreshIntervalInMs) override;
+    void setExtendedStatistics(bool enabled) override;
+    void setDescendantLimit(int descendantLimit) override;
+    void requestProcessMetadata(const PidList pidList) override;
+    void requestProcessStatistics(const PidList pidList) override;
 
 private:
 
@@ -56,15 +81,59 @@ private:
 
     void start() noexcept;
     void scanUsers() noexcept;
+    void scanBootTime() noexcept;
     void scanRunningProcesses() noexcept;
-    void scanProcessCpuTime(quint64 now, QCpuProcess& process) noexcept;
+    void readProcessMetadata(QCpuProcessMetadata& metadata) noexcept;
+    void scheduleSampleCpuTime() noexcept;
+    void applyCpuLimit(int index, double cpuLimitInPercent) noexcept;
+    void clearCpuLimit(int index) noexcept;
+    void applyIoLimit(int index, quint64 ioLimitInBytesPerSecond) noexcept;
+    void clearIoLimit(int index) noexcept;
+    void applyTreeLimit(int index, double cpuLimitInPercent) noexcept;
+    void clearTreeLimit(int index) noexcept;
+    void scanSystemLoad() noexcept;
+    void scanProcessStatistics() noexcept;
+    bool openPressureTrigger() noexcept;
+    void closePressureTrigger() noexcept;
+    bool readPressureAverage(double& averageInPercent) noexcept;
+    void protectSystem() noexcept;
+    void relaxSystem() noexcept;
+    void scheduleControlCpuLimit() noexcept;
+    void timeoutSampleCpuTime() noexcept;
     void timeoutControlCpuLimit() noexcept;
     void timeoutCpuMonitor() noexcept;
+    void timeoutSystemLoad() noexcept;
+    void timeoutPressure() noexcept;
 
-    QCpuProcessList m_processList;
+    QCpuProcessTable m_processTable;
+    QCpuSystemClock m_clock;
+    QCpuProcfsTimeSource m_timeSource;
+    QCpuSystemSignalSink m_signalSink;
+    QCpuLimiter m_limiter { m_processTable, m_clock, m_timeSource, m_signalSink };
     QUserMap m_userMap;
+    std::shared_ptr<QCpuStringPool> m_stringPoolPtr { std::make_shared<QCpuStringPool>() };
+    QHash<pid_t, QCpuProcessMetadata> m_metadataCache;
+    QSet<pid_t> m_statisticsPidSet;                 // rows whose extended statistics are shown by the view
+    quint64 m_statisticsTimestampInNs { 0 };        // monotonic timestamp of the previous refresh of the statistics
+    quint64 m_bootTimestampInMs { 0 };
+    QCpuSubscription m_subscription { QCpuSubscription::Visible };
+    quint64 m_refreshCount { 0 };
+    int m_refreshIntervalInMs { c_timerRefreshProcessListIntervalInMs };
     QTimer* m_timerMonitorCpuPtr { nullptr };
+    QTimer* m_timerSampleCpuPtr  { nullptr };
     QTimer* m_timerLimitCpuPtr   { nullptr };
+    QTimer* m_timerSystemLoadPtr { nullptr };
+    QTimer* m_timerPressurePtr   { nullptr };
+    QSocketNotifier* m_pressureNotifierPtr { nullptr };
+    int m_pressureFd { -1 };
+    bool m_autoProtectionEnabled { false };
+    bool m_underPressure         { false };
+    bool m_profilingEnabled      { false };
+    bool m_extendedStatisticsEnabled { false };
+    quint64 m_profileSampleCycleTimeInNs { 0 };
+    quint64 m_profileSampleCycleCount    { 0 };
+    quint64 m_profileLimitCycleTimeInNs  { 0 };
+    quint64 m_profileLimitCycleCount     { 0 };
 };
 
 #endif // QCPUMONITOR_H
@@ -0,0 +1,764 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuPlatform.h"
+
+/**
+ * @brief QCpuSystemClock::QCpuSystemClock
+ */
+QCpuSystemClock::QCpuSystemClock()
+{
+    m_monotonicClock.start();
+}
+
+/**
+ * @brief QCpuSystemClock::monotonicInNs
+ */
+quint64 QCpuSystemClock::monotonicInNs() const noexcept
+{
+    return m_monotonicClock.nsecsElapsed();
+}
+
+
+/**
+ * @brief QCpuProcfsTimeSource::QCpuProcfsTimeSource
+ */
+QCpuProcfsTimeSource::QCpuProcfsTimeSource()
+{
+    //listen to the forks and execs from now on
+    if (!openProcessEvents())
+    {
+        qDebug() << "QCpuProcfsTimeSource::QCpuProcfsTimeSource: the proc connector is not available, the new processes are found by the rescans only";
+    }
+}
+
+/**
+ * @brief QCpuProcfsTimeSource::~QCpuProcfsTimeSource
+ */
+QCpuProcfsTimeSource::~QCpuProcfsTimeSource()
+{
+    if (m_processEventFd >= 0)
+    {
+        ::close(m_processEventFd);
+    }
+}
+
+/**
+ * @brief QCpuProcfsTimeSource::listProcesses
+ */
+bool QCpuProcfsTimeSource::listProcesses(PidList& pidList) noexcept
+{
+    //loop "/proc/[pid]" directories. PID should be a number
+    QDirIterator it("/proc", QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks | QDir::Readable, QDirIterator::NoIteratorFlags);
+
+    //loop through the directories
+    while (it.hasNext())
+    {
+        //get the next directory
+        const QString dir = it.next();
+
+        //get the pid
+        const QString pidStr = dir.section('/', -1);
+
+        //check if the pid is a number
+        bool ok = false;
+        const int pid = pidStr.toInt(&ok);
+        if (!ok || pid < 0)
+        {
+            continue;
+        }
+
+        //add the pid to the list
+        pidList.push_back(pid);
+    }
+
+    return !pidList.isEmpty();
+}
+
+/**
+ * @brief QCpuProcfsTimeSource::openProcessEvents
+ */
+bool QCpuProcfsTimeSource::openProcessEvents() noexcept
+{
+    //join the multicast group of the proc connector, never block the monitor thread
+    const int fd = ::socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    sockaddr_nl address {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+    address.nl_pid    = 0;  // let the kernel pick the port
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    //a burst of forks between two reads must not overflow the socket, the limit is capped by net.core.rmem_max
+    const int bufferSize = 1024 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+    //ask for the events: netlink header, connector header, then the operation
+    alignas(nlmsghdr) char request[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+    nlmsghdr* headerPtr = reinterpret_cast<nlmsghdr*>(request);
+    headerPtr->nlmsg_len  = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    headerPtr->nlmsg_type = NLMSG_DONE;
+
+    cn_msg* messagePtr = reinterpret_cast<cn_msg*>(NLMSG_DATA(headerPtr));
+    messagePtr->id.idx = CN_IDX_PROC;
+    messagePtr->id.val = CN_VAL_PROC;
+    messagePtr->len    = sizeof(proc_cn_mcast_op);
+
+    const proc_cn_mcast_op operation = PROC_CN_MCAST_LISTEN;
+    std::memcpy(messagePtr->data, &operation, sizeof(operation));
+
+    if (::send(fd, request, headerPtr->nlmsg_len, 0) < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    //the kernel acknowledges the request synchronously, an unprivileged request is refused with EPERM
+    //the forks since the bind may be queued before the acknowledgement, the rescan covers them
+    alignas(nlmsghdr) char reply[512];
+    ssize_t size = 0;
+    while ((size = ::recv(fd, reply, sizeof(reply), 0)) > 0)
+    {
+        const nlmsghdr* replyHeaderPtr = reinterpret_cast<const nlmsghdr*>(reply);
+        if (size < static_cast<ssize_t>(NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_event))))
+        {
+            continue;
+        }
+
+        const proc_event* eventPtr = reinterpret_cast<const proc_event*>(reinterpret_cast<const cn_msg*>(NLMSG_DATA(replyHeaderPtr))->data);
+        if (eventPtr->what == proc_event::PROC_EVENT_NONE)
+        {
+            break;
+        }
+    }
+
+    const proc_event* ackPtr = reinterpret_cast<const proc_event*>(reinterpret_cast<const cn_msg*>(NLMSG_DATA(reinterpret_cast<const nlmsghdr*>(reply)))->data);
+    if (size <= 0 || ackPtr->event_data.ack.err != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    m_processEventFd = fd;
+    return true;
+}
+
+/**
+ * @brief QCpuProcfsTimeSource::readProcessEvents
+ */
+bool QCpuProcfsTimeSource::readProcessEvents(QCpuProcessEventList& eventList, int maxEventCount) noexcept
+{
+    //no connector: the caller relies on the rescans
+    if (m_processEventFd < 0)
+    {
+        return false;
+    }
+
+    //one event per datagram, the rest stays queued in the socket for the next read
+    alignas(nlmsghdr) char buffer[512];
+    int readCount = 0;
+    while (readCount < maxEventCount)
+    {
+        const ssize_t size = ::recv(m_processEventFd, buffer, sizeof(buffer), 0);
+        if (size < 0)
+        {
+            //ENOBUFS: the socket overflowed, some forks are lost
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+
+        ++readCount;
+
+        const nlmsghdr* headerPtr = reinterpret_cast<const nlmsghdr*>(buffer);
+        if (size < static_cast<ssize_t>(NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_event))) ||
+                !NLMSG_OK(headerPtr, static_cast<unsigned int>(size)))
+        {
+            continue;
+        }
+
+        const proc_event* eventPtr = reinterpret_cast<const proc_event*>(reinterpret_cast<const cn_msg*>(NLMSG_DATA(headerPtr))->data);
+        QCpuProcessEvent event;
+        if (eventPtr->what == proc_event::PROC_EVENT_FORK &&
+                eventPtr->event_data.fork.child_pid == eventPtr->event_data.fork.child_tgid)
+        {
+            //a new process, not a new thread: the child is the leader of its thread group
+            event.pid  = eventPtr->event_data.fork.child_tgid;
+            event.ppid = eventPtr->event_data.fork.parent_tgid;
+        }
+        else if (eventPtr->what == proc_event::PROC_EVENT_EXEC)
+        {
+            //the thread that calls exec becomes the leader: the image of the whole process changed
+            event.pid  = eventPtr->event_data.exec.process_tgid;
+            event.type = QCpuProcessEventType::Exec;
+        }
+        else
+        {
+            continue;
+        }
+
+        eventList.push_back(event);
+    }
+
+    return true;
+}
+
+/**
+ * @brief QCpuProcfsTimeSource::readStat
+ */
+bool QCpuProcfsTimeSource::readStat(pid_t pid, QCpuStatSample& sample) noexcept
+{
+    //create the stat file path
+    const QString statFilePath = QString("/proc/%1/stat").arg(pid);
+
+    //create the stat file object
+    QFile statFile(statFilePath);
+
+    //try to open the stat file
+    if (!statFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    //create the text stream
+    QTextStream textStream(&statFile);
+
+    //read the first line
+    const QString line = textStream.readLine();
+
+    //close the stat file
+    statFile.close();
+
+    //check if the line is valid
+    if (line.isEmpty())
+    {
+        qDebug() << "QCpuProcfsTimeSource::readStat: cannot read the stat file - pid:" << pid;
+        return false;
+    }
+
+    //scan the line
+    const auto str = line.toStdString();
+    char* buf = const_cast<char*>(str.c_str());
+
+    /* (1) pid -  %d */
+    char* location = strchr(buf, ' ');
+    if (!location)
+    {
+        return false;
+    }
+
+    /* (2) comm - (%s) */
+    location += 2;
+    char* end = strrchr(location, ')');
+    if (!end)
+    {
+        return false;
+    }
+
+    sample.nameHash = qHash(QByteArray::fromRawData(location, static_cast<int>(end - location)));
+    location = end + 2;
+
+    /* (3) state - %c */
+    sample.counters.state = *location;
+    location += 2;
+
+    /* (4) ppid - %d */
+    sample.ppid = static_cast<pid_t>(strtol(location, &location, 10));
+    location += 1;
+
+    /* (5) pgrp - %d */
+    strtol(location, &location, 10);
+    location += 1;
+
+    /* (6) session - %d */
+    strtol(location, &location, 10);
+    location += 1;
+
+    /* (7) tty_nr - %d */
+    strtoul(location, &location, 10);
+    location += 1;
+
+    /* (8) tpgid - %d */
+    strtol(location, &location, 10);
+    location += 1;
+
+    /* Skip (9) flags - %u */
+    location = strchr(location, ' ') + 1;
+
+    /* (10) minflt - %lu */
+    sample.counters.minorFaults = strtoull(location, &location, 10);
+    location += 1;
+
+    /* (11) cminflt - %lu */
+    strtoull(location, &location, 10);
+    location += 1;
+
+    /* (12) majflt - %lu */
+    sample.counters.majorFaults = strtoull(location, &location, 10);
+    location += 1;
+
+    /* (13) cmajflt - %lu */
+    strtoull(location, &location, 10);
+    location += 1;
+
+    /* (14) utime - %lu */
+    const quint64 utime = strtoull(location, &location, 10);
+    location += 1;
+
+    /* (15) stime - %lu */
+    const quint64 stime = strtoull(location, &location, 10);
+    location += 1;
+
+    /* (16) cutime - %ld */
+    strtoll(location, &location, 10);
+    location += 1;
+
+    /* (17) cstime - %ld */
+    strtoll(location, &location, 10);
+    location += 1;
+
+    /* (18) priority - %ld */
+    strtoll(location, &location, 10);
+    location += 1;
+
+    /* (19) nice - %ld */
+    strtoll(location, &location, 10);
+    location += 1;
+
+    /* (20) num_threads - %ld */
+    sample.counters.threadCount = static_cast<int>(strtol(location, &location, 10));
+    location += 1;
+
+    /* (21) itrealvalue - %ld */
+    strtoll(location, &location, 10);
+    location += 1;
+
+    /* (22) starttime - %llu */
+    sample.startTimeInTicks = strtoull(location, &location, 10);
+    location += 1;
+
+    /* (23) vsize - %lu */
+    strtoull(location, &location, 10);
+    location += 1;
+
+    /* (24) rss - %ld, in pages */
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    sample.counters.rssInBytes = static_cast<quint64>(std::max(strtoll(location, &location, 10), 0LL)) * static_cast<quint64>(pageSize);
+
+    /* Skip (25) rsslim - %lu .. (38) exit_signal - %d */
+    for (int field = 25; field <= 38 && location; ++field)
+    {
+        location = strchr(location + 1, ' ');
+    }
+
+    /* (39) processor - %d */
+    sample.processor = location ? static_cast<int>(strtol(location + 1, nullptr, 10)) : -1;
+
+    //convert the ticks to nanoseconds
+    sample.cpuTimeInNs = static_cast<quint64>((utime + stime) * 1'000'000'000.0 / HZ);
+    return true;
+}
+
+/**
+ * @brief QCpuProcfsTimeSource::readSchedStatCpuTime
+ */
+bool QCpuProcfsTimeSource::readSchedStatCpuTime(pid_t pid, quint64& cpuTimeInNs) noexcept
+{
+    //create the schedstat file object
+    QFile schedStatFile(QString("/proc/%1/schedstat").arg(pid));
+
+    //try to open the schedstat file
+    if (!schedStatFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    //read the first line: "sum_exec_runtime run_delay pcount"
+    char buf[128] = {};
+    const qint64 size = schedStatFile.readLine(buf, sizeof(buf));
+
+    //close the schedstat file
+    schedStatFile.close();
+
+    //check if the line is valid
+    if (size <= 0)
+    {
+        return false;
+    }
+
+    //(1) sum_exec_runtime - time spent on the CPU in ns
+    char* end = nullptr;
+    cpuTimeInNs = strtoull(buf, &end, 10);
+    return end != buf;
+}
+
+/**
+ * @brief QCpuProcfsTimeSource::readIoBytes
+ */
+bool QCpuProcfsTimeSource::readIoBytes(pid_t pid, quint64& ioBytes) noexcept
+{
+    //create the io file object
+    QFile ioFile(QString("/proc/%1/io").arg(pid));
+
+    //try to open the io file
+    if (!ioFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    //sum the bytes really fetched from and sent to the storage layer
+    //"read_bytes: N" and "write_bytes: N", the rchar/wchar lines also count the page cache hits
+    ioBytes = 0;
+    int fieldCount = 0;
+    char buf[128] = {};
+    while (ioFile.readLine(buf, sizeof(buf)) > 0)
+    {
+        const char* valuePtr = nullptr;
+        if (strncmp(buf, "read_bytes:", 11) == 0)
+        {
+            valuePtr = buf + 11;
+        }
+        else if (strncmp(buf, "write_bytes:", 12) == 0)
+        {
+            valuePtr = buf + 12;
+        }
+        else
+        {
+            continue;
+        }
+
+        ioBytes += strtoull(valuePtr, nullptr, 10);
+        ++fieldCount;
+    }
+
+    //close the io file
+    ioFile.close();
+
+    return fieldCount == 2;
+}
+
+/**
+ * @brief QCpuProcfsTimeSource::readContextSwitches
+ */
+bool QCpuProcfsTimeSource::readContextSwitches(pid_t pid, quint64& voluntary, quint64& involuntary) noexcept
+{
+    //create the status file object
+    QFile statusFile(QString("/proc/%1/status").arg(pid));
+
+    //try to open the status file
+    if (!statusFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    //"voluntary_ctxt_switches: N" and "nonvoluntary_ctxt_switches: N" are the last lines
+    int fieldCount = 0;
+    char buf[256] = {};
+    while (fieldCount < 2 && statusFile.readLine(buf, sizeof(buf)) > 0)
+    {
+        if (strncmp(buf, "voluntary_ctxt_switches:", 24) == 0)
+        {
+            voluntary = strtoull(buf + 24, nullptr, 10);
+            ++fieldCount;
+        }
+        else if (strncmp(buf, "nonvoluntary_ctxt_switches:", 27) == 0)
+        {
+            involuntary = strtoull(buf + 27, nullptr, 10);
+            ++fieldCount;
+        }
+    }
+
+    //close the status file
+    statusFile.close();
+
+    return fieldCount == 2;
+}
+
+/**
+ * @brief QCpuProcfsTimeSource::readSystemStat
+ */
+bool QCpuProcfsTimeSource::readSystemStat(QCpuSystemStat& systemStat) noexcept
+{
+    //create the stat file object
+    QFile statFile("/proc/stat");
+
+    //try to open the stat file
+    if (!statFile.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "QCpuProcfsTimeSource::readSystemStat: cannot open the stat file";
+        return false;
+    }
+
+    //create the text stream
+    QTextStream textStream(&statFile);
+
+    //loop until the end of the file
+    while (!textStream.atEnd())
+    {
+        //read the line
+        const QString line = textStream.readLine();
+
+        //aggregated line "cpu ..." and per-CPU lines "cpuN ...": "user nice system idle iowait irq softirq steal ..."
+        if (line.startsWith("cpu"))
+        {
+            const QStringList splitList = line.split(' ', Qt::SkipEmptyParts);
+            quint64 lineTotalTicks = 0;
+            quint64 lineIdleTicks  = 0;
+            for (int index = 1; index < splitList.size(); ++index)
+            {
+                const quint64 ticks = splitList[index].toULongLong();
+                lineTotalTicks += ticks;
+
+                //idle and iowait
+                if (index == 4 || index == 5)
+                {
+                    lineIdleTicks += ticks;
+                }
+            }
+
+            //aggregated line
+            if (splitList.first() == "cpu")
+            {
+                systemStat.totalTicks = lineTotalTicks;
+                systemStat.idleTicks  = lineIdleTicks;
+                continue;
+            }
+
+            //per-CPU line, the offline CPUs are missing: index by CPU number
+            bool ok = false;
+            const int cpu = splitList.first().mid(3).toInt(&ok);
+            if (!ok || cpu < 0)
+            {
+                continue;
+            }
+
+            if (static_cast<size_t>(cpu) >= systemStat.cpuTotalTicks.size())
+            {
+                systemStat.cpuTotalTicks.resize(cpu + 1, 0);
+                systemStat.cpuIdleTicks.resize(cpu + 1, 0);
+            }
+
+            systemStat.cpuTotalTicks[cpu] = lineTotalTicks;
+            systemStat.cpuIdleTicks[cpu]  = lineIdleTicks;
+            ++systemStat.cpuCount;
+        }
+        else if (line.startsWith("procs_running "))
+        {
+            systemStat.runningProcesses = line.section(' ', 1, 1).toInt();
+            break;
+        }
+    }
+
+    //close the stat file
+    statFile.close();
+
+    return systemStat.totalTicks != 0;
+}
+
+/**
+ * @brief QCpuSystemSignalSink::stopProcess
+ */
+void QCpuSystemSignalSink::stopProcess(pid_t pid) noexcept
+{
+    kill(pid, SIGSTOP);
+}
+
+/**
+ * @brief QCpuSystemSignalSink::continueProcess
+ */
+void QCpuSystemSignalSink::continueProcess(pid_t pid) noexcept
+{
+    kill(pid, SIGCONT);
+}
+
+/**
+ * @brief QCpuSystemSignalSink::demoteProcess
+ */
+bool QCpuSystemSignalSink::demoteProcess(pid_t pid, QCpuProcessColdState& control) noexcept
+{
+    //demote every thread of the process (priorities are per thread on Linux)
+    control.originalPriorityList.clear();
+    const PidList threadList = listThreads(pid);
+    std::for_each(threadList.constBegin(), threadList.constEnd(), [pid, &control](pid_t tid)
+    {
+        //save the priority of the thread, each thread may have its own
+        QCpuThreadPriority originalPriority;
+        if (!readThreadPriority(tid, originalPriority))
+        {
+            qDebug() << "QCpuSystemSignalSink::demoteProcess: cannot read the thread priority - pid:" << pid << "tid:" << tid;
+            return;
+        }
+
+        //prefer SCHED_IDLE, fall back to the lowest nice value
+        const sched_param idleParam {};
+        if (sched_setscheduler(tid, SCHED_IDLE, &idleParam) != 0)
+        {
+            if (setpriority(PRIO_PROCESS, tid, c_demotedNice) != 0)
+            {
+                qDebug() << "QCpuSystemSignalSink::demoteProcess: cannot demote the thread - pid:" << pid << "tid:" << tid;
+                return;
+            }
+
+            originalPriority.niceDemoted = true;
+        }
+
+        //only the demoted threads are restored
+        control.originalPriorityList.push_back(originalPriority);
+    });
+
+    return !control.originalPriorityList.isEmpty();
+}
+
+/**
+ * @brief QCpuSystemSignalSink::restoreProcess
+ */
+void QCpuSystemSignalSink::restoreProcess(pid_t pid, const QCpuProcessColdState& control) noexcept
+{
+    //nothing was demoted?
+    const QCpuThreadPriorityList& originalPriorityList = control.originalPriorityList;
+    if (originalPriorityList.isEmpty())
+    {
+        return;
+    }
+
+    //the saved priority of each demoted thread
+    QHash<pid_t, int> originalIndexMap;
+    for (int index = 0; index < originalPriorityList.size(); ++index)
+    {
+        originalIndexMap.insert(originalPriorityList[index].tid, index);
+    }
+
+    //the priority all the demoted threads had, if they had the same
+    const QCpuThreadPriority& firstPriority = originalPriorityList.first();
+    const bool sharedPriority = std::all_of(originalPriorityList.cbegin(), originalPriorityList.cend(), [&firstPriority](const QCpuThreadPriority & priority)
+    {
+        return priority.nice == firstPriority.nice &&
+               priority.policy == firstPriority.policy &&
+               priority.priority == firstPriority.priority;
+    });
+
+    //the lowest nice value is only a demotion when SCHED_IDLE was refused
+    const bool niceDemoted = std::any_of(originalPriorityList.cbegin(), originalPriorityList.cend(), [](const QCpuThreadPriority & priority)
+    {
+        return priority.niceDemoted;
+    });
+
+    const PidList threadList = listThreads(pid);
+    std::for_each(threadList.constBegin(), threadList.constEnd(), [&](pid_t tid)
+    {
+        //a demoted thread gets its own priority back
+        const auto originalIndexIt = originalIndexMap.constFind(tid);
+        if (originalIndexIt != originalIndexMap.constEnd())
+        {
+            if (!writeThreadPriority(tid, originalPriorityList[originalIndexIt.value()]))
+            {
+                qDebug() << "QCpuSystemSignalSink::restoreProcess: cannot restore the thread priority - pid:" << pid << "tid:" << tid;
+            }
+
+            return;
+        }
+
+        //a thread created while the process was demoted inherited the demotion from a thread we don't know:
+        //only the demotion is undone, the priority the thread set itself is kept
+        QCpuThreadPriority currentPriority;
+        if (!readThreadPriority(tid, currentPriority))
+        {
+            return;
+        }
+
+        const bool idle = (currentPriority.policy & ~SCHED_RESET_ON_FORK) == SCHED_IDLE;
+        if (!idle && !(niceDemoted && currentPriority.nice == c_demotedNice))
+        {
+            return;
+        }
+
+        //every demoted thread had the same priority: it is the priority of the creator
+        QCpuThreadPriority restoredPriority = currentPriority;
+        if (sharedPriority)
+        {
+            restoredPriority = firstPriority;
+            restoredPriority.tid = tid;
+            restoredPriority.niceDemoted = false;
+        }
+        else if (idle)
+        {
+            //the idle policy leaves the nice value as it was: the thread kept the nice of its creator
+            restoredPriority.policy   = SCHED_OTHER | (currentPriority.policy & SCHED_RESET_ON_FORK);
+            restoredPriority.priority = 0;
+        }
+        else
+        {
+            //the lowest nice value may be the demotion or the creator's own: keep it
+            return;
+        }
+
+        if (!writeThreadPriority(tid, restoredPriority))
+        {
+            qDebug() << "QCpuSystemSignalSink::restoreProcess: cannot restore the new thread priority - pid:" << pid << "tid:" << tid;
+        }
+    });
+}
+
+/**
+ * @brief QCpuSystemSignalSink::listThreads
+ */
+PidList QCpuSystemSignalSink::listThreads(pid_t pid) noexcept
+{
+    PidList threadList;
+    const QStringList taskList = QDir(QString("/proc/%1/task").arg(pid)).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    std::for_each(taskList.constBegin(), taskList.constEnd(), [&threadList](const QString & task)
+    {
+        bool ok = false;
+        const pid_t tid = task.toInt(&ok);
+        if (ok)
+        {
+            threadList.push_back(tid);
+        }
+    });
+
+    return threadList;
+}
+
+/**
+ * @brief QCpuSystemSignalSink::readThreadPriority
+ */
+bool QCpuSystemSignalSink::readThreadPriority(pid_t tid, QCpuThreadPriority& priority) noexcept
+{
+    //the thread may have exited since the task directory was listed
+    errno = 0;
+    const int nice = getpriority(PRIO_PROCESS, tid);
+    const int policy = sched_getscheduler(tid);
+    sched_param param {};
+    if ((nice == -1 && errno != 0) || policy < 0 || sched_getparam(tid, &param) != 0)
+    {
+        return false;
+    }
+
+    //the policy keeps SCHED_RESET_ON_FORK: the flag is given back with the policy
+    priority.tid      = tid;
+    priority.nice     = nice;
+    priority.policy   = policy;
+    priority.priority = param.sched_priority;
+    return true;
+}
+
+/**
+ * @brief QCpuSystemSignalSink::writeThreadPriority
+ */
+bool QCpuSystemSignalSink::writeThreadPriority(pid_t tid, const QCpuThreadPriority& priority) noexcept
+{
+    sched_param param {};
+    param.sched_priority = priority.priority;
+    return sched_setscheduler(tid, priority.policy, &param) == 0 &&
+           setpriority(PRIO_PROCESS, tid, priority.nice) == 0;
+}
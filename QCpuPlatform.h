@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUPLATFORM_H
+#define QCPUPLATFORM_H
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+#include <sched.h>
+#include <errno.h>
+#include "QCpuTypes.h"
+
+# if defined(_SC_CLK_TCK)
+#  define HZ ((double)sysconf(_SC_CLK_TCK))
+# else
+#  ifndef CLK_TCK
+#    define HZ  100.0
+#  else
+#   define HZ ((double)CLK_TCK)
+#  endif
+# endif
+
+/**
+ * @brief QCpuClock class, the time base of the sampler and the limiter
+ */
+class QCpuClock
+{
+public:
+
+    virtual ~QCpuClock() = default;
+
+    virtual quint64 monotonicInNs() const noexcept = 0;    // sampling deadlines
+
+    //limiting deadlines: monotonic too, a wall clock step back would leave a stopped process stopped
+    quint64 monotonicInMs() const noexcept
+    {
+        return monotonicInNs() / 1'000'000;
+    }
+};
+
+/**
+ * @brief QCpuTimeSource class, the per-process counters read by the sampler
+ */
+class QCpuTimeSource
+{
+public:
+
+    virtual ~QCpuTimeSource() = default;
+
+    virtual bool listProcesses(PidList& pidList) noexcept = 0;
+    virtual bool readProcessEvents(QCpuProcessEventList& eventList, int maxEventCount) noexcept = 0; // false: no events, or some were lost
+    virtual bool readStat(pid_t pid, QCpuStatSample& sample) noexcept = 0;
+    virtual bool readSchedStatCpuTime(pid_t pid, quint64& cpuTimeInNs) noexcept = 0;
+    virtual bool readIoBytes(pid_t pid, quint64& ioBytes) noexcept = 0;
+    virtual bool readContextSwitches(pid_t pid, quint64& voluntary, quint64& involuntary) noexcept = 0;
+    virtual bool readSystemStat(QCpuSystemStat& systemStat) noexcept = 0;
+};
+
+/**
+ * @brief QCpuSignalSink class, the actions of the limiter on a process
+ */
+class QCpuSignalSink
+{
+public:
+
+    virtual ~QCpuSignalSink() = default;
+
+    virtual void stopProcess(pid_t pid) noexcept = 0;
+    virtual void continueProcess(pid_t pid) noexcept = 0;
+    virtual bool demoteProcess(pid_t pid, QCpuProcessColdState& control) noexcept = 0;
+    virtual void restoreProcess(pid_t pid, const QCpuProcessColdState& control) noexcept = 0;
+};
+
+/**
+ * @brief QCpuSystemClock class
+ */
+class QCpuSystemClock final : public QCpuClock
+{
+public:
+
+    QCpuSystemClock();
+
+    quint64 monotonicInNs() const noexcept override;
+
+private:
+
+    QElapsedTimer m_monotonicClock;
+};
+
+/**
+ * @brief QCpuProcfsTimeSource class, reads /proc/[pid]
+ *
+ * The forks and execs are reported by the proc connector (a netlink socket),
+ * which needs CAP_NET_ADMIN: without it, readProcessEvents always fails, the
+ * new processes are only found by listProcesses and the execs by the name
+ * read by readStat.
+ */
+class QCpuProcfsTimeSource final : public QCpuTimeSource
+{
+public:
+
+    QCpuProcfsTimeSource();
+    ~QCpuProcfsTimeSource() override;
+
+    QCpuProcfsTimeSource(const QCpuProcfsTimeSource&) = delete;
+    QCpuProcfsTimeSource& operator=(const QCpuProcfsTimeSource&) = delete;
+
+    bool listProcesses(PidList& pidList) noexcept override;
+    bool readProcessEvents(QCpuProcessEventList& eventList, int maxEventCount) noexcept override;
+    bool readStat(pid_t pid, QCpuStatSample& sample) noexcept override;
+    bool readSchedStatCpuTime(pid_t pid, quint64& cpuTimeInNs) noexcept override;
+    bool readIoBytes(pid_t pid, quint64& ioBytes) noexcept override;
+    bool readContextSwitches(pid_t pid, quint64& voluntary, quint64& involuntary) noexcept override;
+    bool readSystemStat(QCpuSystemStat& systemStat) noexcept override;
+
+private:
+
+    bool openProcessEvents() noexcept;
+
+    int m_processEventFd { -1 };    // proc connector socket, -1 when the kernel doesn't let us listen
+};
+
+/**
+ * @brief QCpuSystemSignalSink class, sends real signals and changes real priorities
+ */
+class QCpuSystemSignalSink final : public QCpuSignalSink
+{
+public:
+
+    void stopProcess(pid_t pid) noexcept override;
+    void continueProcess(pid_t pid) noexcept override;
+    bool demoteProcess(pid_t pid, QCpuProcessColdState& control) noexcept override;
+    void restoreProcess(pid_t pid, const QCpuProcessColdState& control) noexcept override;
+
+private:
+
+    static PidList listThreads(pid_t pid) noexcept;
+    static bool readThreadPriority(pid_t tid, QCpuThreadPriority& priority) noexcept;
+    static bool writeThreadPriority(pid_t tid, const QCpuThreadPriority& priority) noexcept;
+};
+
+#endif // QCPUPLATFORM_H
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuProcessTable.h"
+
+/**
+ * @brief QCpuProcessTable::size
+ */
+int QCpuProcessTable::size() const
+{
+    return static_cast<int>(m_hotStates.size());
+}
+
+/**
+ * @brief QCpuProcessTable::indexOf
+ */
+int QCpuProcessTable::indexOf(pid_t pid) const
+{
+    return m_indexMap.value(pid, -1);
+}
+
+/**
+ * @brief QCpuProcessTable::contains
+ */
+bool QCpuProcessTable::contains(pid_t pid) const
+{
+    return m_indexMap.contains(pid);
+}
+
+/**
+ * @brief QCpuProcessTable::append
+ */
+int QCpuProcessTable::append(const QCpuProcessHotState& hotState, const QCpuProcessColdState& coldState)
+{
+    //add the row at the end of both arrays
+    const int index = size();
+    m_hotStates.push_back(hotState);
+    m_coldStates.push_back(coldState);
+    m_indexMap.insert(hotState.pid, index);
+    return index;
+}
+
+/**
+ * @brief QCpuProcessTable::removeAt
+ */
+void QCpuProcessTable::removeAt(int index)
+{
+    //check the index
+    if (index < 0 || index >= size())
+    {
+        return;
+    }
+
+    m_indexMap.remove(m_hotStates[index].pid);
+
+    //move the last row into the hole
+    const int lastIndex = size() - 1;
+    if (index != lastIndex)
+    {
+        m_hotStates[index]  = m_hotStates[lastIndex];
+        m_coldStates[index] = m_coldStates[lastIndex];
+        m_indexMap.insert(m_hotStates[index].pid, index);
+    }
+
+    m_hotStates.pop_back();
+    m_coldStates.pop_back();
+}
+
+/**
+ * @brief QCpuProcessTable::hot
+ */
+QCpuProcessHotState& QCpuProcessTable::hot(int index)
+{
+    return m_hotStates[index];
+}
+
+/**
+ * @brief QCpuProcessTable::hot
+ */
+const QCpuProcessHotState& QCpuProcessTable::hot(int index) const
+{
+    return m_hotStates[index];
+}
+
+/**
+ * @brief QCpuProcessTable::cold
+ */
+QCpuProcessColdState& QCpuProcessTable::cold(int index)
+{
+    return m_coldStates[index];
+}
+
+/**
+ * @brief QCpuProcessTable::cold
+ */
+const QCpuProcessColdState& QCpuProcessTable::cold(int index) const
+{
+    return m_coldStates[index];
+}
+
+/**
+ * @brief QCpuProcessTable::snapshot
+ */
+QCpuProcessList QCpuProcessTable::snapshot() const
+{
+    //create the list
+    QCpuProcessList processList;
+    processList.reserve(size());
+
+    //copy the displayed fields of each row
+    for (int index = 0; index < size(); ++index)
+    {
+        QCpuProcess process;
+        process.pid               = m_hotStates[index].pid;
+        process.cpuUsageInPercent = m_hotStates[index].cpuUsageInPercent;
+        process.usageSeeded       = m_hotStates[index].usageSeeded;
+        process.cpuLimitInPercent = m_hotStates[index].cpuLimitInPercent;
+        process.autoLimited       = m_coldStates[index].autoLimited;
+        process.ioRateInBytesPerSecond  = m_hotStates[index].ioRateInBytesPerSecond;
+        process.ioLimitInBytesPerSecond = m_hotStates[index].ioLimitInBytesPerSecond;
+        process.processor               = m_hotStates[index].processor;
+        process.statCounters            = m_coldStates[index].statCounters;
+        process.voluntaryContextSwitches   = m_coldStates[index].voluntaryContextSwitches;
+        process.involuntaryContextSwitches = m_coldStates[index].involuntaryContextSwitches;
+        processList.push_back(process);
+    }
+
+    //sort by pid, the model diffs consecutive snapshots with a sorted merge
+    std::sort(processList.begin(), processList.end(), [](const QCpuProcess & left, const QCpuProcess & right)
+    {
+        return left.pid < right.pid;
+    });
+
+    return processList;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUPROCESSTABLE_H
+#define QCPUPROCESSTABLE_H
+
+#include <QHash>
+#include <algorithm>
+#include <vector>
+#include "QCpuTypes.h"
+
+/**
+ * @brief QCpuProcessTable class
+ *
+ * Process storage of the monitor. The state read at every sampling and limiting
+ * deadline is kept in one contiguous array, apart from the state only needed on
+ * discovery and limit changes. Rows are removed by swapping with the last row,
+ * so the index of a process is only stable until the next removal.
+ */
+class QCpuProcessTable final
+{
+public:
+
+    int size() const;
+    int indexOf(pid_t pid) const;
+    bool contains(pid_t pid) const;
+
+    int append(const QCpuProcessHotState& hotState, const QCpuProcessColdState& coldState);
+    void removeAt(int index);
+
+    QCpuProcessHotState& hot(int index);
+    const QCpuProcessHotState& hot(int index) const;
+    QCpuProcessColdState& cold(int index);
+    const QCpuProcessColdState& cold(int index) const;
+
+    QCpuProcessList snapshot() const;
+
+private:
+
+    std::vector<QCpuProcessHotState> m_hotStates;
+    std::vector<QCpuProcessColdState> m_coldStates;
+    QHash<pid_t, int> m_indexMap;   // pid -> row
+};
+
+#endif // QCPUPROCESSTABLE_H
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuScheduler.h"
+
+/**
+ * @brief QCpuScheduler::QCpuScheduler
+ */
+QCpuScheduler::QCpuScheduler(quint64 periodInMs)
+    : m_periodInMs(std::max<quint64>(periodInMs, 1))
+{
+}
+
+/**
+ * @brief QCpuScheduler::addProcess
+ */
+void QCpuScheduler::addProcess(pid_t pid)
+{
+    //a new generation invalidates the events already queued for this pid
+    m_generationMap.insert(pid, m_nextGeneration++);
+
+    //register the process in the phase ring
+    if (!m_phaseRing.contains(pid))
+    {
+        m_phaseRing.push_back(pid);
+        spreadPhases();
+    }
+}
+
+/**
+ * @brief QCpuScheduler::removeProcess
+ */
+void QCpuScheduler::removeProcess(pid_t pid)
+{
+    //the queued events become stale, they are dropped lazily
+    m_generationMap.remove(pid);
+
+    //unregister the process from the phase ring
+    if (m_phaseRing.removeOne(pid))
+    {
+        spreadPhases();
+    }
+}
+
+/**
+ * @brief QCpuScheduler::contains
+ */
+bool QCpuScheduler::contains(pid_t pid) const
+{
+    return m_generationMap.contains(pid);
+}
+
+/**
+ * @brief QCpuScheduler::nextPhaseDeadline
+ */
+quint64 QCpuScheduler::nextPhaseDeadline(pid_t pid, quint64 now) const
+{
+    //align to the beginning of the current period, then apply the phase
+    const quint64 phase = m_phaseMap.value(pid, 0);
+    quint64 deadline = now - (now % m_periodInMs) + phase;
+
+    //the deadline must be strictly in the future
+    if (deadline <= now)
+    {
+        deadline += m_periodInMs;
+    }
+
+    return deadline;
+}
+
+/**
+ * @brief QCpuScheduler::schedule
+ */
+void QCpuScheduler::schedule(pid_t pid, quint64 deadlineInMs, QCpuSchedulerAction action)
+{
+    //the process must be registered
+    auto generationIt = m_generationMap.constFind(pid);
+    if (generationIt == m_generationMap.constEnd())
+    {
+        return;
+    }
+
+    //queue the event
+    QCpuSchedulerEvent event;
+    event.deadlineInMs = deadlineInMs;
+    event.pid          = pid;
+    event.generation   = generationIt.value();
+    event.action       = action;
+    m_eventQueue.push(event);
+}
+
+/**
+ * @brief QCpuScheduler::nextDeadline
+ */
+std::optional<quint64> QCpuScheduler::nextDeadline()
+{
+    discardStaleEvents();
+
+    if (m_eventQueue.empty())
+    {
+        return std::nullopt;
+    }
+
+    return m_eventQueue.top().deadlineInMs;
+}
+
+/**
+ * @brief QCpuScheduler::takeDueEvent
+ */
+bool QCpuScheduler::takeDueEvent(quint64 now, QCpuSchedulerEvent& event)
+{
+    discardStaleEvents();
+
+    //is the earliest event due?
+    if (m_eventQueue.empty() || m_eventQueue.top().deadlineInMs > now)
+    {
+        return false;
+    }
+
+    //pop the event
+    event = m_eventQueue.top();
+    m_eventQueue.pop();
+    return true;
+}
+
+/**
+ * @brief QCpuScheduler::isStale
+ */
+bool QCpuScheduler::isStale(const QCpuSchedulerEvent& event) const
+{
+    auto generationIt = m_generationMap.constFind(event.pid);
+    return generationIt == m_generationMap.constEnd() || generationIt.value() != event.generation;
+}
+
+/**
+ * @brief QCpuScheduler::discardStaleEvents
+ */
+void QCpuScheduler::discardStaleEvents()
+{
+    while (!m_eventQueue.empty() && isStale(m_eventQueue.top()))
+    {
+        m_eventQueue.pop();
+    }
+}
+
+/**
+ * @brief QCpuScheduler::spreadPhases
+ */
+void QCpuScheduler::spreadPhases()
+{
+    //give each process an evenly spaced offset within the period
+    m_phaseMap.clear();
+
+    const quint64 count = static_cast<quint64>(m_phaseRing.size());
+    for (quint64 index = 0; index < count; ++index)
+    {
+        m_phaseMap.insert(m_phaseRing[static_cast<int>(index)], index * m_periodInMs / count);
+    }
+}
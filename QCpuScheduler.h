@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUSCHEDULER_H
+#define QCPUSCHEDULER_H
+
+#include <QHash>
+#include <QList>
+#include <algorithm>
+#include <optional>
+#include <queue>
+#include <vector>
+#include "QCpuTypes.h"
+
+/**
+ * @brief QCpuSchedulerAction enum
+ */
+enum class QCpuSchedulerAction
+{
+    Evaluate,   // compare the usage with the limit and stop the process if needed
+    Continue,   // resume a stopped process
+};
+
+/**
+ * @brief QCpuSchedulerEvent struct
+ */
+struct QCpuSchedulerEvent
+{
+    quint64 deadlineInMs       = 0;                              // when the event is due
+    pid_t pid                  = 0;                              // process id
+    quint32 generation         = 0;                              // generation of the process when scheduled
+    QCpuSchedulerAction action = QCpuSchedulerAction::Evaluate;  // what to do
+};
+
+/**
+ * @brief QCpuScheduler class
+ *
+ * Ordered deadline queue of stop/continue events. Every registered process
+ * gets its own phase offset within the control period so that the signals
+ * of different processes are spread evenly instead of landing on the same tick.
+ */
+class QCpuScheduler final
+{
+public:
+
+    explicit QCpuScheduler(quint64 periodInMs);
+
+    void addProcess(pid_t pid);
+    void removeProcess(pid_t pid);
+    bool contains(pid_t pid) const;
+
+    quint64 nextPhaseDeadline(pid_t pid, quint64 now) const;
+    void schedule(pid_t pid, quint64 deadlineInMs, QCpuSchedulerAction action);
+
+    std::optional<quint64> nextDeadline();
+    bool takeDueEvent(quint64 now, QCpuSchedulerEvent& event);
+
+private:
+
+    struct LaterDeadline
+    {
+        bool operator()(const QCpuSchedulerEvent& left, const QCpuSchedulerEvent& right) const
+        {
+            return left.deadlineInMs > right.deadlineInMs;
+        }
+    };
+
+    bool isStale(const QCpuSchedulerEvent& event) const;
+    void discardStaleEvents();
+    void spreadPhases();
+
+    const quint64 m_periodInMs;
+    quint32 m_nextGeneration { 1 };
+    QList<pid_t> m_phaseRing;                   // registered processes, in phase order
+    QHash<pid_t, quint64> m_phaseMap;           // pid -> phase offset in ms
+    QHash<pid_t, quint32> m_generationMap;      // pid -> current generation
+    std::priority_queue<QCpuSchedulerEvent, std::vector<QCpuSchedulerEvent>, LaterDeadline> m_eventQueue;
+};
+
+#endif // QCPUSCHEDULER_H
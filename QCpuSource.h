@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUSOURCE_H
+#define QCPUSOURCE_H
+
+#include <QObject>
+#include <memory>
+#include "QCpuTypes.h"
+#include "QCpuStringPool.h"
+
+/**
+ * @brief QCpuSource class
+ *
+ * What the model talks to: the local monitor or the fleet aggregator. The slots
+ * are invoked by name with queued connections, the signals are cross-thread.
+ */
+class QCpuSource : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit QCpuSource(QObject* parentPtr = nullptr) : QObject(parentPtr) {}
+
+    virtual std::shared_ptr<const QCpuStringPool> stringPool() const = 0;
+
+public slots:
+
+    virtual void setProcessLimit(pid_t pid, int cpuLimit) = 0;
+    virtual void removeProcessLimit(pid_t pid) = 0;
+    virtual void setProcessIoLimit(pid_t pid, qint64 ioLimitInBytesPerSecond) = 0;
+    virtual void removeProcessIoLimit(pid_t pid) = 0;
+    virtual void setSoftThrottling(bool enabled) = 0;
+    virtual void setSampleSource(int sampleSource) = 0;
+    virtual void setAutoProtection(bool enabled) = 0;
+    virtual void setSubscription(int subscription) = 0;
+    virtual void setRefreshInterval(int refreshIntervalInMs) = 0;
+    virtual void setExtendedStatistics(bool enabled) = 0;
+    virtual void setDescendantLimit(int descendantLimit) = 0;
+    virtual void requestProcessMetadata(const PidList pidList) = 0;
+    virtual void requestProcessStatistics(const PidList pidList) = 0;
+
+signals:
+
+    void updateProcessList(const QCpuProcessList processList); //This signal is cross-thread, don't use references
+
+    void updateProcessMetadata(const QCpuProcessMetadataList metadataList); //This signal is cross-thread, don't use references
+
+    void updateCpuLoadList(const QCpuLoadList cpuLoadList); //This signal is cross-thread, don't use references
+};
+
+#endif // QCPUSOURCE_H
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuStringPool.h"
+
+/**
+ * @brief QCpuStringPool::QCpuStringPool
+ */
+QCpuStringPool::QCpuStringPool()
+{
+    //the id 0 is reserved for the empty string
+    m_stringList.push_back(QString());
+}
+
+/**
+ * @brief QCpuStringPool::intern
+ */
+QCpuStringId QCpuStringPool::intern(const QString& string)
+{
+    //the empty string doesn't need a lookup
+    if (string.isEmpty())
+    {
+        return 0;
+    }
+
+    //already interned? the common case only takes the read lock
+    {
+        QReadLocker readLocker(&m_lock);
+        auto idIt = m_idMap.constFind(string);
+        if (idIt != m_idMap.constEnd())
+        {
+            return idIt.value();
+        }
+    }
+
+    //add the string, unless another writer did it in the meantime
+    QWriteLocker writeLocker(&m_lock);
+    auto idIt = m_idMap.constFind(string);
+    if (idIt != m_idMap.constEnd())
+    {
+        return idIt.value();
+    }
+
+    const QCpuStringId id = static_cast<QCpuStringId>(m_stringList.size());
+    m_stringList.push_back(string);
+    m_idMap.insert(string, id);
+    return id;
+}
+
+/**
+ * @brief QCpuStringPool::string
+ */
+QString QCpuStringPool::string(QCpuStringId id) const
+{
+    //the returned QString shares the pool's data, nothing is deep copied
+    QReadLocker readLocker(&m_lock);
+    return id < static_cast<QCpuStringId>(m_stringList.size()) ? m_stringList[static_cast<int>(id)] : QString();
+}
+
+/**
+ * @brief QCpuStringPool::size
+ */
+int QCpuStringPool::size() const
+{
+    QReadLocker readLocker(&m_lock);
+    return m_stringList.size();
+}
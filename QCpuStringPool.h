@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUSTRINGPOOL_H
+#define QCPUSTRINGPOOL_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief QCpuStringId, 0 is the empty string
+ */
+using QCpuStringId = quint32;
+
+/**
+ * @brief QCpuStringPool class
+ *
+ * Interns the strings shared by many processes (user names, command names)
+ * so that a row only holds ids. Written by the monitor thread, read by
+ * the GUI thread when a row is displayed. Strings are never released: the pool
+ * only holds values with a small number of distinct occurrences.
+ */
+class QCpuStringPool final
+{
+public:
+
+    explicit QCpuStringPool();
+
+    QCpuStringId intern(const QString& string);
+    QString string(QCpuStringId id) const;
+    int size() const;
+
+private:
+
+    mutable QReadWriteLock m_lock;
+    QVector<QString> m_stringList;              // id -> string
+    QHash<QString, QCpuStringId> m_idMap;       // string -> id
+};
+
+#endif // QCPUSTRINGPOOL_H
@@ -11,8 +11,11 @@
 #include <QString>
 #include <QMap>
 #include <unistd.h>
+#include <sched.h>
 #include <optional>
 #include <chrono>
+#include <vector>
+#include "QCpuStringPool.h"
 
 /**
  * @brief c_timerRefreshProcessListIntervalInMs constant
@@ -20,27 +23,271 @@
 using namespace std::chrono_literals;
 constexpr int c_timerRefreshProcessListIntervalInMs = std::chrono::milliseconds(1s).count();
 
+/**
+ * @brief bounds of the refresh interval chosen at runtime
+ */
+constexpr int c_minRefreshProcessListIntervalInMs = std::chrono::milliseconds(250ms).count();
+constexpr int c_maxRefreshProcessListIntervalInMs = std::chrono::milliseconds(10s).count();
+
+/**
+ * @brief c_hiddenRefreshDecimation constant
+ */
+constexpr int c_hiddenRefreshDecimation = 10; // a hidden GUI gets one process list every 10 refreshes
+
 /**
  * @brief c_timerCpuLimitIntervalInMs constant
  */
 constexpr int c_timerCpuLimitIntervalInMs = std::chrono::milliseconds(25ms).count();
 
 /**
- * @brief QCpuProcess struct
+ * @brief per-process sampling interval: c_minSampleIntervalInNs while active, doubled while idle up to c_maxSampleIntervalInNs
+ */
+constexpr quint64 c_minSampleIntervalInNs = std::chrono::nanoseconds(20ms).count();
+constexpr quint64 c_maxSampleIntervalInNs = std::chrono::nanoseconds(2s).count();
+
+/**
+ * @brief c_usageSeedIntervalInNs constant, window of the two-point sample that seeds the usage of a new process
+ */
+constexpr quint64 c_usageSeedIntervalInNs = std::chrono::nanoseconds(100ms).count();
+
+/**
+ * @brief c_firstRefreshDelayInMs constant, the second process list at startup carries the seeded usages
+ */
+constexpr int c_firstRefreshDelayInMs = std::chrono::milliseconds(150ms).count();
+
+/**
+ * @brief c_sampleActivityThreshold constant
+ */
+constexpr double c_sampleActivityThreshold = 0.005; // a sample above 0.5% of a CPU is activity
+
+/**
+ * @brief c_maxProcessEventsPerScan constant, process events handled per control tick, the others wait for the next tick
+ */
+constexpr int c_maxProcessEventsPerScan = 256;
+
+/**
+ * @brief c_timerSystemLoadIntervalInMs constant
+ */
+constexpr int c_timerSystemLoadIntervalInMs = std::chrono::milliseconds(250ms).count();
+
+/**
+ * @brief c_systemContentionThreshold constant
+ */
+constexpr double c_systemContentionThreshold = 0.9; // busy fraction of all CPUs [0.0..1.0]
+
+/**
+ * @brief c_timerPressureIntervalInMs constant
+ */
+constexpr int c_timerPressureIntervalInMs = std::chrono::milliseconds(2s).count();
+
+/**
+ * @brief PSI trigger: raise when the CPU stall time exceeds c_psiTriggerStallInUs over c_psiTriggerWindowInUs
+ */
+constexpr int c_psiTriggerStallInUs  = std::chrono::microseconds(150ms).count();
+constexpr int c_psiTriggerWindowInUs = std::chrono::microseconds(1s).count();
+
+/**
+ * @brief c_psiReleaseAverageInPercent constant
+ */
+constexpr double c_psiReleaseAverageInPercent = 5.0; // "some avg10" below which the automatic limits are lifted
+
+/**
+ * @brief hysteresis of the soft throttling: a demoted process gets its priority back once its usage
+ *        stayed below c_restoreUsageRatio of its limit for c_restoreEvaluationCount evaluations in a row
+ */
+constexpr double c_restoreUsageRatio     = 0.9;
+constexpr int    c_restoreEvaluationCount = 4;
+
+/**
+ * @brief c_demotedNice constant, the nice value of a demoted thread when SCHED_IDLE is not allowed
+ */
+constexpr int c_demotedNice = 19;
+
+/**
+ * @brief automatic protection: only processes above c_autoProtectionMinUsageInPercent are limited,
+ *        to c_autoProtectionLimitRatio of their current usage
+ */
+constexpr double c_autoProtectionMinUsageInPercent = 0.5;
+constexpr double c_autoProtectionLimitRatio        = 0.5;
+
+/**
+ * @brief c_minEnforcedCpuLimitInPercent constant, a CPU limit at or below it (a 0% limit) is not enforced
+ */
+constexpr double c_minEnforcedCpuLimitInPercent = 0.001;
+
+/**
+ * @brief c_minTreeShareInPercent constant, the smallest share of a limit tree (2% of a CPU)
+ *
+ * A smaller share would fall under the smallest enforced limit, or make each duty cycle stop the
+ * member for seconds. A large tree may then use more than its budget: n members times the share.
+ */
+constexpr double c_minTreeShareInPercent = 0.02;
+static_assert(c_minTreeShareInPercent > c_minEnforcedCpuLimitInPercent, "a share must be enforced");
+
+/**
+ * @brief c_maxCommandLineLength constant
+ */
+constexpr int c_maxCommandLineLength = 4096;
+
+/**
+ * @brief c_cpuUsageSmoothingStatTicks constant
+ */
+constexpr double c_cpuUsageSmoothingStatTicks = 0.08; // EWMA alpha for the tick-quantized samples
+
+/**
+ * @brief c_cpuUsageSmoothingSchedStat constant
+ */
+constexpr double c_cpuUsageSmoothingSchedStat = 0.3;  // EWMA alpha for the nanosecond samples
+
+/**
+ * @brief c_ioRateSmoothing constant
+ */
+constexpr double c_ioRateSmoothing = 0.3; // EWMA alpha of the I/O rate per fast sampling interval
+
+/**
+ * @brief QCpuSampleSource enum
+ */
+enum class QCpuSampleSource
+{
+    None,       // no sample taken yet
+    StatTicks,  // utime + stime from /proc/[pid]/stat, in clock ticks
+    SchedStat,  // sum_exec_runtime from /proc/[pid]/schedstat, in nanoseconds
+};
+
+/**
+ * @brief QCpuDescendantLimit enum, how a limit set by the user applies to the descendants of the process
+ */
+enum class QCpuDescendantLimit
+{
+    None,       // the limit applies to the process only
+    Inherit,    // every descendant gets the same limit
+    Share,      // the process and its descendants share the limit evenly
+};
+
+/**
+ * @brief QCpuSubscription enum
+ */
+enum class QCpuSubscription
+{
+    Visible,        // the process list is shown: every refresh is sent
+    Hidden,         // the window is minimized or hidden: refreshes are decimated
+};
+
+/**
+ * @brief QCpuThrottleState enum
+ */
+enum class QCpuThrottleState
+{
+    None,   // the process runs with its original priority
+    Soft,   // the process is demoted to SCHED_IDLE / lowest nice
+    Hard,   // the process is duty-cycled with SIGSTOP/SIGCONT
+};
+
+/**
+ * @brief QCpuStatCounters struct, the state and resource counters of /proc/[pid]/stat
+ */
+struct QCpuStatCounters
+{
+    char state                         = '?'; // R, S, D, T, Z...
+    quint64 minorFaults                = 0;  // page faults served without I/O
+    quint64 majorFaults                = 0;  // page faults that needed I/O
+    int threadCount                    = 0;  // number of threads
+    quint64 rssInBytes                 = 0;  // resident set size
+
+    bool operator==(const QCpuStatCounters& other) const
+    {
+        return state == other.state &&
+               minorFaults == other.minorFaults &&
+               majorFaults == other.majorFaults &&
+               threadCount == other.threadCount &&
+               rssInBytes == other.rssInBytes;
+    }
+};
+
+/**
+ * @brief QCpuThreadPriority struct, the priority of one thread before its process was demoted
+ */
+struct QCpuThreadPriority
+{
+    pid_t tid                          = 0;            // thread id
+    int nice                           = 0;            // nice value
+    int policy                         = SCHED_OTHER;  // scheduling policy, SCHED_RESET_ON_FORK included
+    int priority                       = 0;            // static priority of the real-time policies
+    bool niceDemoted                   = false;        // SCHED_IDLE was refused: the thread got c_demotedNice instead
+};
+
+/**
+ * @brief QCpuThreadPriorityList
+ */
+using QCpuThreadPriorityList = QList<QCpuThreadPriority>;
+
+/**
+ * @brief QCpuProcessHotState struct, touched by the sampler and the limiter at every deadline
+ */
+struct QCpuProcessHotState
+{
+    pid_t pid                          = 0;  // process id
+    QCpuSampleSource sampleSource      = QCpuSampleSource::None; // source of the CPU time
+    double cpuUsageInPercent           = 0;  // [0.0..1.0 * (CPU count)]
+    quint64 cpuTimeInNs                = 0;  // CPU time in ns
+    quint64 previousCpuTimeInNs        = 0;  // CPU time in ns at previous refresh
+    quint64 lastMeasuredTimestampInNs  = 0;  // monotonic timestamp of last measurement in ns
+    quint64 nextSampleTimestampInNs    = 0;  // monotonic timestamp of the next measurement in ns
+    quint64 sampleIntervalInNs         = c_minSampleIntervalInNs; // adaptive sampling interval
+    bool usageSeeded                   = false; // the first sample replaces the usage instead of being smoothed in
+
+    std::optional<double> cpuLimitInPercent; // CPU limit in percent (0.0..1.0)
+
+    quint64 ioBytes                    = 0;  // read_bytes + write_bytes from /proc/[pid]/io
+    quint64 ioTimestampInNs            = 0;  // monotonic timestamp of the last I/O read in ns, 0 before the baseline
+    double ioRateInBytesPerSecond      = 0;  // smoothed storage I/O rate
+    std::optional<quint64> ioLimitInBytesPerSecond; // I/O limit in bytes per second
+
+    int processor                      = -1; // CPU the process last ran on, -1 if unknown
+};
+
+/**
+ * @brief QCpuProcessColdState struct, touched on discovery, limit changes and UI refreshes only
+ */
+struct QCpuProcessColdState
+{
+    pid_t ppid                         = 0;  // parent process id
+    quint64 startTimeInTicks           = 0;  // start time after boot in ticks (identifies a reused pid)
+    quint32 nameHash                   = 0;  // hash of the comm field, changed by most execs
+    bool autoLimited                   = false;  // the limit was set by the automatic protection
+    int limitTreeId                    = 0;      // limit tree of the process (see QCpuDescendantLimit), 0 for none
+    bool limitTreeRoot                 = false;  // the user set the limit of the tree on this process
+
+    QCpuThrottleState throttleState    = QCpuThrottleState::None; // how the limit is currently enforced
+    bool demoted                       = false;        // the priority of the process was lowered
+    int calmEvaluationCount            = 0;            // evaluations in a row below the restore threshold while demoted
+    QCpuThreadPriorityList originalPriorityList;       // the demoted threads, with their priority before the demotion
+
+    QCpuStatCounters statCounters;           // refreshed for the rows shown by the view at refresh cadence, with the extended statistics only
+    quint64 voluntaryContextSwitches   = 0;  // from /proc/[pid]/status, same rows and cadence
+    quint64 involuntaryContextSwitches = 0;
+};
+
+/**
+ * @brief QCpuProcess struct, one row of the process list sent to the GUI
  */
 struct QCpuProcess
 {
     pid_t pid                          = 0;  // process id
     double cpuUsageInPercent           = 0;  // [0.0..1.0 * (CPU count)]
-    quint64 cpuTimeInTicks             = 0;  // CPU time in ticks (jiffies)
-    quint64 previousCpuTimeInTicks     = 0;  // CPU time in ticks (jiffies) at previous refresh
-    quint64 lastMeasuredTimestampInMs  = 0;  // timestamp of last measurement in ms
-    int sleepCountInCycle              = 0;  // number of sleep cycles to limit CPU usage
+    bool usageSeeded                   = false;  // the usage comes from a real sample
 
     std::optional<double> cpuLimitInPercent; // CPU limit in percent (0.0..1.0)
+    bool autoLimited                   = false;  // the limit was set by the automatic protection
+
+    double ioRateInBytesPerSecond      = 0;  // storage I/O rate, sampled for I/O limited processes only
+    std::optional<quint64> ioLimitInBytesPerSecond; // I/O limit in bytes per second
 
-    QString command;                        // command name with arguments
-    QString user;                           // user name
+    int processor                      = -1; // CPU the process last ran on, -1 if unknown
+    QCpuStatCounters statCounters;           // state, faults, threads and RSS, empty unless the extended statistics are enabled
+
+    quint64 voluntaryContextSwitches   = 0;  // 0 unless the extended statistics are enabled
+    quint64 involuntaryContextSwitches = 0;
 };
 
 /**
@@ -48,12 +295,89 @@ struct QCpuProcess
  */
 using QCpuProcessList = QList<QCpuProcess>;
 
+/**
+ * @brief QCpuProcessMetadata struct, loaded on demand for the rows shown by the view
+ */
+struct QCpuProcessMetadata
+{
+    pid_t pid                          = 0;  // process id
+    quint64 startTimeInTicks           = 0;  // start time after boot in ticks (cache key with the pid)
+    quint64 startTimestampInMs         = 0;  // start time since epoch in ms
+
+    QCpuStringId nameId                = 0;  // command name (interned)
+    QCpuStringId userId                = 0;  // user name (interned)
+
+    QString cwd;                            // current working directory, too many distinct values to intern
+    QString cgroup;                         // cgroup path, one per service or container: too many to intern
+    QString commandLine;                    // full command line, empty for kernel threads
+};
+
+/**
+ * @brief QCpuProcessMetadataList
+ */
+using QCpuProcessMetadataList = QList<QCpuProcessMetadata>;
+
+/**
+ * @brief QCpuStatSample struct, the fields read from /proc/[pid]/stat
+ */
+struct QCpuStatSample
+{
+    pid_t ppid                         = 0;  // parent process id
+    quint64 cpuTimeInNs                = 0;  // utime + stime in ns
+    quint64 startTimeInTicks           = 0;  // start time after boot in ticks
+    quint32 nameHash                   = 0;  // hash of the comm field, changed by most execs
+    int processor                      = -1; // CPU the process last ran on
+    QCpuStatCounters counters;               // parsed from the same line, no extra read
+};
+
+/**
+ * @brief QCpuSystemStat struct, the fields read from /proc/stat
+ */
+struct QCpuSystemStat
+{
+    quint64 totalTicks                 = 0;  // all CPUs, every state
+    quint64 idleTicks                  = 0;  // all CPUs, idle and iowait
+    std::vector<quint64> cpuTotalTicks;      // per CPU, indexed by CPU number, 0 for an offline CPU
+    std::vector<quint64> cpuIdleTicks;       // per CPU, indexed by CPU number
+    int cpuCount                       = 0;  // online CPUs
+    int runningProcesses               = 0;  // procs_running, the reader included
+};
+
+/**
+ * @brief QCpuProcessEventType enum
+ */
+enum class QCpuProcessEventType
+{
+    Fork,   // a new process
+    Exec,   // the process replaced its image, the pid is unchanged
+};
+
+/**
+ * @brief QCpuProcessEvent struct, a process created or exec'd since the previous read of the events
+ */
+struct QCpuProcessEvent
+{
+    pid_t pid                          = 0;  // process id of the child, or of the process that exec'd
+    pid_t ppid                         = 0;  // parent process id, 0 for an exec
+    QCpuProcessEventType type          = QCpuProcessEventType::Fork;
+};
+
+/**
+ * @brief QCpuProcessEventList
+ */
+using QCpuProcessEventList = QList<QCpuProcessEvent>;
+
+/**
+ * @brief QCpuLoadList, the busy fraction of each CPU (0.0..1.0) indexed by CPU number
+ */
+using QCpuLoadList = QList<double>;
+
 /**
  * @brief QUserMap
  */
 using UserID    = int;
 using UserName  = QString;
-using QUserMap  = QMap<UserID, UserName>;
+using QUserMap  = QMap<UserID, QCpuStringId>;   // uid -> interned user name
 
 /**
  * @brief PidList
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+import QtQuick 2.15
+import QtQuick.Controls 2.15
+import QCpuModel 1.0
+
+Row {
+    id: root
+
+    //the CPU selected to filter the process list, -1 for all
+    property int selectedCore: -1
+
+    //the cells are only created again when the CPU count changes, their load is a binding
+    Repeater {
+        model: QCpuModel.cpuCount
+
+        Rectangle {
+            readonly property real load: QCpuModel.cpuLoads[index] || 0
+
+            width: root.width / Math.max(QCpuModel.cpuCount, 1)
+            height: root.height
+            color: Qt.hsla((1.0 - load) / 3.0, 0.8, 0.5, 1.0)
+            border.width: index === root.selectedCore ? 2 : 0
+            border.color: "black"
+
+            ToolTip.visible: mouseArea.containsMouse
+            ToolTip.text: qsTr("CPU %1: %2 %").arg(index).arg((load * 100).toFixed(0))
+
+            MouseArea {
+                id: mouseArea
+                anchors.fill: parent
+                hoverEnabled: true
+
+                //select the CPU, select it again to show every process
+                onClicked: root.selectedCore = root.selectedCore === index ? -1 : index
+            }
+        }
+    }
+}
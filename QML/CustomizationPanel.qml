@@ -35,6 +35,34 @@ import QCpuModel 1.0
         }
     }
 
+    Row {
+        spacing: 5
+
+        Text {
+            text: qsTr("Working directory: ")
+        }
+
+        Text {
+            text: QCpuModel.selectedProcessCwd
+        }
+
+        Text {
+            text: qsTr("  Cgroup: ")
+        }
+
+        Text {
+            text: QCpuModel.selectedProcessCgroup
+        }
+
+        Text {
+            text: qsTr("  Started: ")
+        }
+
+        Text {
+            text: QCpuModel.selectedProcessStartTime
+        }
+    }
+
     Row {
         spacing: 5
 
@@ -80,4 +108,122 @@ import QCpuModel 1.0
             onClicked: QCpuModel.removeProcessLimit()
         }
     }
+
+    Row {
+        spacing: 5
+
+        Text {
+            text: qsTr("I/O limit MiB/s: ")
+            anchors.verticalCenter: parent.verticalCenter
+        }
+
+        Text {
+            text: QCpuModel.selectedProcessIoLimit == -1 ? "N/A" : QCpuModel.selectedProcessIoLimit
+            anchors.verticalCenter: parent.verticalCenter
+        }
+
+        SpinBox {
+            id: ioLimitSpinBox
+            from: 1
+            to: 10000
+            value: 10
+            editable: true
+            anchors.verticalCenter: parent.verticalCenter
+        }
+
+        Button {
+            text: "Set I/O Limit"
+            anchors.verticalCenter: parent.verticalCenter
+            onClicked: QCpuModel.setProcessIoLimit(ioLimitSpinBox.value)
+        }
+
+        Button {
+            text: "Reset I/O Limit"
+            anchors.verticalCenter: parent.verticalCenter
+            onClicked: QCpuModel.removeProcessIoLimit()
+        }
+    }
+
+    Row {
+        spacing: 5
+
+        CheckBox {
+            text: qsTr("Demote before stopping (stop only when the system is contended)")
+            checked: QCpuModel.softThrottling
+            anchors.verticalCenter: parent.verticalCenter
+            onToggled: QCpuModel.softThrottling = checked
+        }
+
+        CheckBox {
+            text: qsTr("Automatic protection under CPU pressure")
+            checked: QCpuModel.autoProtection
+            anchors.verticalCenter: parent.verticalCenter
+            onToggled: QCpuModel.autoProtection = checked
+        }
+
+        Text {
+            text: qsTr("Descendants: ")
+            anchors.verticalCenter: parent.verticalCenter
+        }
+
+        ComboBox {
+            width: 220
+            textRole: "text"
+            valueRole: "value"
+            anchors.verticalCenter: parent.verticalCenter
+            model: [
+                { text: qsTr("Not limited"), value: 0 },
+                { text: qsTr("Same limit each"), value: 1 },
+                { text: qsTr("Share the limit"), value: 2 }
+            ]
+            currentIndex: indexOfValue(QCpuModel.descendantLimit)
+            onActivated: QCpuModel.descendantLimit = currentValue
+        }
+
+        Text {
+            text: qsTr("Sampling: ")
+            anchors.verticalCenter: parent.verticalCenter
+        }
+
+        ComboBox {
+            width: 300
+            textRole: "text"
+            valueRole: "value"
+            anchors.verticalCenter: parent.verticalCenter
+            model: [
+                { text: qsTr("Clock ticks (/proc/[pid]/stat)"), value: 1 },
+                { text: qsTr("Nanoseconds (/proc/[pid]/schedstat)"), value: 2 }
+            ]
+            currentIndex: indexOfValue(QCpuModel.sampleSource)
+            onActivated: QCpuModel.sampleSource = currentValue
+        }
+
+        Text {
+            text: qsTr("Refresh: ")
+            anchors.verticalCenter: parent.verticalCenter
+        }
+
+        ComboBox {
+            width: 120
+            textRole: "text"
+            valueRole: "value"
+            anchors.verticalCenter: parent.verticalCenter
+            model: [
+                { text: qsTr("250 ms"), value: 250 },
+                { text: qsTr("500 ms"), value: 500 },
+                { text: qsTr("1 s"), value: 1000 },
+                { text: qsTr("2 s"), value: 2000 },
+                { text: qsTr("5 s"), value: 5000 }
+            ]
+            currentIndex: indexOfValue(QCpuModel.refreshInterval)
+            onActivated: QCpuModel.refreshInterval = currentValue
+        }
+
+        CheckBox {
+            text: qsTr("Extended statistics")
+            checked: QCpuModel.extendedStatistics
+            anchors.verticalCenter: parent.verticalCenter
+            onToggled: QCpuModel.extendedStatistics = checked
+        }
+    }
  }
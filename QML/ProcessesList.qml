@@ -6,55 +6,120 @@
 
 import QtQuick 2.15
 import QtQuick.Controls 2.15
-import QtQuick.Controls 1.4 as Old
+import Qt.labs.qmlmodels 1.0
 import QCpuModel 1.0
 
-Old.TableView {
+Item {
     id: root
-    model: QCpuModel
 
-    Old.TableViewColumn {
-        id: pidColumn
-        role: "pid"
-        title: "PID"
-        width: 150
-    }
+    //show only the processes that last ran on this CPU, -1 for all
+    property alias core: coreFilter.core
 
-    Old.TableViewColumn {
-        id: userColumn
-        role: "user"
-        title: "User"
-        width: 250
-    }
+    readonly property int rowHeight: 24
+    //the columns after the command are the extended statistics, only present while enabled
+    readonly property var columnWidths: [150, 250, 200, 200, 200, 80, 300, 60, 80, 100, 120, 120, 150, 150]
 
-    Old.TableViewColumn {
-        id: cpuUsageColumn
-        role: "cpuUsage"
-        title: "CPU Usage (%)"
-        width: 200
-    }
+    //the command column takes the remaining width
+    function columnWidth(column) {
+        if (column === 6) {
+            let commandColumnWidth = root.width
+            for (let other = 0; other < tableView.columns; ++other) {
+                if (other !== 6) {
+                    commandColumnWidth -= columnWidths[other]
+                }
+            }
 
-    Old.TableViewColumn {
-        id: cpuLimitColumn
-        role: "cpuLimit"
-        title: "CPU Limit (%)"
-        width: 200
+            return commandColumnWidth < columnWidths[6] ? columnWidths[6] : commandColumnWidth
+        }
+
+        return columnWidths[column]
     }
 
-    Old.TableViewColumn {
-        id: commandColumn
-        role: "command"
-        title: "Command"
-        width: 300
+    QCpuCoreFilterModel {
+        id: coreFilter
+        sourceModel: QCpuModel
     }
 
-    onWidthChanged: {
-        let commandColumnWidth = root.width - pidColumn.width - userColumn.width - cpuUsageColumn.width - cpuLimitColumn.width
-        commandColumnWidth = commandColumnWidth < 300 ? 300 : commandColumnWidth
-        commandColumn.width = commandColumnWidth
+    HorizontalHeaderView {
+        id: header
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.top: parent.top
+        syncView: tableView
+        clip: true
     }
 
-    onClicked: {
-        QCpuModel.selectProcess(row)
+    TableView {
+        id: tableView
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.top: header.bottom
+        anchors.bottom: parent.bottom
+        model: coreFilter
+        clip: true
+        reuseItems: true
+        boundsBehavior: Flickable.StopAtBounds
+
+        //fixed sizes: the view never measures the delegates
+        rowHeightProvider: function(row) { return root.rowHeight }
+        columnWidthProvider: function(column) { return root.columnWidth(column) }
+
+        onWidthChanged: forceLayout()
+        onColumnsChanged: forceLayout()
+
+        ScrollBar.vertical: ScrollBar { }
+
+        delegate: DelegateChooser {
+
+            //CPU usage: numeric value drawn as a bar behind the text
+            DelegateChoice {
+                column: 2
+
+                Rectangle {
+                    implicitHeight: root.rowHeight
+                    color: pid === QCpuModel.selectedProcessPid ? "lightsteelblue" : (row % 2 ? "#f5f5f5" : "white")
+
+                    Rectangle {
+                        anchors.left: parent.left
+                        anchors.top: parent.top
+                        anchors.bottom: parent.bottom
+                        width: parent.width * Math.min(cpuUsageValue, 1.0)
+                        color: "#c8e6c9"
+                    }
+
+                    Text {
+                        anchors.fill: parent
+                        anchors.leftMargin: 5
+                        verticalAlignment: Text.AlignVCenter
+                        text: (cpuUsageValue * 100).toFixed(2)
+                    }
+
+                    TapHandler {
+                        onTapped: QCpuModel.selectProcessByPid(pid)
+                    }
+                }
+            }
+
+            //other columns: plain text from the display role
+            DelegateChoice {
+
+                Rectangle {
+                    implicitHeight: root.rowHeight
+                    color: pid === QCpuModel.selectedProcessPid ? "lightsteelblue" : (row % 2 ? "#f5f5f5" : "white")
+
+                    Text {
+                        anchors.fill: parent
+                        anchors.leftMargin: 5
+                        verticalAlignment: Text.AlignVCenter
+                        elide: Text.ElideRight
+                        text: display !== undefined ? display : ""
+                    }
+
+                    TapHandler {
+                        onTapped: QCpuModel.selectProcessByPid(pid)
+                    }
+                }
+            }
+        }
     }
 }
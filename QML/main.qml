@@ -6,6 +6,7 @@
  
 import QtQuick 2.15
 import QtQuick.Controls 2.15
+import QtQuick.Window 2.15
 import QCpuModel 1.0
 
 ApplicationWindow {
@@ -15,13 +16,18 @@ ApplicationWindow {
 
     readonly property int windowMinimumWidth: 800
     readonly property int windowMinimumHeight: 600
-    readonly property int customizationPanelHeight: 150
+    readonly property int customizationPanelHeight: 250
 
     width: root.windowMinimumWidth
     height: root.windowMinimumHeight
     minimumWidth: root.windowMinimumWidth
     minimumHeight: root.windowMinimumHeight
 
+    //the monitor decimates the process list while nothing shows it
+    onVisibilityChanged: {
+        QCpuModel.subscription = (visibility === Window.Minimized || visibility === Window.Hidden) ? 1 : 0
+    }
+
     //Customization Panel
     CustomizationPanel {
         id: customizationPanel
@@ -32,13 +38,23 @@ ApplicationWindow {
         height: root.customizationPanelHeight
     }
 
+    //Per-CPU load, click a CPU to list its processes
+    CpuHeatStrip {
+        id: cpuHeatStrip
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.top: customizationPanel.bottom
+        height: 16
+    }
+
     //Processes List
     ProcessesList {
         id: processesList
         anchors.left: parent.left
         anchors.right: parent.right
-        anchors.top: customizationPanel.bottom
+        anchors.top: cpuHeatStrip.bottom
         anchors.bottom: parent.bottom
+        core: cpuHeatStrip.selectedCore
     }
 
     footer: Text {
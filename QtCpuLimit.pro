@@ -6,7 +6,7 @@
 #                                                           #
 #############################################################
 
-QT = core gui quick qml
+QT = core gui quick qml network
 
 TEMPLATE = app
 
@@ -18,15 +18,25 @@ QMAKE_CXXFLAGS += -Werror
 CONFIG += c++17
 QMAKE_CFLAGS += -std=c11
 
+include(QCpuCore.pri)
+
 HEADERS += \
-    QCpuTypes.h \
+    QCpuSource.h \
     QCpuModel.h \
-    QCpuMonitor.h
+    QCpuCoreFilterModel.h \
+    QCpuMonitor.h \
+    QCpuFleetProtocol.h \
+    QCpuFleetAgent.h \
+    QCpuFleetAggregator.h
 
 SOURCES += \
     main.cpp \
     QCpuModel.cpp \
-    QCpuMonitor.cpp
+    QCpuCoreFilterModel.cpp \
+    QCpuMonitor.cpp \
+    QCpuFleetProtocol.cpp \
+    QCpuFleetAgent.cpp \
+    QCpuFleetAggregator.cpp
 
 RESOURCES += \
     qml.qrc
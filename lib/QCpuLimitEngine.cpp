@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <QDebug>
+#include "QCpuLimitEngine.h"
+#include "QCpuLimiter.h"
+
+/**
+ * @brief QCpuLimitEnginePrivate struct, the core objects and the driving state
+ */
+struct QCpuLimitEnginePrivate
+{
+    QCpuProcessTable processTable;
+    QCpuSystemClock clock;
+    QCpuProcfsTimeSource timeSource;
+    QCpuSystemSignalSink signalSink;
+    QCpuLimiter limiter { processTable, clock, timeSource, signalSink };
+
+    mutable std::recursive_mutex mutex;      // the callback may call the setters from the driving thread
+    std::condition_variable_any condition;   // wakes the worker up for new deadlines or stop
+    std::thread workerThread;
+    bool running         { false };
+    bool wakeRequested   { false };
+
+    quint64 nextScanInNs { 0 };              // the first call scans immediately
+    quint64 nextSystemLoadInNs { 0 };        // same for the contention of the CPUs
+    QCpuLimitEngine::SampleCallback sampleCallback;
+    QCpuLimitSampleList sampleList;          // reused by every callback
+
+    void fillSampleList(QCpuLimitSampleList& list) const noexcept;
+    int nextDelayInMs() noexcept;
+    void wakeUp() noexcept;
+};
+
+/**
+ * @brief QCpuLimitEnginePrivate::fillSampleList
+ */
+void QCpuLimitEnginePrivate::fillSampleList(QCpuLimitSampleList& list) const noexcept
+{
+    //keep the capacity between the calls
+    list.clear();
+    list.reserve(static_cast<size_t>(processTable.size()));
+
+    for (int index = 0; index < processTable.size(); ++index)
+    {
+        const QCpuProcessHotState& process = processTable.hot(index);
+
+        QCpuLimitProcessSample sample;
+        sample.pid                    = process.pid;
+        sample.cpuUsage               = process.cpuUsageInPercent;
+        sample.ioRateInBytesPerSecond = process.ioRateInBytesPerSecond;
+        sample.processor              = process.processor;
+
+        if (process.cpuLimitInPercent.has_value())
+        {
+            sample.cpuLimit = static_cast<int>(std::lround(process.cpuLimitInPercent.value() * 100.0));
+        }
+
+        if (process.ioLimitInBytesPerSecond.has_value())
+        {
+            sample.ioLimitInBytesPerSecond = static_cast<std::int64_t>(process.ioLimitInBytesPerSecond.value());
+        }
+
+        list.push_back(sample);
+    }
+
+    //sorted by pid, like the snapshot of the monitor
+    std::sort(list.begin(), list.end(), [](const QCpuLimitProcessSample & left, const QCpuLimitProcessSample & right)
+    {
+        return left.pid < right.pid;
+    });
+}
+
+/**
+ * @brief QCpuLimitEnginePrivate::nextDelayInMs
+ */
+int QCpuLimitEnginePrivate::nextDelayInMs() noexcept
+{
+    //the next rescan and system load scan
+    const quint64 nowInNs = clock.monotonicInNs();
+    quint64 delayInNs = nextScanInNs > nowInNs ? nextScanInNs - nowInNs : 0;
+    delayInNs = std::min(delayInNs, nextSystemLoadInNs > nowInNs ? nextSystemLoadInNs - nowInNs : 0);
+
+    //the next sample
+    const std::optional<quint64> sampleDeadlineInNs = limiter.nextSampleDeadlineInNs();
+    if (sampleDeadlineInNs.has_value())
+    {
+        delayInNs = std::min(delayInNs, sampleDeadlineInNs.value() > nowInNs ? sampleDeadlineInNs.value() - nowInNs : 0);
+    }
+
+    //round up to the millisecond, waking up early would only spin
+    int delayInMs = static_cast<int>((delayInNs + 999'999) / 1'000'000);
+
+    //the next control event, on the same monotonic clock in ms
+    const std::optional<quint64> controlDeadlineInMs = limiter.nextControlDeadlineInMs();
+    if (controlDeadlineInMs.has_value())
+    {
+        const quint64 nowInMs = clock.monotonicInMs();
+        delayInMs = std::min(delayInMs, static_cast<int>(controlDeadlineInMs.value() > nowInMs ? controlDeadlineInMs.value() - nowInMs : 0));
+    }
+
+    return delayInMs;
+}
+
+/**
+ * @brief QCpuLimitEnginePrivate::wakeUp
+ */
+void QCpuLimitEnginePrivate::wakeUp() noexcept
+{
+    //a new limit adds deadlines the worker is not waiting for
+    wakeRequested = true;
+    condition.notify_all();
+}
+
+/**
+ * @brief QCpuLimitEngine::QCpuLimitEngine
+ */
+QCpuLimitEngine::QCpuLimitEngine()
+    : m_privatePtr(std::make_unique<QCpuLimitEnginePrivate>())
+{
+}
+
+/**
+ * @brief QCpuLimitEngine::~QCpuLimitEngine
+ */
+QCpuLimitEngine::~QCpuLimitEngine()
+{
+    //stop the worker before touching the processes
+    stop();
+
+    //resume the processes the engine limited and give back their priority, the others are left as they are
+    m_privatePtr->limiter.releaseLimitedProcesses();
+}
+
+/**
+ * @brief QCpuLimitEngine::start
+ */
+bool QCpuLimitEngine::start()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+
+    //already running
+    if (m_privatePtr->workerThread.joinable())
+    {
+        qDebug() << "QCpuLimitEngine::start: the engine is already running";
+        return false;
+    }
+
+    //drive the engine until stop is called
+    m_privatePtr->running = true;
+    m_privatePtr->workerThread = std::thread([this]()
+    {
+        std::unique_lock<std::recursive_mutex> workerLock(m_privatePtr->mutex);
+        while (m_privatePtr->running)
+        {
+            //process the due events, a setter called meanwhile wakes us up again
+            m_privatePtr->wakeRequested = false;
+            const int delayInMs = processEvents();
+
+            //sleep until the next deadline
+            m_privatePtr->condition.wait_for(workerLock, std::chrono::milliseconds(delayInMs), [this]()
+            {
+                return !m_privatePtr->running || m_privatePtr->wakeRequested;
+            });
+        }
+    });
+
+    return true;
+}
+
+/**
+ * @brief QCpuLimitEngine::stop
+ */
+void QCpuLimitEngine::stop()
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+
+        //not running
+        if (!m_privatePtr->workerThread.joinable())
+        {
+            return;
+        }
+
+        m_privatePtr->running = false;
+        m_privatePtr->condition.notify_all();
+    }
+
+    //the worker needs the lock to leave
+    m_privatePtr->workerThread.join();
+}
+
+/**
+ * @brief QCpuLimitEngine::processEvents
+ */
+int QCpuLimitEngine::processEvents()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+
+    //rescan the running processes every refresh interval
+    bool scanned = false;
+    const quint64 nowInNs = m_privatePtr->clock.monotonicInNs();
+    if (nowInNs >= m_privatePtr->nextScanInNs)
+    {
+        PidList removedList;
+        PidList changedList;
+        m_privatePtr->limiter.scanRunningProcesses(removedList, changedList);
+        m_privatePtr->nextScanInNs = nowInNs + static_cast<quint64>(c_timerRefreshProcessListIntervalInMs) * 1'000'000;
+        scanned = true;
+    }
+
+    //without contention an over-limit process is only demoted, like in the monitor
+    if (nowInNs >= m_privatePtr->nextSystemLoadInNs)
+    {
+        m_privatePtr->limiter.scanSystemLoad();
+        m_privatePtr->nextSystemLoadInNs = nowInNs + static_cast<quint64>(c_timerSystemLoadIntervalInMs) * 1'000'000;
+    }
+
+    //the children forked by the limited trees join them between the rescans
+    m_privatePtr->limiter.scanProcessEvents();
+
+    //sample and control the due processes only
+    m_privatePtr->limiter.sampleDueProcesses();
+    m_privatePtr->limiter.controlDueProcesses();
+
+    //report the processes after each rescan, a copy keeps the callback alive if it replaces itself
+    if (scanned && m_privatePtr->sampleCallback)
+    {
+        const SampleCallback sampleCallback = m_privatePtr->sampleCallback;
+        m_privatePtr->fillSampleList(m_privatePtr->sampleList);
+        sampleCallback(m_privatePtr->sampleList);
+    }
+
+    //the callback may have set new limits
+    return m_privatePtr->nextDelayInMs();
+}
+
+/**
+ * @brief QCpuLimitEngine::setProcessLimit
+ */
+bool QCpuLimitEngine::setProcessLimit(pid_t pid, int cpuLimit)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+
+    //ignore the action if the pid is the current process
+    if (pid == getpid())
+    {
+        qDebug() << "QCpuLimitEngine::setProcessLimit: cannot set a cpu limit for the current process";
+        return false;
+    }
+
+    //check if the cpu limit is valid
+    if (cpuLimit < 0 || cpuLimit > 100)
+    {
+        qDebug() << "QCpuLimitEngine::setProcessLimit: invalid cpu limit - cpuLimit:" << cpuLimit;
+        return false;
+    }
+
+    //find the process
+    const int index = m_privatePtr->processTable.indexOf(pid);
+    if (index < 0)
+    {
+        qDebug() << "QCpuLimitEngine::setProcessLimit: process not found - pid:" << pid;
+        return false;
+    }
+
+    //set the cpu limit, the descendants follow the policy
+    m_privatePtr->limiter.applyTreeLimit(index, static_cast<double>(cpuLimit) / 100.0);
+    m_privatePtr->wakeUp();
+    return true;
+}
+
+/**
+ * @brief QCpuLimitEngine::removeProcessLimit
+ */
+bool QCpuLimitEngine::removeProcessLimit(pid_t pid)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+
+    //find the process
+    const int index = m_privatePtr->processTable.indexOf(pid);
+    if (index < 0)
+    {
+        qDebug() << "QCpuLimitEngine::removeProcessLimit: process not found - pid:" << pid;
+        return false;
+    }
+
+    //remove the cpu limit, and the limits the descendants inherited from it
+    m_privatePtr->limiter.clearTreeLimit(index);
+    m_privatePtr->wakeUp();
+    return true;
+}
+
+/**
+ * @brief QCpuLimitEngine::setProcessIoLimit
+ */
+bool QCpuLimitEngine::setProcessIoLimit(pid_t pid, std::int64_t ioLimitInBytesPerSecond)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+
+    //ignore the action if the pid is the current process
+    if (pid == getpid())
+    {
+        qDebug() << "QCpuLimitEngine::setProcessIoLimit: cannot set an I/O limit for the current process";
+        return false;
+    }
+
+    //check if the I/O limit is valid
+    if (ioLimitInBytesPerSecond <= 0)
+    {
+        qDebug() << "QCpuLimitEngine::setProcessIoLimit: invalid I/O limit - ioLimitInBytesPerSecond:" << ioLimitInBytesPerSecond;
+        return false;
+    }
+
+    //find the process
+    const int index = m_privatePtr->processTable.indexOf(pid);
+    if (index < 0)
+    {
+        qDebug() << "QCpuLimitEngine::setProcessIoLimit: process not found - pid:" << pid;
+        return false;
+    }
+
+    //the I/O counters are only readable with the ptrace access mode of the process
+    quint64 ioBytes = 0;
+    if (!m_privatePtr->timeSource.readIoBytes(pid, ioBytes))
+    {
+        qDebug() << "QCpuLimitEngine::setProcessIoLimit: cannot read the I/O counters - pid:" << pid;
+        return false;
+    }
+
+    //set the I/O limit
+    m_privatePtr->limiter.applyIoLimit(index, static_cast<quint64>(ioLimitInBytesPerSecond));
+    m_privatePtr->wakeUp();
+    return true;
+}
+
+/**
+ * @brief QCpuLimitEngine::removeProcessIoLimit
+ */
+bool QCpuLimitEngine::removeProcessIoLimit(pid_t pid)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+
+    //find the process
+    const int index = m_privatePtr->processTable.indexOf(pid);
+    if (index < 0)
+    {
+        qDebug() << "QCpuLimitEngine::removeProcessIoLimit: process not found - pid:" << pid;
+        return false;
+    }
+
+    //remove the I/O limit
+    m_privatePtr->limiter.clearIoLimit(index);
+    m_privatePtr->wakeUp();
+    return true;
+}
+
+/**
+ * @brief QCpuLimitEngine::setSoftThrottling
+ */
+void QCpuLimitEngine::setSoftThrottling(bool enabled)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+    m_privatePtr->limiter.setSoftThrottling(enabled);
+}
+
+/**
+ * @brief QCpuLimitEngine::setDescendantPolicy
+ */
+void QCpuLimitEngine::setDescendantPolicy(QCpuLimitDescendantPolicy policy)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+
+    //the enums have the same values
+    m_privatePtr->limiter.setDescendantLimit(static_cast<QCpuDescendantLimit>(policy));
+    m_privatePtr->wakeUp();
+}
+
+/**
+ * @brief QCpuLimitEngine::setSampleCallback
+ */
+void QCpuLimitEngine::setSampleCallback(SampleCallback callback)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+    m_privatePtr->sampleCallback = std::move(callback);
+}
+
+/**
+ * @brief QCpuLimitEngine::snapshot
+ */
+QCpuLimitSampleList QCpuLimitEngine::snapshot() const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_privatePtr->mutex);
+
+    QCpuLimitSampleList list;
+    m_privatePtr->fillSampleList(list);
+    return list;
+}
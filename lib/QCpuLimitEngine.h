@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPULIMITENGINE_H
+#define QCPULIMITENGINE_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief QCpuLimitProcessSample struct, one process as seen by the engine
+ */
+struct QCpuLimitProcessSample
+{
+    pid_t pid                             = 0;  // process id
+    double cpuUsage                       = 0;  // [0.0..1.0 * (CPU count)]
+    int cpuLimit                          = -1; // CPU limit in percent [0..100], -1 without limit
+    double ioRateInBytesPerSecond         = 0;  // smoothed storage I/O rate
+    std::int64_t ioLimitInBytesPerSecond  = -1; // I/O limit, -1 without limit
+    int processor                         = -1; // CPU the process last ran on, -1 if unknown
+};
+
+using QCpuLimitSampleList = std::vector<QCpuLimitProcessSample>;
+
+/**
+ * @brief QCpuLimitDescendantPolicy enum, how a CPU limit applies to the descendants of the process
+ */
+enum class QCpuLimitDescendantPolicy
+{
+    None,       // the limit applies to the process only
+    Inherit,    // every descendant gets the same limit
+    Share,      // the process and its descendants share the limit evenly
+};
+
+struct QCpuLimitEnginePrivate;
+
+/**
+ * @brief QCpuLimitEngine class
+ *
+ * The sampling and limiting core behind a plain C++ API, for the programs that
+ * want to limit processes without a GUI, a QCoreApplication or an event loop.
+ * The engine either runs on its own thread (start/stop), or is driven by the
+ * caller with processEvents, which returns the delay until the next deadline.
+ * The sample callback is called after each rescan of the running processes,
+ * from the thread driving the engine; it may call the setters but not stop.
+ * All the methods are thread-safe.
+ */
+class QCpuLimitEngine final
+{
+public:
+
+    using SampleCallback = std::function<void(const QCpuLimitSampleList& sampleList)>;
+
+    QCpuLimitEngine();
+    ~QCpuLimitEngine();
+
+    QCpuLimitEngine(const QCpuLimitEngine&) = delete;
+    QCpuLimitEngine& operator=(const QCpuLimitEngine&) = delete;
+
+    bool start();
+    void stop();
+    int processEvents();
+
+    bool setProcessLimit(pid_t pid, int cpuLimit);
+    bool removeProcessLimit(pid_t pid);
+    bool setProcessIoLimit(pid_t pid, std::int64_t ioLimitInBytesPerSecond);
+    bool removeProcessIoLimit(pid_t pid);
+    void setSoftThrottling(bool enabled);
+    void setDescendantPolicy(QCpuLimitDescendantPolicy policy);
+
+    void setSampleCallback(SampleCallback callback);
+    QCpuLimitSampleList snapshot() const;
+
+private:
+
+    std::unique_ptr<QCpuLimitEnginePrivate> m_privatePtr;
+};
+
+#endif // QCPULIMITENGINE_H
@@ -0,0 +1,29 @@
+#############################################################
+#                                                           #
+#                 Qt CPU LIMIT - Core library               #
+#                                                           #
+#  The sampling and limiting core as a static library with  #
+#  a plain C++ API, for the programs without a GUI.         #
+#                                                           #
+#############################################################
+
+QT = core
+
+TEMPLATE = lib
+
+TARGET = QtCpuLimitCore
+
+CONFIG += staticlib
+
+QMAKE_CXXFLAGS += -Wall
+QMAKE_CXXFLAGS += -Wextra
+QMAKE_CXXFLAGS += -Werror
+CONFIG += c++17
+
+include(../QCpuCore.pri)
+
+HEADERS += \
+    QCpuLimitEngine.h
+
+SOURCES += \
+    QCpuLimitEngine.cpp
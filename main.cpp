@@ -6,13 +6,96 @@
 
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+#include <QCommandLineParser>
+#include <QSysInfo>
+#include <cstring>
 #include "QCpuModel.h"
+#include "QCpuCoreFilterModel.h"
+#include "QCpuFleetAgent.h"
+#include "QCpuFleetAggregator.h"
+
+/**
+ * @brief registerMetaTypes, the types of the cross-thread signals and queued invocations
+ */
+static void registerMetaTypes()
+{
+    qRegisterMetaType<QCpuProcessList>("QCpuProcessList");
+    qRegisterMetaType<PidList>("PidList");
+    qRegisterMetaType<QCpuProcess>("QCpuProcess");
+    qRegisterMetaType<QCpuProcessMetadataList>("QCpuProcessMetadataList");
+    qRegisterMetaType<QCpuLoadList>("QCpuLoadList");
+    qRegisterMetaType<pid_t>("pid_t");
+}
+
+/**
+ * @brief isAgentMode, the agent has no GUI: it must be known before the application is created
+ */
+static bool isAgentMode(int argc, char** argv)
+{
+    for (int index = 1; index < argc; ++index)
+    {
+        if (std::strcmp(argv[index], "--agent") == 0 || std::strncmp(argv[index], "--agent=", 8) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief addFleetOptions
+ */
+static void addFleetOptions(QCommandLineParser& parser)
+{
+    parser.addHelpOption();
+    parser.addOption({"agent", "Stream the local processes to the aggregator at <address> instead of showing them.", "address"});
+    parser.addOption({"aggregator", "Show the processes of the agents connecting to <address>.", "address"});
+    parser.addOption({"host-name", "Name of this host in the aggregator (default: the machine host name).", "name"});
+}
+
+/**
+ * @brief runAgent, no GUI: the monitor streams to the aggregator
+ */
+static int runAgent(int argc, char** argv)
+{
+    //create Qt core application
+    QCoreApplication app(argc, argv);
+    registerMetaTypes();
+
+    //parse the arguments
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Qt CPU Limit agent. Addresses are [host:]port or unix:<path>.");
+    addFleetOptions(parser);
+    parser.process(app);
+
+    QCpuFleetAddress address;
+    if (!QCpuFleetAddress::parse(parser.value("agent"), address))
+    {
+        qDebug() << "main: invalid agent address - address:" << parser.value("agent");
+        return 1;
+    }
+
+    //the agent subscribes to the monitor like the model does
+    const QString hostName = parser.isSet("host-name") ? parser.value("host-name") : QSysInfo::machineHostName();
+    QCpuMonitor* monitorPtr = QCpuMonitor::create();
+    new QCpuFleetAgent(monitorPtr, address, hostName, &app);
+
+    //exec the Qt Loop Event
+    return QCoreApplication::exec();
+}
 
 /**
  * @brief main function
  */
 int main(int argc, char** argv)
 {
+    //agent mode
+    if (isAgentMode(argc, argv))
+    {
+        return runAgent(argc, argv);
+    }
+
     //enable Qt parameters
     QGuiApplication::setApplicationDisplayName("Qt CPU Limit");
     QGuiApplication::setApplicationName("Qt CPU Limit");
@@ -22,21 +105,40 @@ int main(int argc, char** argv)
     QGuiApplication app(argc, argv);
 
     //register meta type
-    qRegisterMetaType<QCpuProcessList>("QCpuProcessList");
-    qRegisterMetaType<PidList>("PidList");
-    qRegisterMetaType<QCpuProcess>("QCpuProcess");
-    qRegisterMetaType<pid_t>("pid_t");
+    registerMetaTypes();
+
+    //parse the arguments
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Qt CPU Limit. Addresses are [host:]port or unix:<path>.");
+    addFleetOptions(parser);
+    parser.process(app);
+
+    //aggregator mode: the model shows the agents instead of the local processes
+    QCpuFleetAggregator* aggregatorPtr = nullptr;
+    if (parser.isSet("aggregator"))
+    {
+        QCpuFleetAddress address;
+        aggregatorPtr = new QCpuFleetAggregator(&app);
+        if (!QCpuFleetAddress::parse(parser.value("aggregator"), address) || !aggregatorPtr->listen(address))
+        {
+            qDebug() << "main: cannot start the aggregator - address:" << parser.value("aggregator");
+            return 1;
+        }
+    }
 
     //create QCpuModel object
     qmlRegisterSingletonType<QCpuModel>(
         "QCpuModel", 1, 0,
         "QCpuModel",
-        [](QQmlEngine*, QJSEngine*)
+        [aggregatorPtr](QQmlEngine*, QJSEngine*)
     {
         //owned by the QML engine
-        return new QCpuModel;
+        return new QCpuModel(aggregatorPtr);
     });
 
+    //register the per-CPU filter of the process list
+    qmlRegisterType<QCpuCoreFilterModel>("QCpuModel", 1, 0, "QCpuCoreFilterModel");
+
     //create Qt QML engine
     QQmlApplicationEngine engine;
 
@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include "QCpuSimulation.h"
+
+/**
+ * @brief QCpuVirtualClock::monotonicInNs
+ */
+quint64 QCpuVirtualClock::monotonicInNs() const noexcept
+{
+    return m_nowInNs;
+}
+
+/**
+ * @brief QCpuVirtualClock::advanceTo
+ */
+void QCpuVirtualClock::advanceTo(quint64 nowInNs) noexcept
+{
+    //the time never goes back
+    m_nowInNs = std::max(m_nowInNs, nowInNs);
+}
+
+/**
+ * @brief QCpuSimulatedSystem::QCpuSimulatedSystem
+ */
+QCpuSimulatedSystem::QCpuSimulatedSystem(const QCpuVirtualClock& clock)
+    : m_clock(clock)
+{
+}
+
+/**
+ * @brief QCpuSimulatedSystem::addProcess
+ */
+void QCpuSimulatedSystem::addProcess(pid_t pid, QCpuWorkload workload)
+{
+    QCpuSimulatedProcess process;
+    process.pid            = pid;
+    process.workload       = workload;
+    process.lastUpdateInNs = m_clock.monotonicInNs();
+    m_processList.push_back(process);
+}
+
+/**
+ * @brief QCpuSimulatedSystem::startWindow
+ */
+void QCpuSimulatedSystem::startWindow() noexcept
+{
+    //the report only covers what happens after the warm-up
+    std::for_each(m_processList.begin(), m_processList.end(), [this](QCpuSimulatedProcess & process)
+    {
+        integrate(process);
+        process.windowCpuTimeInNs = process.cpuTimeInNs;
+        process.stopCount         = 0;
+        process.continueCount     = 0;
+        process.demoteCount       = 0;
+    });
+}
+
+/**
+ * @brief QCpuSimulatedSystem::processes
+ */
+const std::vector<QCpuSimulatedProcess>& QCpuSimulatedSystem::processes()
+{
+    //bring every process to the current time
+    std::for_each(m_processList.begin(), m_processList.end(), [this](QCpuSimulatedProcess & process)
+    {
+        integrate(process);
+    });
+
+    return m_processList;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::meanDemand
+ */
+double QCpuSimulatedSystem::meanDemand(QCpuWorkload workload) noexcept
+{
+    switch (workload)
+    {
+        case QCpuWorkload::Steady:
+            return 1.0;
+
+        case QCpuWorkload::Bursty:
+            return 0.3;
+
+        case QCpuWorkload::Multithreaded:
+            return 4.0;
+
+        case QCpuWorkload::Sleeping:
+            return 0.02;
+    }
+
+    return 0.0;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::workloadName
+ */
+QString QCpuSimulatedSystem::workloadName(QCpuWorkload workload)
+{
+    switch (workload)
+    {
+        case QCpuWorkload::Steady:
+            return "steady";
+
+        case QCpuWorkload::Bursty:
+            return "bursty";
+
+        case QCpuWorkload::Multithreaded:
+            return "multithreaded";
+
+        case QCpuWorkload::Sleeping:
+            return "sleeping";
+    }
+
+    return QString();
+}
+
+/**
+ * @brief QCpuSimulatedSystem::listProcesses
+ */
+bool QCpuSimulatedSystem::listProcesses(PidList& pidList) noexcept
+{
+    std::for_each(m_processList.cbegin(), m_processList.cend(), [&pidList](const QCpuSimulatedProcess & process)
+    {
+        pidList.push_back(process.pid);
+    });
+
+    return true;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::readProcessEvents
+ */
+bool QCpuSimulatedSystem::readProcessEvents(QCpuProcessEventList& eventList, int maxEventCount) noexcept
+{
+    //the simulated processes never fork: nothing was lost either
+    Q_UNUSED(eventList)
+    Q_UNUSED(maxEventCount)
+    return true;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::readStat
+ */
+bool QCpuSimulatedSystem::readStat(pid_t pid, QCpuStatSample& sample) noexcept
+{
+    QCpuSimulatedProcess* processPtr = process(pid);
+    if (!processPtr)
+    {
+        return false;
+    }
+
+    //the stat counters are quantized to clock ticks
+    integrate(*processPtr);
+    const quint64 tickInNs = 1'000'000'000 / c_simulatedTicksPerSecond;
+    sample.ppid             = 1;
+    sample.cpuTimeInNs      = static_cast<quint64>(processPtr->cpuTimeInNs) / tickInNs * tickInNs;
+    sample.startTimeInTicks = 0;
+    sample.processor        = 0;
+    sample.counters.state       = processPtr->stopped ? 'T' : 'R';
+    sample.counters.threadCount = processPtr->workload == QCpuWorkload::Multithreaded ? 4 : 1;
+    return true;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::readSchedStatCpuTime
+ */
+bool QCpuSimulatedSystem::readSchedStatCpuTime(pid_t pid, quint64& cpuTimeInNs) noexcept
+{
+    QCpuSimulatedProcess* processPtr = process(pid);
+    if (!processPtr)
+    {
+        return false;
+    }
+
+    //schedstat is exact to the nanosecond
+    integrate(*processPtr);
+    cpuTimeInNs = static_cast<quint64>(processPtr->cpuTimeInNs);
+    return true;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::readIoBytes
+ */
+bool QCpuSimulatedSystem::readIoBytes(pid_t pid, quint64& ioBytes) noexcept
+{
+    //the simulated workloads don't do any I/O
+    Q_UNUSED(pid)
+    ioBytes = 0;
+    return false;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::readContextSwitches
+ */
+bool QCpuSimulatedSystem::readContextSwitches(pid_t pid, quint64& voluntary, quint64& involuntary) noexcept
+{
+    //the scheduler isn't simulated
+    Q_UNUSED(pid)
+    voluntary   = 0;
+    involuntary = 0;
+    return false;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::readSystemStat
+ */
+bool QCpuSimulatedSystem::readSystemStat(QCpuSystemStat& systemStat) noexcept
+{
+    //the workloads set the contention of the simulated system themselves
+    Q_UNUSED(systemStat)
+    return false;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::stopProcess
+ */
+void QCpuSimulatedSystem::stopProcess(pid_t pid) noexcept
+{
+    QCpuSimulatedProcess* processPtr = process(pid);
+    if (!processPtr)
+    {
+        return;
+    }
+
+    //account the CPU time used until now, then stop
+    integrate(*processPtr);
+    processPtr->stopped = true;
+    processPtr->stopCount++;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::continueProcess
+ */
+void QCpuSimulatedSystem::continueProcess(pid_t pid) noexcept
+{
+    QCpuSimulatedProcess* processPtr = process(pid);
+    if (!processPtr)
+    {
+        return;
+    }
+
+    //the stopped time is not accounted, then resume
+    integrate(*processPtr);
+    processPtr->stopped = false;
+    processPtr->continueCount++;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::demoteProcess
+ */
+bool QCpuSimulatedSystem::demoteProcess(pid_t pid, QCpuProcessColdState& control) noexcept
+{
+    //a lower priority only matters against competing processes, which aren't simulated
+    Q_UNUSED(control)
+    QCpuSimulatedProcess* processPtr = process(pid);
+    if (!processPtr)
+    {
+        return false;
+    }
+
+    processPtr->demoteCount++;
+    return true;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::restoreProcess
+ */
+void QCpuSimulatedSystem::restoreProcess(pid_t pid, const QCpuProcessColdState& control) noexcept
+{
+    Q_UNUSED(pid)
+    Q_UNUSED(control)
+}
+
+/**
+ * @brief QCpuSimulatedSystem::process
+ */
+QCpuSimulatedProcess* QCpuSimulatedSystem::process(pid_t pid) noexcept
+{
+    //the pids are allocated contiguously
+    const qint64 index = static_cast<qint64>(pid) - c_simulatedFirstPid;
+    if (index < 0 || index >= static_cast<qint64>(m_processList.size()))
+    {
+        return nullptr;
+    }
+
+    return &m_processList[static_cast<size_t>(index)];
+}
+
+/**
+ * @brief QCpuSimulatedSystem::integrate
+ */
+void QCpuSimulatedSystem::integrate(QCpuSimulatedProcess& process) noexcept
+{
+    //a stopped process doesn't run
+    const quint64 nowInNs = m_clock.monotonicInNs();
+    if (!process.stopped)
+    {
+        process.cpuTimeInNs += demandInNs(process, process.lastUpdateInNs, nowInNs);
+    }
+
+    process.lastUpdateInNs = nowInNs;
+}
+
+/**
+ * @brief QCpuSimulatedSystem::demandInNs
+ */
+double QCpuSimulatedSystem::demandInNs(const QCpuSimulatedProcess& process, quint64 fromInNs, quint64 toInNs) noexcept
+{
+    //the CPU time the workload would use if it ran from fromInNs to toInNs
+    if (toInNs <= fromInNs)
+    {
+        return 0.0;
+    }
+
+    const double elapsedInNs = static_cast<double>(toInNs - fromInNs);
+    switch (process.workload)
+    {
+        case QCpuWorkload::Steady:
+        case QCpuWorkload::Multithreaded:
+        case QCpuWorkload::Sleeping:
+            return meanDemand(process.workload) * elapsedInNs;
+
+        case QCpuWorkload::Bursty:
+        {
+            //runnable during the first 300 ms of every second, each process on its own phase
+            static constexpr quint64 periodInNs = 1'000'000'000;
+            static constexpr quint64 burstInNs  = 300'000'000;
+            const quint64 phaseInNs = static_cast<quint64>(process.pid) * 7'919'000 % periodInNs;
+            auto burstTimeUntil = [phaseInNs](quint64 timeInNs)
+            {
+                const quint64 shiftedInNs = timeInNs + phaseInNs;
+                return (shiftedInNs / periodInNs) * burstInNs + std::min(shiftedInNs % periodInNs, burstInNs);
+            };
+
+            return static_cast<double>(burstTimeUntil(toInNs) - burstTimeUntil(fromInNs));
+        }
+    }
+
+    return 0.0;
+}
+
+/**
+ * @brief QCpuSimulation::QCpuSimulation
+ */
+QCpuSimulation::QCpuSimulation(const QCpuSimulationSettings& settings)
+    : m_settings(settings)
+{
+    //configure the limiter like the monitor does
+    m_limiter.setSampleSource(settings.sampleSource);
+    m_limiter.setSoftThrottling(settings.softThrottling);
+    m_limiter.setSystemContended(settings.systemContended);
+
+    //create the processes, the workloads are interleaved
+    for (int index = 0; index < settings.processCount; ++index)
+    {
+        m_system.addProcess(c_simulatedFirstPid + index, static_cast<QCpuWorkload>(index % 4));
+    }
+
+    //discover them like the monitor does, through the rescan
+    PidList removedList;
+    PidList changedList;
+    m_limiter.scanRunningProcesses(removedList, changedList);
+
+    //limit every discovered process
+    for (int index = 0; index < m_processTable.size(); ++index)
+    {
+        m_limiter.applyCpuLimit(index, settings.cpuLimitInPercent);
+    }
+}
+
+/**
+ * @brief QCpuSimulation::run
+ */
+void QCpuSimulation::run()
+{
+    QElapsedTimer wallClock;
+    wallClock.start();
+
+    const quint64 warmupEndInNs = m_clock.monotonicInNs() + m_settings.warmupInS * 1'000'000'000;
+    const quint64 endInNs = m_clock.monotonicInNs() + m_settings.durationInS * 1'000'000'000;
+    bool warmedUp = false;
+
+    //jump from deadline to deadline
+    while (true)
+    {
+        quint64 nextInNs = endInNs;
+        if (!warmedUp)
+        {
+            nextInNs = std::min(nextInNs, warmupEndInNs);
+        }
+
+        const std::optional<quint64> sampleDeadline = m_limiter.nextSampleDeadlineInNs();
+        if (sampleDeadline.has_value())
+        {
+            nextInNs = std::min(nextInNs, sampleDeadline.value());
+        }
+
+        const std::optional<quint64> controlDeadline = m_limiter.nextControlDeadlineInMs();
+        if (controlDeadline.has_value())
+        {
+            nextInNs = std::min(nextInNs, controlDeadline.value() * 1'000'000);
+        }
+
+        m_clock.advanceTo(nextInNs);
+
+        //the warm-up is over: start measuring
+        if (!warmedUp && m_clock.monotonicInNs() >= warmupEndInNs)
+        {
+            m_system.startWindow();
+            warmedUp = true;
+        }
+
+        //the simulation is over
+        if (m_clock.monotonicInNs() >= endInNs)
+        {
+            break;
+        }
+
+        m_limiter.scanProcessEvents();
+        m_limiter.sampleDueProcesses();
+
+        //time the control cycles, the wake-ups of the sampler alone don't count
+        if (controlDeadline.has_value() && controlDeadline.value() * 1'000'000 <= nextInNs)
+        {
+            QElapsedTimer controlClock;
+            controlClock.start();
+            m_limiter.controlDueProcesses();
+
+            const quint64 controlTimeInNs = static_cast<quint64>(controlClock.nsecsElapsed());
+            m_controlTimeInNs   += controlTimeInNs;
+            m_controlTimeMaxInNs = std::max(m_controlTimeMaxInNs, controlTimeInNs);
+            m_controlCycleCount++;
+        }
+        else
+        {
+            m_limiter.controlDueProcesses();
+        }
+
+        m_eventCount++;
+    }
+
+    m_wallTimeInMs = wallClock.elapsed();
+}
+
+/**
+ * @brief QCpuSimulation::report
+ */
+void QCpuSimulation::report(QTextStream& out)
+{
+    struct WorkloadReport
+    {
+        int processCount       = 0;
+        double achievedSum     = 0;
+        double errorSum        = 0;
+        double errorMax        = 0;
+        quint64 stopCount      = 0;
+        quint64 continueCount  = 0;
+        quint64 demoteCount    = 0;
+    };
+
+    //the tracking error is the distance between the achieved usage and min(limit, demand)
+    const double windowInS = static_cast<double>(m_settings.durationInS - m_settings.warmupInS);
+    QHash<int, WorkloadReport> reportMap;
+    const std::vector<QCpuSimulatedProcess>& processList = m_system.processes();
+    std::for_each(processList.cbegin(), processList.cend(), [this, windowInS, &reportMap](const QCpuSimulatedProcess & process)
+    {
+        const double achieved = (process.cpuTimeInNs - process.windowCpuTimeInNs) / (windowInS * 1e9);
+        const double target = std::min(m_settings.cpuLimitInPercent, QCpuSimulatedSystem::meanDemand(process.workload));
+        const double error = std::abs(achieved - target);
+
+        WorkloadReport& workloadReport = reportMap[static_cast<int>(process.workload)];
+        workloadReport.processCount++;
+        workloadReport.achievedSum   += achieved;
+        workloadReport.errorSum      += error;
+        workloadReport.errorMax       = std::max(workloadReport.errorMax, error);
+        workloadReport.stopCount     += process.stopCount;
+        workloadReport.continueCount += process.continueCount;
+        workloadReport.demoteCount   += process.demoteCount;
+    });
+
+    out << QString("processes: %1, virtual time: %2 s (warm-up %3 s), wall time: %4 ms, wake-ups: %5\n")
+           .arg(m_settings.processCount)
+           .arg(m_settings.durationInS)
+           .arg(m_settings.warmupInS)
+           .arg(m_wallTimeInMs)
+           .arg(m_eventCount);
+
+    out << QString("control cycles: %1, mean: %2 us, max: %3 us\n")
+           .arg(m_controlCycleCount)
+           .arg(m_controlCycleCount > 0 ? m_controlTimeInNs / 1000.0 / m_controlCycleCount : 0.0, 0, 'f', 2)
+           .arg(m_controlTimeMaxInNs / 1000.0, 0, 'f', 2);
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+           .arg("workload", -14)
+           .arg("count", 6)
+           .arg("target %", 9)
+           .arg("achieved %", 11)
+           .arg("mean err %", 11)
+           .arg("max err %", 10)
+           .arg("STOP/s", 8)
+           .arg("CONT/s", 8)
+           .arg("demotes", 8);
+
+    for (int workload = 0; workload < 4; ++workload)
+    {
+        if (!reportMap.contains(workload))
+        {
+            continue;
+        }
+
+        //the signal counts are per process and per second of the measured window
+        const WorkloadReport& workloadReport = reportMap[workload];
+        const double processSeconds = workloadReport.processCount * windowInS;
+        const double target = std::min(m_settings.cpuLimitInPercent, QCpuSimulatedSystem::meanDemand(static_cast<QCpuWorkload>(workload)));
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg(QCpuSimulatedSystem::workloadName(static_cast<QCpuWorkload>(workload)), -14)
+               .arg(workloadReport.processCount, 6)
+               .arg(target * 100, 9, 'f', 2)
+               .arg(workloadReport.achievedSum / workloadReport.processCount * 100, 11, 'f', 2)
+               .arg(workloadReport.errorSum / workloadReport.processCount * 100, 11, 'f', 2)
+               .arg(workloadReport.errorMax * 100, 10, 'f', 2)
+               .arg(workloadReport.stopCount / processSeconds, 8, 'f', 2)
+               .arg(workloadReport.continueCount / processSeconds, 8, 'f', 2)
+               .arg(workloadReport.demoteCount, 8);
+    }
+
+    out.flush();
+}
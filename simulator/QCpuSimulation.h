@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#ifndef QCPUSIMULATION_H
+#define QCPUSIMULATION_H
+
+#include <QHash>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "QCpuLimiter.h"
+
+/**
+ * @brief c_simulatedTicksPerSecond constant, resolution of the simulated /proc/[pid]/stat
+ */
+constexpr quint64 c_simulatedTicksPerSecond = 100;
+
+/**
+ * @brief c_simulatedFirstPid constant
+ */
+constexpr pid_t c_simulatedFirstPid = 1000;
+
+/**
+ * @brief QCpuWorkload enum
+ */
+enum class QCpuWorkload
+{
+    Steady,         // one thread always runnable
+    Bursty,         // one thread runnable 300 ms every second
+    Multithreaded,  // four threads always runnable
+    Sleeping,       // mostly asleep, 2% of a CPU
+};
+
+/**
+ * @brief QCpuSimulatedProcess struct
+ */
+struct QCpuSimulatedProcess
+{
+    pid_t pid                          = 0;  // process id
+    QCpuWorkload workload              = QCpuWorkload::Steady;
+    bool stopped                       = false;  // SIGSTOP received, waiting for SIGCONT
+    double cpuTimeInNs                 = 0;  // exact CPU time consumed
+    quint64 lastUpdateInNs             = 0;  // virtual time the CPU time was integrated to
+    double windowCpuTimeInNs           = 0;  // CPU time at the end of the warm-up
+    quint64 stopCount                  = 0;  // SIGSTOP signals received
+    quint64 continueCount              = 0;  // SIGCONT signals received
+    quint64 demoteCount                = 0;  // priority demotions
+};
+
+/**
+ * @brief QCpuSimulationSettings struct
+ */
+struct QCpuSimulationSettings
+{
+    int processCount                   = 1000;
+    quint64 durationInS                = 120;    // virtual time
+    quint64 warmupInS                  = 10;     // virtual time excluded from the report
+    double cpuLimitInPercent           = 0.5;    // limit of every process (0.0..1.0)
+    QCpuSampleSource sampleSource      = QCpuSampleSource::SchedStat;
+    bool softThrottling                = false;
+    bool systemContended               = true;
+};
+
+/**
+ * @brief QCpuVirtualClock class, only moves when the simulation advances it
+ */
+class QCpuVirtualClock final : public QCpuClock
+{
+public:
+
+    quint64 monotonicInNs() const noexcept override;
+
+    void advanceTo(quint64 nowInNs) noexcept;
+
+private:
+
+    quint64 m_nowInNs { 1'000'000'000 };    // non-zero: 0 means "never measured" for the limiter
+};
+
+/**
+ * @brief QCpuSimulatedSystem class
+ *
+ * Plays the kernel for the limiter: the CPU time of each process is integrated
+ * from its workload over the virtual time it was not stopped.
+ */
+class QCpuSimulatedSystem final : public QCpuTimeSource, public QCpuSignalSink
+{
+public:
+
+    explicit QCpuSimulatedSystem(const QCpuVirtualClock& clock);
+
+    void addProcess(pid_t pid, QCpuWorkload workload);
+    void startWindow() noexcept;
+    const std::vector<QCpuSimulatedProcess>& processes();
+
+    static double meanDemand(QCpuWorkload workload) noexcept;
+    static QString workloadName(QCpuWorkload workload);
+
+    bool listProcesses(PidList& pidList) noexcept override;
+    bool readProcessEvents(QCpuProcessEventList& eventList, int maxEventCount) noexcept override;
+    bool readStat(pid_t pid, QCpuStatSample& sample) noexcept override;
+    bool readSchedStatCpuTime(pid_t pid, quint64& cpuTimeInNs) noexcept override;
+    bool readIoBytes(pid_t pid, quint64& ioBytes) noexcept override;
+    bool readContextSwitches(pid_t pid, quint64& voluntary, quint64& involuntary) noexcept override;
+    bool readSystemStat(QCpuSystemStat& systemStat) noexcept override;
+
+    void stopProcess(pid_t pid) noexcept override;
+    void continueProcess(pid_t pid) noexcept override;
+    bool demoteProcess(pid_t pid, QCpuProcessColdState& control) noexcept override;
+    void restoreProcess(pid_t pid, const QCpuProcessColdState& control) noexcept override;
+
+private:
+
+    QCpuSimulatedProcess* process(pid_t pid) noexcept;
+    void integrate(QCpuSimulatedProcess& process) noexcept;
+    static double demandInNs(const QCpuSimulatedProcess& process, quint64 fromInNs, quint64 toInNs) noexcept;
+
+    const QCpuVirtualClock& m_clock;
+    std::vector<QCpuSimulatedProcess> m_processList;
+};
+
+/**
+ * @brief QCpuSimulation class
+ */
+class QCpuSimulation final
+{
+public:
+
+    explicit QCpuSimulation(const QCpuSimulationSettings& settings);
+
+    void run();
+    void report(QTextStream& out);
+
+private:
+
+    const QCpuSimulationSettings m_settings;
+    QCpuProcessTable m_processTable;
+    QCpuVirtualClock m_clock;
+    QCpuSimulatedSystem m_system { m_clock };
+    QCpuLimiter m_limiter { m_processTable, m_clock, m_system, m_system };
+    qint64 m_wallTimeInMs { 0 };
+    quint64 m_eventCount { 0 };
+    quint64 m_controlTimeInNs { 0 };       // wall time spent in the control cycles, timeoutControlCpuLimit in the monitor
+    quint64 m_controlTimeMaxInNs { 0 };
+    quint64 m_controlCycleCount { 0 };
+};
+
+#endif // QCPUSIMULATION_H
@@ -0,0 +1,31 @@
+#############################################################
+#                                                           #
+#                 Qt CPU LIMIT - Simulator                  #
+#                                                           #
+#  Runs the limiter against simulated workloads under a     #
+#  virtual clock and reports how well the limits are met.   #
+#                                                           #
+#############################################################
+
+QT = core
+
+TEMPLATE = app
+
+TARGET = QtCpuLimitSimulator
+
+CONFIG += console
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -Wall
+QMAKE_CXXFLAGS += -Wextra
+QMAKE_CXXFLAGS += -Werror
+CONFIG += c++17
+
+include(../QCpuCore.pri)
+
+HEADERS += \
+    QCpuSimulation.h
+
+SOURCES += \
+    main.cpp \
+    QCpuSimulation.cpp
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "QCpuSimulation.h"
+
+/**
+ * @brief main function
+ */
+int main(int argc, char** argv)
+{
+    //create Qt core application, only used to parse the arguments: the simulation has no event loop
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Qt CPU Limit Simulator");
+
+    //parse the arguments
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs the CPU limiter against simulated workloads under a virtual clock.");
+    parser.addHelpOption();
+
+    const QCommandLineOption processesOption("processes", "Number of simulated processes.", "count", "1000");
+    const QCommandLineOption durationOption("duration", "Virtual time to simulate, in seconds.", "seconds", "120");
+    const QCommandLineOption warmupOption("warmup", "Virtual time excluded from the report, in seconds.", "seconds", "10");
+    const QCommandLineOption limitOption("limit", "CPU limit of every process, in percent of one CPU.", "percent", "50");
+    const QCommandLineOption sourceOption("source", "Sampling source: stat or schedstat.", "source", "schedstat");
+    const QCommandLineOption softOption("soft", "Demote the processes before stopping them.");
+    const QCommandLineOption uncontendedOption("uncontended", "Simulate a system with idle CPUs.");
+    parser.addOptions({processesOption, durationOption, warmupOption, limitOption, sourceOption, softOption, uncontendedOption});
+    parser.process(app);
+
+    //create the settings
+    QCpuSimulationSettings settings;
+    settings.processCount      = std::max(parser.value(processesOption).toInt(), 1);
+    settings.durationInS       = std::max<quint64>(parser.value(durationOption).toULongLong(), 1);
+    settings.warmupInS         = std::min<quint64>(parser.value(warmupOption).toULongLong(), settings.durationInS - 1);
+    settings.cpuLimitInPercent = std::clamp(parser.value(limitOption).toDouble(), 1.0, 100.0) / 100.0;
+    settings.sampleSource      = parser.value(sourceOption) == "stat" ? QCpuSampleSource::StatTicks : QCpuSampleSource::SchedStat;
+    settings.softThrottling    = parser.isSet(softOption);
+    settings.systemContended   = !parser.isSet(uncontendedOption);
+
+    //run the simulation and print the report
+    QCpuSimulation simulation(settings);
+    simulation.run();
+
+    QTextStream out(stdout);
+    simulation.report(out);
+    return 0;
+}
@@ -0,0 +1,14 @@
+#############################################################
+#                                                           #
+#                 Qt CPU LIMIT - Tests                      #
+#                                                           #
+#  Run with "make check" from the build directory.          #
+#                                                           #
+#############################################################
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    fleet \
+    iolimit \
+    limiter
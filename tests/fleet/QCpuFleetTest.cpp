@@ -0,0 +1,566 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include <QtTest>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <memory>
+#include "QCpuFleetProtocol.h"
+#include "QCpuFleetAgent.h"
+#include "QCpuFleetAggregator.h"
+
+/**
+ * @brief c_fleetTestProcessCount constant, the processes of each host in the loopback test
+ */
+constexpr int c_fleetTestProcessCount = 5000;
+
+/**
+ * @brief c_fleetTestCpuCount constant, the CPUs of each host
+ */
+constexpr int c_fleetTestCpuCount = 4;
+
+/**
+ * @brief c_fleetTestActiveRatio constant, one process in c_fleetTestActiveRatio is running, the others sleep
+ */
+constexpr int c_fleetTestActiveRatio = 10;
+
+/**
+ * @brief c_fleetTestFrameCount constant, the frames measured by each bandwidth run of the loopback test
+ */
+constexpr int c_fleetTestFrameCount = 10;
+
+/**
+ * @brief c_fleetTestMaxBytesPerSecond constant, the bandwidth of an agent at the default refresh interval
+ */
+constexpr qint64 c_fleetTestMaxBytesPerSecond = 8 * 1024;
+
+/**
+ * @brief c_fleetTestTimeoutInMs constant, the time given to the aggregator to catch up with the agents
+ */
+constexpr int c_fleetTestTimeoutInMs = 10000;
+
+/**
+ * @brief QCpuFleetTestSource class, a source that sends the lists given by the test and records the commands
+ */
+class QCpuFleetTestSource final : public QCpuSource
+{
+    Q_OBJECT
+
+public:
+
+    std::shared_ptr<const QCpuStringPool> stringPool() const override { return m_stringPoolPtr; }
+
+    void publish(const QCpuProcessList& processList, const QCpuLoadList& cpuLoadList)
+    {
+        emit updateCpuLoadList(cpuLoadList);
+        emit updateProcessList(processList);
+    }
+
+    pid_t lastLimitedPid { 0 };
+    int lastCpuLimit { -1 };
+
+public slots:
+
+    void setProcessLimit(pid_t pid, int cpuLimit) override { lastLimitedPid = pid; lastCpuLimit = cpuLimit; }
+    void removeProcessLimit(pid_t) override {}
+    void setProcessIoLimit(pid_t, qint64) override {}
+    void removeProcessIoLimit(pid_t) override {}
+    void setSoftThrottling(bool) override {}
+    void setSampleSource(int) override {}
+    void setAutoProtection(bool) override {}
+    void setSubscription(int) override {}
+    void setRefreshInterval(int) override {}
+    void setExtendedStatistics(bool) override {}
+    void setDescendantLimit(int) override {}
+    void requestProcessMetadata(const PidList) override {}
+    void requestProcessStatistics(const PidList) override {}
+
+private:
+
+    std::shared_ptr<QCpuStringPool> m_stringPoolPtr { std::make_shared<QCpuStringPool>() };
+};
+
+/**
+ * @brief randomProcess, a process whose values are all on the grid of the wire format
+ */
+static QCpuProcess randomProcess(pid_t pid, QRandomGenerator& random)
+{
+    static const char c_states[] = "RSDTZ";
+
+    QCpuProcess process;
+    process.pid                    = pid;
+    process.cpuUsageInPercent      = random.bounded(4 * 10000) / c_fleetUsageScale;
+    process.usageSeeded            = random.bounded(4) != 0;
+    process.ioRateInBytesPerSecond = random.bounded(1 << 20) * 1024.0;
+    process.processor              = random.bounded(c_fleetTestCpuCount + 1) - 1;
+
+    //a third of the processes are limited
+    if (random.bounded(3) == 0)
+    {
+        process.cpuLimitInPercent = (1 + random.bounded(10000)) / c_fleetUsageScale;
+        process.autoLimited       = random.bounded(2) == 0;
+    }
+
+    if (random.bounded(5) == 0)
+    {
+        process.ioLimitInBytesPerSecond = static_cast<quint64>(random.bounded(1 << 30));
+    }
+
+    process.statCounters.state       = c_states[random.bounded(5)];
+    process.statCounters.threadCount = 1 + random.bounded(64);
+    process.statCounters.rssInBytes  = static_cast<quint64>(random.bounded(1 << 24)) * 1024;
+    process.statCounters.minorFaults = random.generate64() >> 20;
+    process.statCounters.majorFaults = random.bounded(1 << 16);
+    process.voluntaryContextSwitches   = random.generate64() >> 24;
+    process.involuntaryContextSwitches = random.bounded(1 << 20);
+    return process;
+}
+
+/**
+ * @brief randomProcessList, a list of processCount processes sorted by pid, up to the largest pid of the protocol
+ */
+static QCpuProcessList randomProcessList(int processCount, QRandomGenerator& random)
+{
+    QMap<pid_t, QCpuProcess> processMap;
+    while (processMap.size() < processCount)
+    {
+        const pid_t pid = 1 + static_cast<pid_t>(random.bounded(static_cast<quint32>(c_fleetHostPidMask)));
+        processMap.insert(pid, randomProcess(pid, random));
+    }
+
+    return processMap.values();
+}
+
+/**
+ * @brief evolveProcessList, the next snapshot: exits, new pids, changed values and cleared limits
+ */
+static QCpuProcessList evolveProcessList(const QCpuProcessList& processList, double churn, QRandomGenerator& random)
+{
+    QMap<pid_t, QCpuProcess> processMap;
+    const int threshold = static_cast<int>(churn * 1000);
+
+    for (QCpuProcess process : processList)
+    {
+        //exited
+        if (random.bounded(1000) < threshold)
+        {
+            continue;
+        }
+
+        //changed: one field at a time, the limits may be cleared
+        if (random.bounded(1000) < threshold * 4)
+        {
+            const QCpuProcess changed = randomProcess(process.pid, random);
+            switch (random.bounded(6))
+            {
+                case 0:
+                    process.cpuUsageInPercent = changed.cpuUsageInPercent;
+                    process.usageSeeded       = true;
+                    break;
+
+                case 1:
+                    process.cpuLimitInPercent = random.bounded(2) == 0 ? std::optional<double>() : changed.cpuLimitInPercent;
+                    process.autoLimited       = process.cpuLimitInPercent.has_value() && changed.autoLimited;
+                    break;
+
+                case 2:
+                    process.ioRateInBytesPerSecond  = changed.ioRateInBytesPerSecond;
+                    process.ioLimitInBytesPerSecond = random.bounded(2) == 0 ? std::optional<quint64>() : changed.ioLimitInBytesPerSecond;
+                    break;
+
+                case 3:
+                    process.processor = changed.processor;
+                    break;
+
+                case 4:
+                    process.statCounters = changed.statCounters;
+                    break;
+
+                default:
+                    process.voluntaryContextSwitches   = changed.voluntaryContextSwitches;
+                    process.involuntaryContextSwitches = changed.involuntaryContextSwitches;
+                    break;
+            }
+        }
+
+        processMap.insert(process.pid, process);
+    }
+
+    //new processes, the same count as the exited ones on average
+    const int newCount = static_cast<int>(processList.size() * churn);
+    for (int index = 0; index < newCount; ++index)
+    {
+        const pid_t pid = 1 + static_cast<pid_t>(random.bounded(static_cast<quint32>(c_fleetHostPidMask)));
+        if (!processMap.contains(pid))
+        {
+            processMap.insert(pid, randomProcess(pid, random));
+        }
+    }
+
+    return processMap.values();
+}
+
+/**
+ * @brief changeActiveUsage, every active process gets a new usage, the usage of a sleeping process doesn't change
+ */
+static void changeActiveUsage(QCpuProcessList& processList, QRandomGenerator& random)
+{
+    for (QCpuProcess& process : processList)
+    {
+        if (process.pid % c_fleetTestActiveRatio != 0)
+        {
+            continue;
+        }
+
+        //another value on the grid of the wire format
+        const int usage = static_cast<int>(std::lround(process.cpuUsageInPercent * c_fleetUsageScale));
+        process.cpuUsageInPercent = (usage + 1 + random.bounded(4 * 10000 - 1)) % (4 * 10000) / c_fleetUsageScale;
+        process.usageSeeded       = true;
+    }
+}
+
+/**
+ * @brief randomCpuLoadList, loads on the percent grid of the wire format
+ */
+static QCpuLoadList randomCpuLoadList(QRandomGenerator& random)
+{
+    QCpuLoadList cpuLoadList;
+    for (int cpu = 0; cpu < c_fleetTestCpuCount; ++cpu)
+    {
+        cpuLoadList.push_back(random.bounded(101) / 100.0);
+    }
+
+    return cpuLoadList;
+}
+
+/**
+ * @brief sameProcess, the fields carried by the samples frames, the processor relative to the host
+ */
+static bool sameProcess(const QCpuProcess& left, const QCpuProcess& right, int processorOffset = 0)
+{
+    const int processor = right.processor >= 0 ? right.processor - processorOffset : -1;
+    return left.pid == (right.pid & c_fleetHostPidMask) &&
+           left.cpuUsageInPercent == right.cpuUsageInPercent &&
+           left.usageSeeded == right.usageSeeded &&
+           left.cpuLimitInPercent == right.cpuLimitInPercent &&
+           left.autoLimited == right.autoLimited &&
+           left.ioRateInBytesPerSecond == right.ioRateInBytesPerSecond &&
+           left.ioLimitInBytesPerSecond == right.ioLimitInBytesPerSecond &&
+           left.processor == processor &&
+           left.statCounters == right.statCounters &&
+           left.voluntaryContextSwitches == right.voluntaryContextSwitches &&
+           left.involuntaryContextSwitches == right.involuntaryContextSwitches;
+}
+
+/**
+ * @brief decodeFrame, applies a frame written by QCpuFleetEncoder
+ */
+static bool decodeFrame(const QByteArray& frame, QMap<pid_t, QCpuProcess>& processMap, QCpuLoadList& cpuLoadList)
+{
+    QByteArray buffer = frame;
+    QCpuFleetFrameType type;
+    QByteArray payload;
+    bool error = false;
+    if (!QCpuFleetReader::takeFrame(buffer, type, payload, error) || error || !buffer.isEmpty() ||
+            type != QCpuFleetFrameType::Samples)
+    {
+        return false;
+    }
+
+    QCpuFleetReader reader(payload);
+    return QCpuFleetDecoder::decode(reader, processMap, cpuLoadList);
+}
+
+/**
+ * @brief QCpuFleetTest class
+ */
+class QCpuFleetTest final : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void initTestCase();
+    void roundTrip_data();
+    void roundTrip();
+    void rejectOutOfRangePid();
+    void loopback();
+};
+
+/**
+ * @brief QCpuFleetTest::initTestCase
+ */
+void QCpuFleetTest::initTestCase()
+{
+    //the types of the queued signals and invocations, like main.cpp
+    qRegisterMetaType<QCpuProcessList>("QCpuProcessList");
+    qRegisterMetaType<PidList>("PidList");
+    qRegisterMetaType<QCpuProcess>("QCpuProcess");
+    qRegisterMetaType<QCpuProcessMetadataList>("QCpuProcessMetadataList");
+    qRegisterMetaType<QCpuLoadList>("QCpuLoadList");
+    qRegisterMetaType<pid_t>("pid_t");
+}
+
+/**
+ * @brief QCpuFleetTest::roundTrip_data
+ */
+void QCpuFleetTest::roundTrip_data()
+{
+    QTest::addColumn<quint32>("seed");
+    QTest::addColumn<int>("processCount");
+    QTest::addColumn<double>("churn");
+
+    QTest::newRow("small, heavy churn") << 1u << 20 << 0.25;
+    QTest::newRow("medium") << 2u << 500 << 0.05;
+    QTest::newRow("large, steady") << 3u << c_fleetTestProcessCount << 0.01;
+    QTest::newRow("everything changes") << 4u << 200 << 1.0;
+}
+
+/**
+ * @brief QCpuFleetTest::roundTrip, the decoded processes match every snapshot, across resets
+ */
+void QCpuFleetTest::roundTrip()
+{
+    QFETCH(quint32, seed);
+    QFETCH(int, processCount);
+    QFETCH(double, churn);
+
+    QRandomGenerator random(seed);
+    QCpuFleetEncoder encoder;
+    QMap<pid_t, QCpuProcess> processMap;
+    QCpuLoadList decodedLoadList;
+
+    QCpuProcessList processList = randomProcessList(processCount, random);
+    for (int frameIndex = 0; frameIndex < 100; ++frameIndex)
+    {
+        //a reconnection: the aggregator starts over with a new host, the encoder sends every process
+        if (frameIndex % 37 == 36)
+        {
+            encoder.reset();
+            processMap.clear();
+        }
+
+        //an empty snapshot in between, the next one starts over
+        if (frameIndex % 50 == 25)
+        {
+            processList.clear();
+        }
+        else
+        {
+            processList = processList.isEmpty() ? randomProcessList(processCount, random) : evolveProcessList(processList, churn, random);
+        }
+
+        const QCpuLoadList cpuLoadList = randomCpuLoadList(random);
+
+        QVERIFY(decodeFrame(encoder.encode(processList, cpuLoadList), processMap, decodedLoadList));
+        QCOMPARE(decodedLoadList, cpuLoadList);
+        QCOMPARE(processMap.size(), processList.size());
+
+        for (const QCpuProcess& process : processList)
+        {
+            QVERIFY2(sameProcess(processMap.value(process.pid), process),
+                     qPrintable(QString("frame %1, pid %2").arg(frameIndex).arg(process.pid)));
+        }
+    }
+}
+
+/**
+ * @brief QCpuFleetTest::rejectOutOfRangePid, a pid would overlap the host index of the aggregator
+ */
+void QCpuFleetTest::rejectOutOfRangePid()
+{
+    //a changed process at 2^22
+    QCpuFleetWriter changedWriter;
+    changedWriter.writeVarint(0);                                       // CPUs
+    changedWriter.writeVarint(0);                                       // removed
+    changedWriter.writeVarint(1);                                       // changed
+    changedWriter.writeVarint(static_cast<quint64>(c_fleetHostPidMask) + 1);
+    changedWriter.writeByte(0);
+
+    QMap<pid_t, QCpuProcess> processMap;
+    QCpuLoadList cpuLoadList;
+    QVERIFY(!decodeFrame(changedWriter.frame(QCpuFleetFrameType::Samples), processMap, cpuLoadList));
+    QVERIFY(processMap.isEmpty());
+
+    //a removed process past the mask through the pid deltas
+    QCpuFleetWriter removedWriter;
+    removedWriter.writeVarint(0);
+    removedWriter.writeVarint(2);
+    removedWriter.writeVarint(static_cast<quint64>(c_fleetHostPidMask));
+    removedWriter.writeVarint(1);
+    removedWriter.writeVarint(0);
+    QVERIFY(!decodeFrame(removedWriter.frame(QCpuFleetFrameType::Samples), processMap, cpuLoadList));
+
+    //the largest pid is accepted
+    QCpuFleetWriter largestWriter;
+    largestWriter.writeVarint(0);
+    largestWriter.writeVarint(0);
+    largestWriter.writeVarint(1);
+    largestWriter.writeVarint(static_cast<quint64>(c_fleetHostPidMask));
+    largestWriter.writeByte(0);
+    QVERIFY(decodeFrame(largestWriter.frame(QCpuFleetFrameType::Samples), processMap, cpuLoadList));
+    QVERIFY(processMap.contains(c_fleetHostPidMask));
+}
+
+/**
+ * @brief QCpuFleetTest::loopback, two agents and one aggregator over a local socket
+ */
+void QCpuFleetTest::loopback()
+{
+    QRandomGenerator random(42);
+
+    //the aggregator
+    QCpuFleetAddress address;
+    QVERIFY(QCpuFleetAddress::parse(QString("unix:qtcpulimit-fleet-test-%1").arg(QCoreApplication::applicationPid()), address));
+
+    QCpuFleetAggregator aggregator;
+    QVERIFY(aggregator.listen(address));
+    aggregator.setRefreshInterval(c_minRefreshProcessListIntervalInMs);
+
+    QCpuProcessList mergedList;
+    connect(&aggregator, &QCpuSource::updateProcessList, this, [&mergedList](const QCpuProcessList processList)
+    {
+        mergedList = processList;
+    });
+
+    //the hosts
+    constexpr int c_hostCount = 2;
+    QCpuFleetTestSource sources[c_hostCount];
+    std::unique_ptr<QCpuFleetAgent> agentPtrs[c_hostCount];
+    QCpuProcessList processLists[c_hostCount];
+    QCpuLoadList cpuLoadLists[c_hostCount];
+    QCpuFleetEncoder encoders[c_hostCount];  // the agents' encoding, to measure the frame sizes
+
+    for (int host = 0; host < c_hostCount; ++host)
+    {
+        agentPtrs[host] = std::make_unique<QCpuFleetAgent>(&sources[host], address, QString("host%1").arg(host));
+        processLists[host] = randomProcessList(c_fleetTestProcessCount, random);
+        cpuLoadLists[host] = randomCpuLoadList(random);
+        encoders[host].encode(processLists[host], cpuLoadLists[host]);
+    }
+
+    //the merged list holds every process of every host: the pids are split by host, in host index order
+    const auto merged = [&mergedList, &processLists]() -> bool
+    {
+        QMap<int, QCpuProcessList> hostMap;
+        for (const QCpuProcess& process : mergedList)
+        {
+            hostMap[process.pid >> c_fleetHostPidBits].push_back(process);
+        }
+
+        if (hostMap.size() != c_hostCount)
+        {
+            return false;
+        }
+
+        //each host of the aggregator is one of the sources, its CPUs follow the previous hosts
+        int processorOffset = 0;
+        QSet<int> matchedSet;
+        for (const QCpuProcessList& hostList : hostMap)
+        {
+            bool matched = false;
+            for (int host = 0; host < c_hostCount && !matched; ++host)
+            {
+                matched = !matchedSet.contains(host) && hostList.size() == processLists[host].size() &&
+                          std::equal(hostList.cbegin(), hostList.cend(), processLists[host].cbegin(),
+                                     [processorOffset](const QCpuProcess & right, const QCpuProcess & left)
+                {
+                    return sameProcess(left, right, processorOffset);
+                });
+
+                if (matched)
+                {
+                    matchedSet.insert(host);
+                }
+            }
+
+            if (!matched)
+            {
+                return false;
+            }
+
+            processorOffset += c_fleetTestCpuCount;
+        }
+
+        return true;
+    };
+
+    //publish until the aggregator shows the last snapshots, a snapshot sent again costs an empty frame
+    const auto publishUntilMerged = [&]() -> bool
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < c_fleetTestTimeoutInMs)
+        {
+            for (int host = 0; host < c_hostCount; ++host)
+            {
+                sources[host].publish(processLists[host], cpuLoadLists[host]);
+            }
+
+            QTest::qWait(50);
+            if (merged())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    //(1) the first frames carry every process
+    QVERIFY(publishUntilMerged());
+
+    //(2) the steady frames carry the changes only, then every active process changes its usage in every frame
+    for (const bool activeUsage : {false, true})
+    {
+        qint64 frameBytes[c_hostCount] = {};
+        for (int step = 0; step < c_fleetTestFrameCount; ++step)
+        {
+            for (int host = 0; host < c_hostCount; ++host)
+            {
+                processLists[host] = evolveProcessList(processLists[host], 0.01, random);
+                if (activeUsage)
+                {
+                    changeActiveUsage(processLists[host], random);
+                }
+
+                cpuLoadLists[host] = randomCpuLoadList(random);
+                frameBytes[host] += encoders[host].encode(processLists[host], cpuLoadLists[host]).size();
+            }
+
+            QVERIFY(publishUntilMerged());
+        }
+
+        //an agent sends one frame per refresh of its monitor
+        for (int host = 0; host < c_hostCount; ++host)
+        {
+            const qint64 bytesPerSecond = frameBytes[host] / c_fleetTestFrameCount * 1000 / c_timerRefreshProcessListIntervalInMs;
+            qInfo("QCpuFleetTest::loopback: %s, processes per host: %d, bytes per second: %lld",
+                  activeUsage ? "active usage" : "steady", c_fleetTestProcessCount, bytesPerSecond);
+            QVERIFY2(bytesPerSecond <= c_fleetTestMaxBytesPerSecond,
+                     qPrintable(QString("host %1: %2 bytes per second").arg(host).arg(bytesPerSecond)));
+        }
+    }
+
+    //(3) a command reaches the host of the pid, unmasked
+    const QCpuProcess limited = mergedList.constFirst();
+    aggregator.setProcessLimit(limited.pid, 25);
+    QTRY_VERIFY_WITH_TIMEOUT(std::any_of(std::begin(sources), std::end(sources), [&limited](const QCpuFleetTestSource & source)
+    {
+        return source.lastLimitedPid == (limited.pid & c_fleetHostPidMask) && source.lastCpuLimit == 25;
+    }), c_fleetTestTimeoutInMs);
+
+    //(4) a host reconnects: the aggregator drops its processes, the new agent sends them all again
+    agentPtrs[0].reset();
+    processLists[0] = evolveProcessList(processLists[0], 0.1, random);
+    agentPtrs[0] = std::make_unique<QCpuFleetAgent>(&sources[0], address, QString("host0"));
+    QVERIFY(publishUntilMerged());
+}
+
+QTEST_GUILESS_MAIN(QCpuFleetTest)
+
+#include "QCpuFleetTest.moc"
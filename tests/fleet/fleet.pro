@@ -0,0 +1,36 @@
+#############################################################
+#                                                           #
+#                 Qt CPU LIMIT - Fleet tests                #
+#                                                           #
+#  Samples frames round trip and agents to aggregator       #
+#  loopback over a local socket.                            #
+#                                                           #
+#############################################################
+
+QT = core network testlib
+
+TEMPLATE = app
+
+TARGET = QCpuFleetTest
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -Wall
+QMAKE_CXXFLAGS += -Wextra
+QMAKE_CXXFLAGS += -Werror
+CONFIG += c++17
+
+include(../../QCpuCore.pri)
+
+HEADERS += \
+    ../../QCpuSource.h \
+    ../../QCpuFleetProtocol.h \
+    ../../QCpuFleetAgent.h \
+    ../../QCpuFleetAggregator.h
+
+SOURCES += \
+    QCpuFleetTest.cpp \
+    ../../QCpuFleetProtocol.cpp \
+    ../../QCpuFleetAgent.cpp \
+    ../../QCpuFleetAggregator.cpp
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include <QtTest>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cmath>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "QCpuLimitEngine.h"
+
+/**
+ * @brief c_ioTestLimitInBytesPerSecond constant, the I/O limit of the writer
+ */
+constexpr std::int64_t c_ioTestLimitInBytesPerSecond = 8 * 1024 * 1024;
+
+/**
+ * @brief c_ioTestTolerance constant, the measured rate must be within this fraction of the limit
+ */
+constexpr double c_ioTestTolerance = 0.25;
+
+/**
+ * @brief c_ioTestBlockSize constant, the size of each write of the writer
+ */
+constexpr int c_ioTestBlockSize = 1024 * 1024;
+
+/**
+ * @brief c_ioTestFileSize constant, the writer truncates its file at this size so that it keeps dirtying new pages
+ */
+constexpr off_t c_ioTestFileSize = 256 * 1024 * 1024;
+
+/**
+ * @brief runWriter, the body of the writer child: dd if=/dev/zero of=<path> bs=1M, forever
+ */
+[[noreturn]] static void runWriter(const QByteArray& path)
+{
+    const int fd = ::open(path.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        ::_exit(1);
+    }
+
+    static char block[c_ioTestBlockSize];
+    off_t size = 0;
+    for (;;)
+    {
+        if (::write(fd, block, sizeof(block)) != static_cast<ssize_t>(sizeof(block)))
+        {
+            ::_exit(2);
+        }
+
+        //the written pages are accounted when dirtied: start over on fresh pages
+        size += c_ioTestBlockSize;
+        if (size >= c_ioTestFileSize)
+        {
+            if (::ftruncate(fd, 0) != 0 || ::lseek(fd, 0, SEEK_SET) != 0)
+            {
+                ::_exit(3);
+            }
+
+            size = 0;
+        }
+    }
+}
+
+/**
+ * @brief readIoBytes, read_bytes + write_bytes of /proc/[pid]/io, like the limiter
+ */
+static bool readIoBytes(pid_t pid, quint64& ioBytes)
+{
+    QFile ioFile(QString("/proc/%1/io").arg(pid));
+    if (!ioFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    ioBytes = 0;
+    const QList<QByteArray> lineList = ioFile.readAll().split('\n');
+    for (const QByteArray& line : lineList)
+    {
+        if (line.startsWith("read_bytes:") || line.startsWith("write_bytes:"))
+        {
+            ioBytes += line.mid(line.indexOf(':') + 1).trimmed().toULongLong();
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief measureIoRate, the I/O rate of the process over the duration in bytes per second
+ */
+static double measureIoRate(pid_t pid, int durationInMs)
+{
+    quint64 startIoBytes = 0;
+    quint64 endIoBytes = 0;
+    QElapsedTimer timer;
+
+    if (!readIoBytes(pid, startIoBytes))
+    {
+        return -1;
+    }
+
+    timer.start();
+    QTest::qSleep(durationInMs);
+
+    if (!readIoBytes(pid, endIoBytes))
+    {
+        return -1;
+    }
+
+    return 1e9 * (endIoBytes - startIoBytes) / timer.nsecsElapsed();
+}
+
+/**
+ * @brief QCpuIoLimitWriter struct, kills and reaps the writer child whatever the outcome of the test
+ */
+struct QCpuIoLimitWriter
+{
+    pid_t pid { -1 };
+
+    ~QCpuIoLimitWriter()
+    {
+        if (pid > 0)
+        {
+            ::kill(pid, SIGKILL);
+            ::waitpid(pid, nullptr, 0);
+        }
+    }
+};
+
+/**
+ * @brief QCpuIoLimitTest class
+ */
+class QCpuIoLimitTest final : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void limitWriter();
+};
+
+/**
+ * @brief QCpuIoLimitTest::limitWriter, a dd-style writer is held within the tolerance of its I/O limit
+ */
+void QCpuIoLimitTest::limitWriter()
+{
+    //a tmpfs doesn't account the written pages: write next to the test binary
+    QTemporaryDir directory(QDir::current().filePath("iolimit-XXXXXX"));
+    QVERIFY(directory.isValid());
+    const QByteArray path = QFile::encodeName(directory.filePath("writer.bin"));
+
+    //fork the writer before the engine starts its thread
+    QCpuIoLimitWriter writer;
+    writer.pid = ::fork();
+    QVERIFY(writer.pid >= 0);
+    if (writer.pid == 0)
+    {
+        runWriter(path);
+    }
+
+    //without a limit, the writer must be well above the limit for the test to mean anything
+    const double freeIoRate = measureIoRate(writer.pid, 1000);
+    if (freeIoRate <= 0)
+    {
+        QSKIP("the file system of the build directory doesn't account the written bytes");
+    }
+
+    if (freeIoRate < 4.0 * c_ioTestLimitInBytesPerSecond)
+    {
+        QSKIP(qPrintable(QString("the storage is too slow: %1 MiB/s").arg(freeIoRate / (1024 * 1024), 0, 'f', 1)));
+    }
+
+    //limit the writer, the engine finds it at its first scan
+    QCpuLimitEngine engine;
+    QVERIFY(engine.start());
+    QTRY_VERIFY_WITH_TIMEOUT(engine.setProcessIoLimit(writer.pid, c_ioTestLimitInBytesPerSecond), 5000);
+
+    //let the smoothed rate settle, then measure
+    QTest::qSleep(3000);
+    const double limitedIoRate = measureIoRate(writer.pid, 6000);
+    engine.stop();
+
+    const double limitInMiBPerSecond = c_ioTestLimitInBytesPerSecond / (1024.0 * 1024.0);
+    const double rateInMiBPerSecond  = limitedIoRate / (1024.0 * 1024.0);
+    qInfo("QCpuIoLimitTest::limitWriter: free: %.1f MiB/s, limit: %.1f MiB/s, limited: %.2f MiB/s",
+          freeIoRate / (1024.0 * 1024.0), limitInMiBPerSecond, rateInMiBPerSecond);
+
+    QVERIFY2(std::abs(rateInMiBPerSecond - limitInMiBPerSecond) <= c_ioTestTolerance * limitInMiBPerSecond,
+             qPrintable(QString("limited rate %1 MiB/s, limit %2 MiB/s").arg(rateInMiBPerSecond).arg(limitInMiBPerSecond)));
+}
+
+QTEST_GUILESS_MAIN(QCpuIoLimitTest)
+
+#include "QCpuIoLimitTest.moc"
@@ -0,0 +1,33 @@
+#############################################################
+#                                                           #
+#                 Qt CPU LIMIT - I/O limit test             #
+#                                                           #
+#  Limits a writer child through QCpuLimitEngine and        #
+#  measures its storage I/O rate in /proc/[pid]/io.         #
+#                                                           #
+#############################################################
+
+QT = core testlib
+
+TEMPLATE = app
+
+TARGET = QCpuIoLimitTest
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -Wall
+QMAKE_CXXFLAGS += -Wextra
+QMAKE_CXXFLAGS += -Werror
+CONFIG += c++17
+
+include(../../QCpuCore.pri)
+
+INCLUDEPATH += ../../lib
+
+HEADERS += \
+    ../../lib/QCpuLimitEngine.h
+
+SOURCES += \
+    QCpuIoLimitTest.cpp \
+    ../../lib/QCpuLimitEngine.cpp
@@ -0,0 +1,611 @@
+/*
+ * Copyright (c) 2024 Malek Khlif
+ * Licensed under the MIT License
+ * Contact: <malek.khlif@outlook.com>
+ */
+
+#include <QtTest>
+#include <QCoreApplication>
+#include <algorithm>
+#include <iterator>
+#include "QCpuLimiter.h"
+
+/**
+ * @brief c_limiterTestPidBase constant, added to the pids of the fake tree: above any pid_max, never the pid of the test itself
+ */
+constexpr pid_t c_limiterTestPidBase = 4'194'304;
+
+/**
+ * @brief QCpuTestClock class, only moves when the test advances it
+ */
+class QCpuTestClock final : public QCpuClock
+{
+public:
+
+    quint64 monotonicInNs() const noexcept override { return m_nowInNs; }
+
+    void advanceInMs(quint64 durationInMs) noexcept { m_nowInNs += durationInMs * 1'000'000; }
+
+private:
+
+    quint64 m_nowInNs { 1'000'000'000 };
+};
+
+/**
+ * @brief QCpuTestSystem class, a process tree with real parents, changed by the test
+ *
+ * The simulator puts every process under init, it can't exercise the limit trees.
+ */
+class QCpuTestSystem final : public QCpuTimeSource, public QCpuSignalSink
+{
+public:
+
+    //a running pid is reused: the new process has another start time
+    void fork(pid_t pid, pid_t ppid)
+    {
+        m_ppidMap.insert(pid, ppid);
+        m_startTimeMap.insert(pid, ++m_startTimeInTicks);
+        m_eventList.push_back({pid, ppid});
+    }
+
+    void exec(pid_t pid, quint32 nameHash)
+    {
+        m_nameHashMap.insert(pid, nameHash);
+        m_eventList.push_back({pid, 0, QCpuProcessEventType::Exec});
+    }
+
+    void exit(pid_t pid)
+    {
+        //the kernel reparents the orphans to init
+        m_ppidMap.remove(pid);
+        for (auto ppidIt = m_ppidMap.begin(); ppidIt != m_ppidMap.end(); ++ppidIt)
+        {
+            if (ppidIt.value() == pid)
+            {
+                ppidIt.value() = c_limiterTestPidBase + 1;
+            }
+        }
+    }
+
+    bool eventsAvailable { true };  // false: no connector, the forks are only seen by the rescans
+    QCpuSystemStat systemStat;      // returned by readSystemStat, unreadable with 0 ticks
+    PidList continuedList;          // the processes resumed by the limiter
+
+    bool listProcesses(PidList& pidList) noexcept override
+    {
+        pidList = m_ppidMap.keys();
+        return true;
+    }
+
+    bool readProcessEvents(QCpuProcessEventList& eventList, int maxEventCount) noexcept override
+    {
+        if (!eventsAvailable)
+        {
+            m_eventList.clear();
+            return false;
+        }
+
+        const int count = std::min(maxEventCount, m_eventList.size());
+        std::copy(m_eventList.cbegin(), m_eventList.cbegin() + count, std::back_inserter(eventList));
+        m_eventList.erase(m_eventList.begin(), m_eventList.begin() + count);
+        return true;
+    }
+
+    bool readStat(pid_t pid, QCpuStatSample& sample) noexcept override
+    {
+        if (!m_ppidMap.contains(pid))
+        {
+            return false;
+        }
+
+        sample.ppid = m_ppidMap.value(pid);
+        sample.startTimeInTicks = m_startTimeMap.value(pid);
+        sample.nameHash = m_nameHashMap.value(pid);
+        return true;
+    }
+
+    bool readSchedStatCpuTime(pid_t pid, quint64& cpuTimeInNs) noexcept override
+    {
+        cpuTimeInNs = 0;
+        return m_ppidMap.contains(pid);
+    }
+
+    bool readIoBytes(pid_t, quint64&) noexcept override { return false; }
+    bool readContextSwitches(pid_t, quint64&, quint64&) noexcept override { return false; }
+
+    bool readSystemStat(QCpuSystemStat& stat) noexcept override
+    {
+        stat = systemStat;
+        return stat.totalTicks != 0;
+    }
+
+    void stopProcess(pid_t) noexcept override {}
+    void continueProcess(pid_t pid) noexcept override { continuedList.push_back(pid); }
+    bool demoteProcess(pid_t, QCpuProcessColdState&) noexcept override { return true; }
+    void restoreProcess(pid_t, const QCpuProcessColdState&) noexcept override {}
+
+private:
+
+    QHash<pid_t, pid_t> m_ppidMap;      // pid -> ppid of the running processes
+    QHash<pid_t, quint64> m_startTimeMap;
+    QHash<pid_t, quint32> m_nameHashMap;
+    quint64 m_startTimeInTicks { 0 };
+    QCpuProcessEventList m_eventList;   // forks and execs not read yet
+};
+
+/**
+ * @brief QCpuLimiterFixture struct, a limiter over the test system, with a shell running make and an editor:
+ *
+ *     100 shell
+ *     ├── 101 make
+ *     │   ├── 102 cc
+ *     │   └── 103 cc
+ *     └── 104 editor
+ */
+struct QCpuLimiterFixture
+{
+    QCpuProcessTable processTable;
+    QCpuTestClock clock;
+    QCpuTestSystem system;
+    QCpuLimiter limiter { processTable, clock, system, system };
+
+    explicit QCpuLimiterFixture(QCpuDescendantLimit descendantLimit)
+    {
+        limiter.setDescendantLimit(descendantLimit);
+
+        fork(1, 0);
+        fork(100, 1);
+        fork(101, 100);
+        fork(102, 101);
+        fork(103, 101);
+        fork(104, 100);
+        rescan();
+    }
+
+    void fork(pid_t pid, pid_t ppid)
+    {
+        system.fork(c_limiterTestPidBase + pid, c_limiterTestPidBase + ppid);
+    }
+
+    void exit(pid_t pid)
+    {
+        system.exit(c_limiterTestPidBase + pid);
+    }
+
+    bool scanEvents()
+    {
+        return limiter.scanProcessEvents();
+    }
+
+    void exec(pid_t pid, quint32 nameHash)
+    {
+        system.exec(c_limiterTestPidBase + pid, nameHash);
+    }
+
+    //the processes whose metadata changed
+    PidList rescan()
+    {
+        PidList removedList;
+        PidList changedList;
+        limiter.scanRunningProcesses(removedList, changedList);
+        return changedList;
+    }
+
+    void setLimit(pid_t pid, double cpuLimitInPercent)
+    {
+        limiter.applyTreeLimit(processTable.indexOf(c_limiterTestPidBase + pid), cpuLimitInPercent);
+    }
+
+    void removeLimit(pid_t pid)
+    {
+        limiter.clearTreeLimit(processTable.indexOf(c_limiterTestPidBase + pid));
+    }
+
+    //-1 without a limit, -2 when the process is unknown
+    double limit(pid_t pid) const
+    {
+        const int index = processTable.indexOf(c_limiterTestPidBase + pid);
+        return index < 0 ? -2.0 : processTable.hot(index).cpuLimitInPercent.value_or(-1.0);
+    }
+
+    int treeId(pid_t pid) const
+    {
+        const int index = processTable.indexOf(c_limiterTestPidBase + pid);
+        return index < 0 ? -1 : processTable.cold(index).limitTreeId;
+    }
+};
+
+/**
+ * @brief QCpuLimiterTest class
+ */
+class QCpuLimiterTest final : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void inheritLimit();
+    void shareLimit();
+    void shareFloor();
+    void nearestRootWins();
+    void treeOutlivesRoot();
+    void switchPolicy();
+    void childBetweenRescans();
+    void childWithoutEvents();
+    void systemContention();
+    void releaseLimitedOnly();
+    void reusedPid();
+    void execChangesMetadata();
+};
+
+/**
+ * @brief QCpuLimiterTest::inheritLimit, every descendant gets the limit of the root, the rest of the tree doesn't
+ */
+void QCpuLimiterTest::inheritLimit()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::Inherit);
+    fixture.setLimit(101, 0.4);
+
+    QCOMPARE(fixture.limit(101), 0.4);
+    QCOMPARE(fixture.limit(102), 0.4);
+    QCOMPARE(fixture.limit(103), 0.4);
+    QCOMPARE(fixture.limit(100), -1.0);
+    QCOMPARE(fixture.limit(104), -1.0);
+    QCOMPARE(fixture.treeId(102), fixture.treeId(101));
+
+    //a new budget reaches every member
+    fixture.setLimit(101, 0.2);
+    QCOMPARE(fixture.limit(102), 0.2);
+    QCOMPARE(fixture.limit(103), 0.2);
+
+    //removing the limit of the root releases the tree
+    fixture.removeLimit(101);
+    QCOMPARE(fixture.limit(101), -1.0);
+    QCOMPARE(fixture.limit(102), -1.0);
+    QCOMPARE(fixture.limit(103), -1.0);
+    QCOMPARE(fixture.treeId(102), 0);
+}
+
+/**
+ * @brief QCpuLimiterTest::shareLimit, the root and its descendants split the budget as the tree grows and shrinks
+ */
+void QCpuLimiterTest::shareLimit()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::Share);
+    fixture.setLimit(101, 0.3);
+
+    QCOMPARE(fixture.limit(101), 0.1);
+    QCOMPARE(fixture.limit(102), 0.1);
+    QCOMPARE(fixture.limit(103), 0.1);
+    QCOMPARE(fixture.limit(104), -1.0);
+
+    //a grandchild joins: four shares
+    fixture.fork(105, 102);
+    QVERIFY(fixture.scanEvents());
+    QCOMPARE(fixture.limit(105), 0.075);
+    QCOMPARE(fixture.limit(101), 0.075);
+
+    //a member exits: three shares again
+    fixture.exit(103);
+    fixture.rescan();
+    QCOMPARE(fixture.limit(103), -2.0);
+    QCOMPARE(fixture.limit(101), 0.1);
+    QCOMPARE(fixture.limit(105), 0.1);
+}
+
+/**
+ * @brief QCpuLimiterTest::shareFloor, a share never goes below c_minTreeShareInPercent, unless the budget does
+ */
+void QCpuLimiterTest::shareFloor()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::Share);
+    for (pid_t pid = 200; pid < 230; ++pid)
+    {
+        fixture.fork(pid, 104);
+    }
+
+    fixture.rescan();
+
+    //31 processes: 0.3 / 31 would be below the floor
+    fixture.setLimit(104, 0.3);
+    QCOMPARE(fixture.limit(104), c_minTreeShareInPercent);
+    QCOMPARE(fixture.limit(229), c_minTreeShareInPercent);
+
+    //a budget below the floor is the share of every member, like the limit of a single process
+    fixture.setLimit(104, 0.01);
+    QCOMPARE(fixture.limit(104), 0.01);
+    QCOMPARE(fixture.limit(200), 0.01);
+
+    //a budget of 0 stays 0
+    fixture.setLimit(104, 0.0);
+    QCOMPARE(fixture.limit(104), 0.0);
+    QCOMPARE(fixture.limit(215), 0.0);
+
+    //above the floor, the budget is split evenly
+    fixture.setLimit(104, 0.93);
+    QCOMPARE(fixture.limit(104), 0.03);
+    QCOMPARE(fixture.limit(200), 0.03);
+}
+
+/**
+ * @brief QCpuLimiterTest::nearestRootWins, a limited descendant keeps its subtree whatever the order of the limits
+ */
+void QCpuLimiterTest::nearestRootWins()
+{
+    //the ancestor first
+    {
+        QCpuLimiterFixture fixture(QCpuDescendantLimit::Inherit);
+        fixture.setLimit(100, 0.5);
+        fixture.setLimit(101, 0.2);
+
+        QCOMPARE(fixture.limit(100), 0.5);
+        QCOMPARE(fixture.limit(104), 0.5);
+        QCOMPARE(fixture.limit(101), 0.2);
+        QCOMPARE(fixture.limit(102), 0.2);
+        QCOMPARE(fixture.limit(103), 0.2);
+        QVERIFY(fixture.treeId(102) != fixture.treeId(104));
+
+        //a new child of the nearer root joins it
+        fixture.fork(105, 103);
+        fixture.scanEvents();
+        QCOMPARE(fixture.limit(105), 0.2);
+
+        //the nearer limit is removed: its subtree falls back to the farther root
+        fixture.removeLimit(101);
+        QCOMPARE(fixture.limit(101), 0.5);
+        QCOMPARE(fixture.limit(102), 0.5);
+        QCOMPARE(fixture.limit(105), 0.5);
+        QCOMPARE(fixture.treeId(105), fixture.treeId(100));
+    }
+
+    //the descendant first
+    {
+        QCpuLimiterFixture fixture(QCpuDescendantLimit::Share);
+        fixture.setLimit(101, 0.3);
+        fixture.setLimit(100, 0.2);
+
+        QCOMPARE(fixture.limit(101), 0.1);
+        QCOMPARE(fixture.limit(102), 0.1);
+        QCOMPARE(fixture.limit(100), 0.1);
+        QCOMPARE(fixture.limit(104), 0.1);
+    }
+}
+
+/**
+ * @brief QCpuLimiterTest::treeOutlivesRoot, the members keep the budget once the root exited
+ */
+void QCpuLimiterTest::treeOutlivesRoot()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::Share);
+    fixture.setLimit(100, 0.5);
+    QCOMPARE(fixture.limit(104), 0.1);
+
+    const int treeId = fixture.treeId(100);
+
+    //the shell exits, make and the editor are reparented to init
+    fixture.exit(100);
+    fixture.rescan();
+    QCOMPARE(fixture.limit(100), -2.0);
+    QCOMPARE(fixture.treeId(101), treeId);
+    QCOMPARE(fixture.treeId(104), treeId);
+    QCOMPARE(fixture.limit(101), 0.125);
+    QCOMPARE(fixture.limit(104), 0.125);
+
+    //the members keep adding to the tree
+    fixture.fork(105, 104);
+    QVERIFY(fixture.scanEvents());
+    QCOMPARE(fixture.treeId(105), treeId);
+    QCOMPARE(fixture.limit(105), 0.1);
+
+    //init is not a member: its other children stay free
+    fixture.fork(106, 1);
+    QVERIFY(!fixture.scanEvents());
+    fixture.rescan();
+    QCOMPARE(fixture.limit(106), -1.0);
+}
+
+/**
+ * @brief QCpuLimiterTest::switchPolicy, None -> Inherit -> Share -> None -> Share
+ */
+void QCpuLimiterTest::switchPolicy()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::None);
+    fixture.setLimit(101, 0.3);
+    QCOMPARE(fixture.limit(101), 0.3);
+    QCOMPARE(fixture.limit(102), -1.0);
+
+    //the existing limit becomes a root
+    fixture.limiter.setDescendantLimit(QCpuDescendantLimit::Inherit);
+    QCOMPARE(fixture.limit(101), 0.3);
+    QCOMPARE(fixture.limit(102), 0.3);
+    QCOMPARE(fixture.limit(103), 0.3);
+
+    fixture.limiter.setDescendantLimit(QCpuDescendantLimit::Share);
+    QCOMPARE(fixture.limit(101), 0.1);
+    QCOMPARE(fixture.limit(102), 0.1);
+
+    //back to the process only: the root gets its whole budget, the descendants are released
+    fixture.limiter.setDescendantLimit(QCpuDescendantLimit::None);
+    QCOMPARE(fixture.limit(101), 0.3);
+    QCOMPARE(fixture.limit(102), -1.0);
+    QCOMPARE(fixture.limit(103), -1.0);
+    QCOMPARE(fixture.treeId(101), 0);
+
+    //no tree: a new child stays free
+    fixture.fork(105, 101);
+    QVERIFY(!fixture.scanEvents());
+
+    fixture.limiter.setDescendantLimit(QCpuDescendantLimit::Share);
+    fixture.rescan();
+    QCOMPARE(fixture.limit(101), 0.075);
+    QCOMPARE(fixture.limit(105), 0.075);
+}
+
+/**
+ * @brief QCpuLimiterTest::childBetweenRescans, the forks under a tree are limited before the next rescan, a bounded number per call
+ */
+void QCpuLimiterTest::childBetweenRescans()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::Inherit);
+    fixture.setLimit(101, 0.3);
+
+    //a child and a grandchild under the tree, a child outside of it
+    fixture.fork(105, 103);
+    fixture.fork(106, 105);
+    fixture.fork(107, 104);
+    QVERIFY(fixture.scanEvents());
+    QCOMPARE(fixture.limit(105), 0.3);
+    QCOMPARE(fixture.limit(106), 0.3);
+    QCOMPARE(fixture.limit(107), -2.0);
+
+    //the other processes are found by the rescan
+    fixture.rescan();
+    QCOMPARE(fixture.limit(107), -1.0);
+
+    //a fork bomb: the events beyond the budget wait for the next call
+    for (int childIndex = 0; childIndex < c_maxProcessEventsPerScan + 10; ++childIndex)
+    {
+        fixture.fork(1000 + childIndex, 102);
+    }
+
+    QVERIFY(fixture.scanEvents());
+    QCOMPARE(fixture.limit(1000 + c_maxProcessEventsPerScan - 1), 0.3);
+    QCOMPARE(fixture.limit(1000 + c_maxProcessEventsPerScan), -2.0);
+
+    QVERIFY(fixture.scanEvents());
+    QCOMPARE(fixture.limit(1000 + c_maxProcessEventsPerScan + 9), 0.3);
+}
+
+/**
+ * @brief QCpuLimiterTest::childWithoutEvents, without the fork events the children join their tree at the rescan
+ */
+void QCpuLimiterTest::childWithoutEvents()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::Inherit);
+    fixture.system.eventsAvailable = false;
+    fixture.setLimit(101, 0.3);
+
+    fixture.fork(105, 102);
+    QVERIFY(!fixture.scanEvents());
+    QCOMPARE(fixture.limit(105), -2.0);
+
+    fixture.rescan();
+    QCOMPARE(fixture.limit(105), 0.3);
+}
+
+/**
+ * @brief QCpuLimiterTest::systemContention, busy CPUs or waiting threads contend the system, an unreadable stat changes nothing
+ */
+void QCpuLimiterTest::systemContention()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::None);
+    QCpuSystemStat& stat = fixture.system.systemStat;
+    stat.cpuCount = 2;
+    stat.runningProcesses = 1;
+
+    //the first read has nothing to compare with
+    stat.totalTicks = 1000;
+    stat.idleTicks = 500;
+    stat.cpuTotalTicks = {500, 500};
+    stat.cpuIdleTicks = {250, 250};
+    fixture.limiter.scanSystemLoad();
+    QVERIFY(fixture.limiter.systemContended());
+
+    //half busy, one running thread per CPU
+    stat.totalTicks = 2000;
+    stat.idleTicks = 1000;
+    stat.cpuTotalTicks = {1000, 1000};
+    stat.cpuIdleTicks = {250, 750};
+    stat.runningProcesses = 3;
+    fixture.limiter.scanSystemLoad();
+    QVERIFY(!fixture.limiter.systemContended());
+    QCOMPARE(fixture.limiter.cpuLoadList().size(), 2);
+    QCOMPARE(fixture.limiter.cpuLoadList().at(0), 1.0);
+    QCOMPARE(fixture.limiter.cpuLoadList().at(1), 0.0);
+
+    //a thread is waiting for a CPU
+    stat.totalTicks = 3000;
+    stat.idleTicks = 1500;
+    stat.runningProcesses = 4;
+    fixture.limiter.scanSystemLoad();
+    QVERIFY(fixture.limiter.systemContended());
+
+    //saturated CPUs
+    stat.totalTicks = 4000;
+    stat.idleTicks = 1510;
+    stat.runningProcesses = 1;
+    fixture.limiter.scanSystemLoad();
+    QVERIFY(fixture.limiter.systemContended());
+
+    //an unreadable stat keeps the last state
+    stat = QCpuSystemStat();
+    fixture.limiter.scanSystemLoad();
+    QVERIFY(fixture.limiter.systemContended());
+}
+
+/**
+ * @brief QCpuLimiterTest::releaseLimitedOnly, the limiter only resumes the processes it limited
+ */
+void QCpuLimiterTest::releaseLimitedOnly()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::Inherit);
+    fixture.setLimit(101, 0.4);
+    fixture.system.continuedList.clear();
+
+    //the processes stopped by someone else stay stopped
+    fixture.limiter.releaseLimitedProcesses();
+    PidList continuedList = fixture.system.continuedList;
+    std::sort(continuedList.begin(), continuedList.end());
+    QCOMPARE(continuedList, PidList({c_limiterTestPidBase + 101, c_limiterTestPidBase + 102, c_limiterTestPidBase + 103}));
+}
+
+/**
+ * @brief QCpuLimiterTest::reusedPid, a pid reused between two rescans is a new process, without the limit of the old one
+ */
+void QCpuLimiterTest::reusedPid()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::Inherit);
+    fixture.setLimit(101, 0.3);
+    const int treeId = fixture.treeId(101);
+
+    //make exits, the editor forks a process that gets its pid
+    fixture.exit(101);
+    fixture.fork(101, 104);
+    QVERIFY(!fixture.scanEvents());
+    QCOMPARE(fixture.limit(101), 0.3);
+
+    //the rescan tells them apart by their start time
+    QCOMPARE(fixture.rescan(), PidList({c_limiterTestPidBase + 101}));
+    QCOMPARE(fixture.limit(101), -1.0);
+    QCOMPARE(fixture.treeId(101), 0);
+    QCOMPARE(fixture.treeId(102), treeId);
+    QCOMPARE(fixture.limit(102), 0.3);
+
+    QCOMPARE(fixture.rescan(), PidList());
+}
+
+/**
+ * @brief QCpuLimiterTest::execChangesMetadata, an exec is reported by the next rescan, from the event or from the new name
+ */
+void QCpuLimiterTest::execChangesMetadata()
+{
+    QCpuLimiterFixture fixture(QCpuDescendantLimit::Inherit);
+    fixture.setLimit(101, 0.3);
+
+    //the event reports an exec that keeps the name, the process keeps its limit
+    fixture.exec(101, 0);
+    QVERIFY(!fixture.scanEvents());
+    QCOMPARE(fixture.rescan(), PidList({c_limiterTestPidBase + 101}));
+    QCOMPARE(fixture.limit(101), 0.3);
+    QCOMPARE(fixture.rescan(), PidList());
+
+    //without the events, the new name tells the exec
+    fixture.system.eventsAvailable = false;
+    fixture.exec(104, 1);
+    QCOMPARE(fixture.rescan(), PidList({c_limiterTestPidBase + 104}));
+    QCOMPARE(fixture.rescan(), PidList());
+}
+
+QTEST_GUILESS_MAIN(QCpuLimiterTest)
+
+#include "QCpuLimiterTest.moc"
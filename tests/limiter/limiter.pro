@@ -0,0 +1,27 @@
+#############################################################
+#                                                           #
+#                 Qt CPU LIMIT - Limiter test               #
+#                                                           #
+#  Runs the limit trees of QCpuLimiter against a fake       #
+#  process tree, no process is signalled.                   #
+#                                                           #
+#############################################################
+
+QT = core testlib
+
+TEMPLATE = app
+
+TARGET = QCpuLimiterTest
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -Wall
+QMAKE_CXXFLAGS += -Wextra
+QMAKE_CXXFLAGS += -Werror
+CONFIG += c++17
+
+include(../../QCpuCore.pri)
+
+SOURCES += \
+    QCpuLimiterTest.cpp